@@ -1,40 +1,73 @@
 #include <stdio.h>
 #include <gel.h>
 
+/* Scripts are cached only when GEL_CACHE_DIR names a directory for them,
+   where each one is named after the checksum of its absolute path */
+static gchar* gel_cache_filename(const gchar *filename)
+{
+    const gchar *cache_dir = g_getenv("GEL_CACHE_DIR");
+    if(cache_dir == NULL || *cache_dir == 0)
+        return NULL;
+    if(g_mkdir_with_parents(cache_dir, 0700) != 0)
+        return NULL;
+
+    gchar *path = NULL;
+    if(g_path_is_absolute(filename))
+        path = g_strdup(filename);
+    else
+    {
+        gchar *current_dir = g_get_current_dir();
+        path = g_build_filename(current_dir, filename, NULL);
+        g_free(current_dir);
+    }
+
+    gchar *checksum =
+        g_compute_checksum_for_string(G_CHECKSUM_SHA256, path, -1);
+    gchar *name = g_strconcat(checksum, ".gelc", NULL);
+    gchar *cache_filename = g_build_filename(cache_dir, name, NULL);
+    g_free(name);
+    g_free(checksum);
+    g_free(path);
+
+    return cache_filename;
+}
+
 int main(int argc, char *argv[])
 {
     const gchar *filename = NULL;
     gboolean interactive = FALSE;
     gboolean active = FALSE;
-    gchar *text = NULL;
 
     g_type_init();
     GelParser *parser = gel_parser_new();
     GelContext *context = gel_context_new();
 
-    if(argc > 1)
+    if(argc > 1 && g_strcmp0(argv[1], "-") != 0)
     {
         filename = argv[1];
-        gsize text_len = 0;
+        gchar *cache_filename = gel_cache_filename(filename);
         GError *read_error = NULL;
-        if(g_file_get_contents(filename, &text, &text_len, &read_error))
-        {
-            gel_parser_input_text(parser, text, text_len);
+        gboolean read = cache_filename != NULL
+            ? gel_parser_input_cached_file(parser, filename, cache_filename,
+                                           &read_error)
+            : gel_parser_input_mapped_file(parser, filename, &read_error);
+        if(read)
             active = TRUE;
-        }
         else
         {
             g_print("Error reading '%s'\n", filename);
             g_print("%s\n", read_error->message);
             g_error_free(read_error);
         }
+        g_free(cache_filename);
     }
     else
     {
-        g_print("Entering Gel in interactive mode\n");
+        interactive = argc == 1;
+        if(interactive)
+            g_print("Entering Gel in interactive mode\n");
         gel_parser_input_file(parser, fileno(stdin));
         filename = "<stdin>";
-        interactive = TRUE;
         active = TRUE;
     }
 
@@ -88,8 +121,6 @@ int main(int argc, char *argv[])
                 active = FALSE;
     }
 
-    if(text != NULL)
-        g_free(text);
     gel_parser_free(parser);
     gel_context_free(context);
 
@@ -6,6 +6,8 @@
 #include <gelvalue.h>
 #include <gelclosure.h>
 #include <gelarray.h>
+#include <gelhash.h>
+#include <gelwriter.h>
 
 #endif
 
@@ -0,0 +1,498 @@
+#include <string.h>
+
+#include <gelcache.h>
+#include <gelarray.h>
+#include <gelsymbol.h>
+#include <gelvalue.h>
+#include <gelvalueprivate.h>
+
+
+/*
+ * A cache keeps the values obtained by parsing a source file, after
+ * expanding its macros, so they can be loaded without parsing it again.
+ *
+ * The file starts with a header holding the format version, a byte order
+ * mark, the SHA-256 of the source and the SHA-256 of the rest of the file,
+ * followed by the top level values and the macros defined by the source,
+ * in the order they were parsed. A macro is an 'm' followed by the value
+ * of its definition, to register it again when the cache is read.
+ * Each value is a tag char followed by its content:
+ *  'i' and 'd': a gint64 or a gdouble
+ *  's', 'y' and 'p': the length and chars of a string, symbol
+ *                    or predefined value name, ending with a zero
+ *  'Y': the index of a symbol already stored with 'y', by order
+ *  'a': the number of values of an array, followed by them
+ * Lengths are guint32, and everything is in the byte order of the writer.
+ * Arrays are nested at most CACHE_MAX_DEPTH levels, so that a damaged file
+ * cannot exhaust the stack while it is checked.
+ *
+ * If the cache is valid for the source its values can be read,
+ * otherwise the values parsed from the source are added to be saved.
+ */
+
+#define CACHE_MAGIC "GELC"
+#define CACHE_VERSION 2
+#define CACHE_BYTE_ORDER 0x01020304
+#define CACHE_HASH_LEN 64
+#define CACHE_CHECKSUM_OFFSET (4 + 4 + 4 + CACHE_HASH_LEN)
+#define CACHE_HEADER_LEN (CACHE_CHECKSUM_OFFSET + CACHE_HASH_LEN)
+#define CACHE_MAX_DEPTH 1024
+
+typedef struct _GelCacheSymbol GelCacheSymbol;
+
+struct _GelCacheSymbol
+{
+    const gchar *name;
+    GelVariable *variable;
+};
+
+struct _GelCache
+{
+    gchar *filename;
+    gchar *hash;
+
+    GMappedFile *mapped;
+    const gchar *next;
+    const gchar *end;
+    GArray *symbols;
+
+    GString *data;
+    GHashTable *indexes;
+};
+
+/* predefined values that the parser adds to the code */
+static
+const gchar *cache_predefined[] = {"array", "hash", "quote", NULL};
+
+
+static
+gboolean gel_cache_read_len(const gchar **text, const gchar *end,
+                            guint32 *len)
+{
+    if(end - *text < (gssize)sizeof(guint32))
+        return FALSE;
+
+    memcpy(len, *text, sizeof(guint32));
+    *text += sizeof(guint32);
+    return TRUE;
+}
+
+
+static
+gboolean gel_cache_check_string(const gchar **text, const gchar *end)
+{
+    guint32 len;
+    if(!gel_cache_read_len(text, end, &len))
+        return FALSE;
+
+    if((gsize)(end - *text) <= len || (*text)[len] != 0)
+        return FALSE;
+
+    *text += len + 1;
+    return TRUE;
+}
+
+
+/* Checks that a well formed value starts at *@text, and skips it */
+static
+gboolean gel_cache_check_value(const gchar **text, const gchar *end,
+                               guint32 *n_symbols, guint depth)
+{
+    if(*text == end || depth > CACHE_MAX_DEPTH)
+        return FALSE;
+
+    gchar tag = *(*text)++;
+    switch(tag)
+    {
+        case 'i':
+        case 'd':
+            if(end - *text < 8)
+                return FALSE;
+            *text += 8;
+            return TRUE;
+        case 's':
+            return gel_cache_check_string(text, end);
+        case 'y':
+            (*n_symbols)++;
+            return gel_cache_check_string(text, end);
+        case 'Y':
+        {
+            guint32 index;
+            return gel_cache_read_len(text, end, &index) &&
+                index < *n_symbols;
+        }
+        case 'p':
+        {
+            const gchar *name = *text + sizeof(guint32);
+            return gel_cache_check_string(text, end) &&
+                gel_value_lookup_predefined(name) != NULL;
+        }
+        case 'a':
+        {
+            guint32 n_values;
+            if(!gel_cache_read_len(text, end, &n_values))
+                return FALSE;
+
+            for(guint32 i = 0; i < n_values; i++)
+                if(!gel_cache_check_value(text, end, n_symbols, depth + 1))
+                    return FALSE;
+            return TRUE;
+        }
+        default:
+            return FALSE;
+    }
+}
+
+
+static
+gboolean gel_cache_open(GelCache *self)
+{
+    self->mapped = g_mapped_file_new(self->filename, FALSE, NULL);
+    if(self->mapped == NULL)
+        return FALSE;
+
+    const gchar *text = g_mapped_file_get_contents(self->mapped);
+    const gchar *end = text + g_mapped_file_get_length(self->mapped);
+
+    guint32 version;
+    guint32 byte_order;
+    if(end - text < CACHE_HEADER_LEN || memcmp(text, CACHE_MAGIC, 4) != 0)
+        return FALSE;
+
+    memcpy(&version, text + 4, sizeof(guint32));
+    memcpy(&byte_order, text + 8, sizeof(guint32));
+    if(version != CACHE_VERSION || byte_order != CACHE_BYTE_ORDER ||
+       memcmp(text + 12, self->hash, CACHE_HASH_LEN) != 0)
+        return FALSE;
+
+    /* the structure alone would not notice a changed number or string */
+    gchar *checksum = g_compute_checksum_for_data(G_CHECKSUM_SHA256,
+        (const guchar *)text + CACHE_HEADER_LEN,
+        end - text - CACHE_HEADER_LEN);
+    gboolean intact = memcmp(text + CACHE_CHECKSUM_OFFSET,
+        checksum, CACHE_HASH_LEN) == 0;
+    g_free(checksum);
+    if(!intact)
+        return FALSE;
+
+    guint32 n_symbols = 0;
+    text += CACHE_HEADER_LEN;
+    for(const gchar *iter = text; iter < end;)
+    {
+        /* only the definition of a macro can follow its tag */
+        if(*iter == 'm' && (++iter == end || *iter != 'a'))
+            return FALSE;
+        if(!gel_cache_check_value(&iter, end, &n_symbols, 0))
+            return FALSE;
+    }
+
+    self->next = text;
+    self->end = end;
+    self->symbols = g_array_sized_new(
+        FALSE, FALSE, sizeof(GelCacheSymbol), n_symbols);
+    return TRUE;
+}
+
+
+/*
+ * Creates a cache stored in @filename for the text @source.
+ * If the file holds the values of @source the cache is valid,
+ * otherwise it is ready to add them.
+ */
+GelCache* gel_cache_new(const gchar *filename,
+                        const gchar *source, gsize source_len)
+{
+    GelCache *self = g_slice_new0(GelCache);
+    self->filename = g_strdup(filename);
+    self->hash = g_compute_checksum_for_data(
+        G_CHECKSUM_SHA256, (const guchar *)source, source_len);
+
+    if(!gel_cache_open(self))
+    {
+        if(self->mapped != NULL)
+        {
+            g_mapped_file_unref(self->mapped);
+            self->mapped = NULL;
+        }
+
+        self->indexes = g_hash_table_new(g_direct_hash, g_direct_equal);
+        self->data = g_string_new(CACHE_MAGIC);
+        guint32 header[2] = {CACHE_VERSION, CACHE_BYTE_ORDER};
+        g_string_append_len(self->data, (gchar *)header, sizeof(header));
+        g_string_append_len(self->data, self->hash, CACHE_HASH_LEN);
+
+        /* the checksum of the values is filled when saving */
+        g_string_set_size(self->data, CACHE_HEADER_LEN);
+    }
+
+    return self;
+}
+
+
+void gel_cache_free(GelCache *self)
+{
+    if(self->mapped != NULL)
+        g_mapped_file_unref(self->mapped);
+    if(self->symbols != NULL)
+        g_array_unref(self->symbols);
+    if(self->data != NULL)
+        g_string_free(self->data, TRUE);
+    if(self->indexes != NULL)
+        g_hash_table_unref(self->indexes);
+    g_free(self->hash);
+    g_free(self->filename);
+    g_slice_free(GelCache, self);
+}
+
+
+gboolean gel_cache_is_valid(const GelCache *self)
+{
+    return self->mapped != NULL;
+}
+
+
+static
+const gchar* gel_cache_read_string(GelCache *self)
+{
+    guint32 len;
+    memcpy(&len, self->next, sizeof(guint32));
+
+    const gchar *string = self->next + sizeof(guint32);
+    self->next = string + len + 1;
+    return string;
+}
+
+
+static
+void gel_cache_read_value(GelCache *self, GValue *value)
+{
+    gchar tag = *self->next++;
+    switch(tag)
+    {
+        case 'i':
+        {
+            gint64 v_int64;
+            memcpy(&v_int64, self->next, 8);
+            self->next += 8;
+            g_value_init(value, G_TYPE_INT64);
+            g_value_set_int64(value, v_int64);
+            break;
+        }
+        case 'd':
+        {
+            gdouble v_double;
+            memcpy(&v_double, self->next, 8);
+            self->next += 8;
+            g_value_init(value, G_TYPE_DOUBLE);
+            g_value_set_double(value, v_double);
+            break;
+        }
+        case 's':
+            g_value_init(value, G_TYPE_STRING);
+            g_value_set_string(value, gel_cache_read_string(self));
+            break;
+        case 'y':
+        case 'Y':
+        {
+            GelCacheSymbol symbol;
+            if(tag == 'y')
+            {
+                symbol.name = gel_cache_read_string(self);
+                symbol.variable = gel_variable_lookup_predefined(symbol.name);
+                g_array_append_val(self->symbols, symbol);
+            }
+            else
+            {
+                guint32 index;
+                memcpy(&index, self->next, sizeof(guint32));
+                self->next += sizeof(guint32);
+                symbol = g_array_index(self->symbols, GelCacheSymbol, index);
+            }
+
+            g_value_init(value, GEL_TYPE_SYMBOL);
+            g_value_take_boxed(value,
+                gel_symbol_new(symbol.name, symbol.variable));
+            break;
+        }
+        case 'p':
+        {
+            const gchar *name = gel_cache_read_string(self);
+            gel_value_copy(gel_value_lookup_predefined(name), value);
+            break;
+        }
+        case 'a':
+        {
+            guint32 n_values;
+            memcpy(&n_values, self->next, sizeof(guint32));
+            self->next += sizeof(guint32);
+
+            GelArray *array = gel_array_new(n_values);
+            gel_array_set_n_values(array, n_values);
+
+            GValue *values = gel_array_get_values(array);
+            for(guint32 i = 0; i < n_values; i++)
+                gel_cache_read_value(self, values + i);
+
+            g_value_init(value, GEL_TYPE_ARRAY);
+            g_value_take_boxed(value, array);
+            break;
+        }
+    }
+}
+
+
+/*
+ * Reads the next value of a valid cache into @value,
+ * setting @is_macro if it is the definition of a macro.
+ */
+gboolean gel_cache_next_value(GelCache *self, GValue *value,
+                              gboolean *is_macro)
+{
+    if(self->next == self->end)
+        return FALSE;
+
+    *is_macro = (*self->next == 'm');
+    if(*is_macro)
+        self->next++;
+
+    gel_cache_read_value(self, value);
+    return TRUE;
+}
+
+
+static
+void gel_cache_write_string(GString *data, gchar tag, const gchar *string)
+{
+    guint32 len = strlen(string);
+    g_string_append_c(data, tag);
+    g_string_append_len(data, (gchar *)&len, sizeof(guint32));
+    g_string_append_len(data, string, len + 1);
+}
+
+
+static
+gboolean gel_cache_write_value(GString *data, GHashTable *indexes,
+                               const GValue *value, guint depth)
+{
+    GType type = G_VALUE_TYPE(value);
+
+    if(type == G_TYPE_INT64)
+    {
+        gint64 v_int64 = g_value_get_int64(value);
+        g_string_append_c(data, 'i');
+        g_string_append_len(data, (gchar *)&v_int64, 8);
+    }
+    else
+    if(type == G_TYPE_DOUBLE)
+    {
+        gdouble v_double = g_value_get_double(value);
+        g_string_append_c(data, 'd');
+        g_string_append_len(data, (gchar *)&v_double, 8);
+    }
+    else
+    if(type == G_TYPE_STRING)
+        gel_cache_write_string(data, 's', g_value_get_string(value));
+    else
+    if(type == GEL_TYPE_SYMBOL)
+    {
+        const GelSymbol *symbol = g_value_get_boxed(value);
+        const gchar *name = gel_symbol_get_name(symbol);
+        guint index = GPOINTER_TO_UINT(g_hash_table_lookup(indexes, name));
+        if(index == 0)
+        {
+            index = g_hash_table_size(indexes) + 1;
+            g_hash_table_insert(indexes, (gchar *)name, GUINT_TO_POINTER(index));
+            gel_cache_write_string(data, 'y', name);
+        }
+        else
+        {
+            guint32 stored_index = index - 1;
+            g_string_append_c(data, 'Y');
+            g_string_append_len(data, (gchar *)&stored_index, sizeof(guint32));
+        }
+    }
+    else
+    if(type == GEL_TYPE_ARRAY)
+    {
+        const GelArray *array = g_value_get_boxed(value);
+        const GValue *values = gel_array_get_values(array);
+        guint32 n_values = gel_array_get_n_values(array);
+
+        if(depth >= CACHE_MAX_DEPTH)
+            return FALSE;
+
+        g_string_append_c(data, 'a');
+        g_string_append_len(data, (gchar *)&n_values, sizeof(guint32));
+        for(guint32 i = 0; i < n_values; i++)
+            if(!gel_cache_write_value(data, indexes, values + i, depth + 1))
+                return FALSE;
+    }
+    else
+    {
+        gpointer pointer = g_value_fits_pointer(value) ?
+            g_value_peek_pointer(value) : NULL;
+
+        for(guint i = 0; pointer != NULL && cache_predefined[i] != NULL; i++)
+        {
+            const gchar *name = cache_predefined[i];
+            const GValue *predefined = gel_value_lookup_predefined(name);
+            if(predefined != NULL && G_VALUE_TYPE(predefined) == type &&
+               g_value_peek_pointer(predefined) == pointer)
+            {
+                gel_cache_write_string(data, 'p', name);
+                return TRUE;
+            }
+        }
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/*
+ * Adds a value parsed from the source to a cache that is not valid.
+ * If the value cannot be stored the cache will not be saved.
+ */
+void gel_cache_add(GelCache *self, const GValue *value)
+{
+    if(self->data == NULL)
+        return;
+
+    if(!gel_cache_write_value(self->data, self->indexes, value, 0))
+    {
+        g_string_free(self->data, TRUE);
+        self->data = NULL;
+    }
+}
+
+
+/*
+ * Adds the @definition of a macro, the array starting with the symbol
+ * macro, to a cache that is not valid, so it is defined again on reading.
+ */
+void gel_cache_add_macro(GelCache *self, const GValue *definition)
+{
+    if(self->data == NULL)
+        return;
+
+    g_string_append_c(self->data, 'm');
+    gel_cache_add(self, definition);
+}
+
+
+/* Saves the values added to the cache */
+gboolean gel_cache_save(GelCache *self, GError **error)
+{
+    if(self->data == NULL)
+        return FALSE;
+
+    gchar *checksum = g_compute_checksum_for_data(G_CHECKSUM_SHA256,
+        (const guchar *)self->data->str + CACHE_HEADER_LEN,
+        self->data->len - CACHE_HEADER_LEN);
+    memcpy(self->data->str + CACHE_CHECKSUM_OFFSET, checksum, CACHE_HASH_LEN);
+    g_free(checksum);
+
+    return g_file_set_contents(self->filename,
+        self->data->str, self->data->len, error);
+}
@@ -0,0 +1,20 @@
+#ifndef __GEL_CACHE_H__
+#define __GEL_CACHE_H__
+
+#include <glib-object.h>
+
+typedef struct _GelCache GelCache;
+
+GelCache* gel_cache_new(const gchar *filename,
+                        const gchar *source, gsize source_len);
+void gel_cache_free(GelCache *self);
+
+gboolean gel_cache_is_valid(const GelCache *self);
+gboolean gel_cache_next_value(GelCache *self, GValue *value,
+                              gboolean *is_macro);
+
+void gel_cache_add(GelCache *self, const GValue *value);
+void gel_cache_add_macro(GelCache *self, const GValue *definition);
+gboolean gel_cache_save(GelCache *self, GError **error);
+
+#endif
@@ -8,6 +8,7 @@
 #include <gelvalueprivate.h>
 #include <gelsymbol.h>
 #include <gelerrors.h>
+#include <gelcode.h>
 
 #ifdef HAVE_GOBJECT_INTROSPECTION
 #include <geltypeinfo.h>
@@ -36,22 +37,38 @@ struct _GelClosure
     GClosure closure;
     GelContext *context;
     gchar *name;
-    GList *args;
-    gchar *variadic_arg;
-    GHashTable *args_hash;
+    guint n_args;
+    const gchar **args;
+    gboolean is_variadic;
     GelArray *code;
+    GelCode *body;
+    const gchar **captured;
 };
 
 
 static
-void gel_closure_marshal(GelClosure *self, GValue *return_value,
-                         guint n_values, const GValue *values,
-                         GelContext *invocation_context)
+void gel_closure_eval_arg(GelContext *context, const GValue *values,
+                          GelCode *const *codes, guint index, GValue *dest)
 {
-    invocation_context = gel_context_validate(invocation_context);
+    if(codes != NULL)
+    {
+        const GValue *value = gel_code_eval(codes[index], context, dest);
+        if(value != dest && G_IS_VALUE(value))
+            gel_value_copy(value, dest);
+    }
+    else
+        gel_context_eval_value(context, values + index, dest);
+}
 
-    const guint n_args = g_list_length(self->args);
-    gboolean is_variadic = (self->variadic_arg != NULL);
+
+static
+GelContext* gel_closure_new_frame_for(GelClosure *self,
+                                      guint n_values, const GValue *values,
+                                      GelCode *const *codes,
+                                      GelContext *invocation_context)
+{
+    const guint n_args = self->n_args;
+    gboolean is_variadic = self->is_variadic;
 
     if(is_variadic)
     {
@@ -61,7 +78,7 @@ void gel_closure_marshal(GelClosure *self, GValue *return_value,
                 "at least %u arguments, got %u", n_args, n_values);
             gel_error_expected(invocation_context, self->name, message);
             g_free(message);
-            return;
+            return NULL;
         }
     }
     else
@@ -71,26 +88,28 @@ void gel_closure_marshal(GelClosure *self, GValue *return_value,
             "%u arguments, got %u", n_args, n_values);
         gel_error_expected(invocation_context, self->name, message);
         g_free(message);
-        return;
+        return NULL;
     }
 
-    GelContext *context = gel_context_new_with_outer(self->context);
+    const guint n_slots = is_variadic ? n_args + 1 : n_args;
+    GelContext *context =
+        gel_context_new_frame(self->context, n_slots, self->args);
 
     guint i = 0;
-    for(GList *iter = self->args; iter != NULL; iter = iter->next, i++)
+    for(; i < n_args; i++)
     {
-        const gchar *arg_name = iter->data;
         GValue *value = gel_value_new();
 
-        gel_context_eval_value(invocation_context, values + i, value);
+        gel_closure_eval_arg(invocation_context, values, codes, i, value);
 
         if(gel_context_error(invocation_context))
         {
             g_free(value);
-            goto end;
+            gel_context_free(context);
+            return NULL;
         }
         else
-            gel_context_define_value(context, arg_name, value);
+            gel_context_define_slot(context, i, value);
     }
 
     if(is_variadic)
@@ -103,47 +122,218 @@ void gel_closure_marshal(GelClosure *self, GValue *return_value,
 
         for(guint j = 0; i < n_values; i++, j++)
         {
-            gel_context_eval_value(invocation_context,
-                values + i, array_values + j);
+            gel_closure_eval_arg(invocation_context,
+                values, codes, i, array_values + j);
 
             if(gel_context_error(invocation_context))
             {
                 gel_array_free(array);
-                goto end;
+                gel_context_free(context);
+                return NULL;
             }
         }
 
         GValue *value = gel_value_new_from_boxed(GEL_TYPE_ARRAY, array);
-        gel_context_define_value(context, self->variadic_arg, value);
+        gel_context_define_slot(context, n_args, value);
     }
 
-    guint code_n_values = gel_array_get_n_values(self->code);
-    if(code_n_values > 0)
-    {
-        guint last = code_n_values - 1;
-        const GValue *code_values = gel_array_get_values(self->code);
+    return context;
+}
+
+
+/*
+ * The body is compiled when the closure is first invoked. Closures running
+ * in several threads may be invoked for the first time at once, so then
+ * the body is compiled by the first one holding the lock of the runtime.
+ */
+static
+void gel_closure_compile(GelClosure *self)
+{
+    gboolean locked = gel_context_lock(self->context);
+
+    if(self->body == NULL)
+        g_atomic_pointer_set(&self->body, gel_code_new_block(
+            gel_array_get_n_values(self->code),
+            gel_array_get_values(self->code),
+            self->is_variadic ? self->n_args + 1 : self->n_args,
+            self->args, self->context));
+
+    gel_context_unlock(self->context, locked);
+}
+
+
+#define GEL_CLOSURE_KEPT_FRAMES 16
 
-        for(guint i = 0; i <= last; i++)
+
+/* Frees the frames whose closures were released since they were kept */
+static
+GSList* gel_closure_release_frames(GSList *frames, guint *n_frames)
+{
+    GSList *kept = NULL;
+    *n_frames = 0;
+
+    for(GSList *iter = frames; iter != NULL; iter = iter->next)
+        if(gel_context_inner_are_owned(iter->data))
+            gel_context_free(iter->data);
+        else
         {
-            GValue tmp_value = {0};
-            const GValue *value = gel_context_eval_into_value(context,
-                    code_values + i, &tmp_value);
+            kept = g_slist_prepend(kept, iter->data);
+            (*n_frames)++;
+        }
+
+    g_slist_free(frames);
+    return kept;
+}
+
 
-            if(gel_context_error(context))
-                goto end;
+static
+void gel_closure_run(GelClosure *self, GelContext *context,
+                     GValue *return_value, GelContext *invocation_context)
+{
+    GelClosure *closure = self;
+    GClosure *tail_closure = NULL;
+    GSList *kept_frames = NULL;
+    guint n_kept_frames = 0;
+    guint max_kept_frames = GEL_CLOSURE_KEPT_FRAMES;
+    gboolean running = TRUE;
+
+    /*
+     * Calls in tail position are returned by the body instead of performed,
+     * then the closure called replaces the current one and its frame
+     * replaces the current frame, so a chain of tail calls runs
+     * in constant stack.
+     * A frame where a closure was created may still be needed to look up
+     * the variables defined after the closure, so it lives until the
+     * chain returns, as it would do if the call was not in tail position,
+     * or until no closure other than its own variables needs it.
+     */
+    while(running)
+    {
+        if(g_atomic_pointer_get(&closure->body) == NULL)
+            gel_closure_compile(closure);
 
-            if(i == last && return_value != NULL && G_IS_VALUE(value))
-                gel_value_copy(value, return_value);
+        GelCodeCall tail_call;
+        GValue tmp_value = {0};
+        const GValue *value =
+            gel_code_eval_tail(closure->body, context, &tmp_value, &tail_call);
 
-            if(G_IS_VALUE(&tmp_value))
-                g_value_unset(&tmp_value);
+        if(tail_call.closure != NULL)
+        {
+            if(gel_context_inner_are_owned(context))
+                gel_context_free(context);
+            else
+            {
+                kept_frames = g_slist_prepend(kept_frames, context);
+                n_kept_frames++;
+            }
+
+            /* the time spent releasing frames is linear in the calls */
+            if(n_kept_frames >= max_kept_frames)
+            {
+                kept_frames =
+                    gel_closure_release_frames(kept_frames, &n_kept_frames);
+                max_kept_frames =
+                    MAX(GEL_CLOSURE_KEPT_FRAMES, 2 * n_kept_frames);
+            }
+            if(tail_closure != NULL)
+                g_closure_unref(tail_closure);
+
+            tail_closure = tail_call.closure;
+            closure = (GelClosure *)tail_closure;
+            context = tail_call.frame;
+        }
+        else
+        {
+            if(!gel_context_error(context))
+                if(return_value != NULL && G_IS_VALUE(value))
+                    gel_value_copy(value, return_value);
+            running = FALSE;
         }
+
+        if(G_IS_VALUE(&tmp_value))
+            g_value_unset(&tmp_value);
     }
 
-    end:
     if(gel_context_error(context))
         gel_context_transfer_error(context, invocation_context);
-    gel_context_free(context);  
+    gel_context_free(context);
+
+    g_slist_free_full(kept_frames, (GDestroyNotify)gel_context_free);
+
+    if(tail_closure != NULL)
+        g_closure_unref(tail_closure);
+}
+
+
+static
+void gel_closure_invoke_values(GelClosure *self, GValue *return_value,
+                               guint n_values, const GValue *values,
+                               GelCode *const *codes,
+                               GelContext *invocation_context)
+{
+    GelContext *context = gel_closure_new_frame_for(self,
+        n_values, values, codes, invocation_context);
+
+    if(context != NULL)
+        gel_closure_run(self, context, return_value, invocation_context);
+}
+
+
+static
+void gel_closure_marshal(GelClosure *self, GValue *return_value,
+                         guint n_values, const GValue *values,
+                         GelContext *invocation_context)
+{
+    if(gel_context_is_valid(invocation_context))
+        gel_closure_invoke_values(self, return_value,
+            n_values, values, NULL, invocation_context);
+    else
+    {
+        /* invoked as a signal handler */
+        GelContext *context = gel_context_new_with_outer(self->context);
+        gel_closure_invoke_values(self, return_value,
+            n_values, values, NULL, context);
+        gel_context_warn_error(context);
+        gel_context_free(context);
+    }
+}
+
+
+gboolean gel_closure_is_gel(const GClosure *closure)
+{
+    return closure->marshal == (GClosureMarshal)gel_closure_marshal;
+}
+
+
+GelContext* gel_closure_get_context(const GClosure *closure)
+{
+    g_return_val_if_fail(gel_closure_is_gel(closure), NULL);
+
+    return ((const GelClosure *)closure)->context;
+}
+
+
+void gel_closure_call(GClosure *closure, GValue *return_value,
+                      guint n_codes, GelCode *const *codes,
+                      GelContext *invocation_context)
+{
+    g_return_if_fail(gel_closure_is_gel(closure));
+
+    g_closure_ref(closure);
+    gel_closure_invoke_values((GelClosure *)closure, return_value,
+        n_codes, NULL, codes, invocation_context);
+    g_closure_unref(closure);
+}
+
+
+GelContext* gel_closure_new_frame(GClosure *closure,
+                                  guint n_codes, GelCode *const *codes,
+                                  GelContext *invocation_context)
+{
+    g_return_val_if_fail(gel_closure_is_gel(closure), NULL);
+
+    return gel_closure_new_frame_for((GelClosure *)closure,
+        n_codes, NULL, codes, invocation_context);
 }
 
 
@@ -151,23 +341,56 @@ static
 void gel_closure_finalize(void *data, GelClosure *self)
 {
     g_free(self->name);
-    g_list_foreach(self->args, (GFunc)g_free, NULL);
-    g_list_free(self->args);
+    g_free(self->args);
 
-    if(self->variadic_arg != NULL)
-        g_free(self->variadic_arg);
-
-    g_hash_table_unref(self->args_hash);
+    if(self->body != NULL)
+        gel_code_free(self->body);
     gel_array_free(self->code);
     gel_context_free(self->context);
+    g_free(self->captured);
+}
+
+
+static
+gboolean gel_closure_has_arg(const GelClosure *self, const gchar *name)
+{
+    for(const gchar **arg = self->args; *arg != NULL; arg++)
+        if(*arg == name)
+            return TRUE;
+
+    return FALSE;
 }
 
 
+/*
+ * A variable of the outermost context can be redefined later,
+ * so it is not captured but resolved when the closure is invoked.
+ */
 static
-void gel_closure_bind_symbols_of_array(GelClosure *self, GelArray *array)
+GelVariable* gel_closure_lookup_captured(const GelContext *context,
+                                         const gchar *name)
+{
+    for(; gel_context_get_outer(context) != NULL;
+            context = gel_context_get_outer(context))
+    {
+        GelVariable *variable = gel_context_get_interned(context, name);
+        if(variable != NULL)
+            return variable;
+    }
+
+    return NULL;
+}
+
+
+static
+void gel_closure_collect_captured(const GelClosure *self,
+                                  const GelArray *array,
+                                  const GelContext *context,
+                                  GPtrArray *names, GPtrArray *variables,
+                                  gboolean *unresolved)
 {
     guint array_n_values = gel_array_get_n_values(array);
-    GValue *array_values = gel_array_get_values(array);
+    const GValue *array_values = gel_array_get_values(array);
 
     for(guint i = 0; i < array_n_values; i++)
     {
@@ -175,33 +398,68 @@ void gel_closure_bind_symbols_of_array(GelClosure *self, GelArray *array)
         GType type = G_VALUE_TYPE(value);
 
         if(type == GEL_TYPE_ARRAY)
-        {
-            GelArray *array = g_value_get_boxed(value);
-            gel_closure_bind_symbols_of_array(self, array);
-        }
+            gel_closure_collect_captured(self,
+                g_value_get_boxed(value), context, names, variables,
+                unresolved);
         else
         if(type == GEL_TYPE_SYMBOL)
         {
-            GelSymbol *symbol = g_value_get_boxed(value);
-            const gchar *name = gel_symbol_get_name(symbol);
-            const GelContext *context = self->context;
-
-            if(g_hash_table_lookup(self->args_hash, name) == NULL)
+            const gchar *name = gel_symbol_get_name(g_value_get_boxed(value));
+            if(gel_closure_has_arg(self, name))
+                continue;
+
+            guint j = 0;
+            while(j < names->len && g_ptr_array_index(names, j) != name)
+                j++;
+            if(j < names->len)
+                continue;
+
+            GelVariable *variable = gel_closure_lookup_captured(context, name);
+            if(variable != NULL)
             {
-                GelVariable *variable =
-                    gel_context_lookup_variable(context, name);
-                if(variable != NULL)
-                    gel_symbol_set_variable(symbol, variable);
+                g_ptr_array_add(names, (void *)name);
+                g_ptr_array_add(variables, variable);
             }
+            else
+            if(gel_context_lookup_interned(context, name) == NULL
+                && gel_variable_lookup_predefined(name) == NULL)
+                *unresolved = TRUE;
         }
     }
 }
 
 
-void gel_closure_close_over(GClosure *closure)
+/*
+ * The closure keeps the variables its code references from the contexts
+ * where it is created, as the slots of a context whose outer context
+ * is the one where it is created, to find the variables defined later.
+ * When every name of the code is found, the closure keeps no context
+ * but the outermost one, so the frames it is created in can go away
+ * as soon as their code has run.
+ */
+static
+void gel_closure_capture(GelClosure *self, GelContext *context)
 {
-    GelClosure *self = (GelClosure *)closure;
-    gel_closure_bind_symbols_of_array(self, self->code);
+    GPtrArray *names = g_ptr_array_new();
+    GPtrArray *variables = g_ptr_array_new();
+    gboolean unresolved = FALSE;
+
+    gel_closure_collect_captured(self,
+        self->code, context, names, variables, &unresolved);
+
+    if(!unresolved)
+        while(gel_context_get_outer(context) != NULL)
+            context = gel_context_get_outer(context);
+
+    guint n_captured = names->len;
+    self->captured = (const gchar **)g_ptr_array_free(names, FALSE);
+    self->context = gel_context_new_frame(context, n_captured, self->captured);
+
+    for(guint i = 0; i < n_captured; i++)
+        gel_context_bind_slot(self->context,
+            i, g_ptr_array_index(variables, i));
+
+    g_ptr_array_free(variables, TRUE);
 }
 
 
@@ -236,32 +494,32 @@ GClosure* gel_closure_new(const gchar *name, GList *args, gchar *variadic,
         NULL, (GClosureNotify)gel_closure_finalize);
 
     GelClosure *self = (GelClosure*)closure;
-    GHashTable *args_hash = g_hash_table_new(g_str_hash, g_str_equal);
+    const guint n_args = g_list_length(args);
+    const gchar **args_array = g_new(const gchar *, n_args + 2);
 
-    for(GList *iter = args; iter != NULL; iter = iter->next)
-    {
-        const gchar *arg = iter->data;
-        g_hash_table_insert(args_hash, (void *)arg, (void *)arg);
-    }
-    
-    if(variadic != NULL)
-        g_hash_table_insert(args_hash, (void *)variadic, (void *)variadic);
+    guint i = 0;
+    for(GList *iter = args; iter != NULL; iter = iter->next, i++)
+        args_array[i] = g_intern_string(iter->data);
+    args_array[i++] = variadic != NULL ? g_intern_string(variadic) : NULL;
+    args_array[i] = NULL;
 
-    GelContext *closure_context = gel_context_copy(context);
-    gel_context_set_outer(closure_context, context);
+    g_list_foreach(args, (GFunc)g_free, NULL);
+    g_list_free(args);
+    g_free(variadic);
 
+    /* copying an array or a symbol only takes a reference */
     GelArray *code = gel_array_new(n_values);
     for(guint i = 0; i < n_values; i++)
         gel_array_append(code, values + i);
 
-    static guint counter = 0;
-
-    self->name = name ? g_strdup(name) : g_strdup_printf("lambda%u", counter++);
-    self->args = args;
-    self->variadic_arg = variadic;
-    self->args_hash = args_hash;
+    self->name = name ? g_strdup(name) :
+        g_strdup_printf("lambda%u", gel_context_next_lambda_id(context));
+    self->n_args = n_args;
+    self->args = args_array;
+    self->is_variadic = (variadic != NULL);
     self->code = code;
-    self->context = closure_context;
+    self->body = NULL;
+    gel_closure_capture(self, context);
 
     g_closure_ref(closure);
     g_closure_sink(closure);
@@ -285,9 +543,21 @@ void gel_native_closure_marshal(GClosure *closure, GValue *return_value,
                                 guint n_values, const GValue *values,
                                 GelContext *context)
 {
-    ((GelNativeClosure *)closure)->native_marshal(
-        closure, return_value, n_values, values,
-        gel_context_validate(context), closure->data);
+    GClosureMarshal native_marshal =
+        ((GelNativeClosure *)closure)->native_marshal;
+
+    if(gel_context_is_valid(context))
+        native_marshal(closure, return_value, n_values, values,
+            context, closure->data);
+    else
+    {
+        /* invoked as a signal handler */
+        GelContext *signal_context = gel_context_new();
+        native_marshal(closure, return_value, n_values, values,
+            signal_context, closure->data);
+        gel_context_warn_error(signal_context);
+        gel_context_free(signal_context);
+    }
 }
 
 
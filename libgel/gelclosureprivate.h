@@ -2,10 +2,19 @@
 #define __GEL_CLOSURE_PRIVATE_H__
 
 #include <gelcontext.h>
+#include <gelcode.h>
 
 typedef struct _GelClosure GelClosure;
 
-void gel_closure_close_over(GClosure *closure);
+gboolean gel_closure_is_gel(const GClosure *closure);
+GelContext* gel_closure_get_context(const GClosure *closure);
+
+void gel_closure_call(GClosure *closure, GValue *return_value,
+                      guint n_codes, GelCode *const *codes,
+                      GelContext *invocation_context);
+GelContext* gel_closure_new_frame(GClosure *closure,
+                                  guint n_codes, GelCode *const *codes,
+                                  GelContext *invocation_context);
 
 #ifdef HAVE_GOBJECT_INTROSPECTION
 #include <geltypeinfo.h>
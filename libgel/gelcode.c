@@ -0,0 +1,849 @@
+#include <gelcode.h>
+#include <gelcontextprivate.h>
+#include <gelclosureprivate.h>
+#include <gelvalue.h>
+#include <gelvalueprivate.h>
+#include <gelsymbol.h>
+
+
+/*
+ * A GelCode is the compiled form of a value.
+ * Code is compiled once (when a closure is first invoked, or when a
+ * top-level value is evaluated) so that evaluating it again does not need
+ * to dispatch on the type of each value nor to look up the head of the
+ * forms that are handled directly by the interpreter loop.
+ *
+ * Predefined functions receive their arguments without evaluating,
+ * so only the arguments of calls to closures written in gel are compiled.
+ *
+ * Symbols in the body of a closure are resolved when the body is compiled.
+ * Arguments become slots of the frame where the closure is invoked,
+ * addressed by the number of loops between the symbol and the frame,
+ * and the variables captured by the closure are kept by the code.
+ *
+ * A call whose head is a symbol that is resolved at run time to a variable
+ * of the outermost context remembers the variable, together with that
+ * context and the version of the bindings of the interpreter at that moment.
+ * The contexts between the frame and the outermost one are checked every
+ * time, since the same call runs in frames that may bind the name or not.
+ * As long as no name resolved this way is defined, removed or released
+ * again in an outermost context, the version does not change and the call
+ * skips the lookup there.
+ * The variable is not referenced by the cache, because the version changes
+ * before it can be released, and because the variable of a recursive
+ * closure would keep the code of the closure alive.
+ * While the interpreter runs closures in several threads the caches are
+ * only read, a call whose cache is stale looks its head up every time.
+ */
+
+typedef enum _GelCodeType
+{
+    GEL_CODE_LITERAL,
+    GEL_CODE_SYMBOL,
+    GEL_CODE_SLOT,
+    GEL_CODE_CAPTURED,
+    GEL_CODE_CALL,
+    GEL_CODE_IF,
+    GEL_CODE_DO,
+    GEL_CODE_AND,
+    GEL_CODE_OR,
+    GEL_CODE_WHILE,
+    GEL_CODE_COND,
+    GEL_CODE_CASE,
+    GEL_CODE_LET
+} GelCodeType;
+
+
+struct _GelCode
+{
+    GelCodeType type;
+    const GValue *value;
+    const gchar *name;
+    guint depth;
+    guint slot;
+    GelVariable *variable;
+    const GelVariable *cached;
+    const GelContext *outermost;
+    guint version;
+    guint n_codes;
+    GelCode *codes[];
+};
+
+
+typedef struct _GelCodeScope GelCodeScope;
+
+struct _GelCodeScope
+{
+    guint n_slots;
+    const gchar *const *slot_names;
+    const GelContext *context;
+    guint depth;
+};
+
+
+static
+GelCode* gel_code_compile(const GValue *value, const GelCodeScope *scope);
+
+
+static
+GelCode* gel_code_alloc(GelCodeType type, const GValue *value, guint n_codes)
+{
+    GelCode *self = g_malloc(sizeof(GelCode) + n_codes * sizeof(GelCode *));
+    self->type = type;
+    self->value = value;
+    self->name = NULL;
+    self->depth = 0;
+    self->slot = 0;
+    self->variable = NULL;
+    self->cached = NULL;
+    self->outermost = NULL;
+    self->version = 0;
+    self->n_codes = n_codes;
+
+    return self;
+}
+
+
+static
+GelCode* gel_code_new_from_symbol(const GValue *value,
+                                  const GelCodeScope *scope)
+{
+    GelCode *self = gel_code_alloc(GEL_CODE_SYMBOL, value, 0);
+
+    if(scope != NULL)
+    {
+        const GelSymbol *symbol = g_value_get_boxed(value);
+        const gchar *name = gel_symbol_get_name(symbol);
+
+        self->name = name;
+        self->depth = scope->depth;
+
+        for(guint i = scope->n_slots; i > 0; i--)
+            if(scope->slot_names[i - 1] == name)
+            {
+                self->type = GEL_CODE_SLOT;
+                self->slot = i - 1;
+                return self;
+            }
+
+        GelVariable *variable =
+            gel_context_get_interned(scope->context, name);
+        if(variable != NULL)
+        {
+            self->type = GEL_CODE_CAPTURED;
+            self->variable = gel_variable_ref(variable);
+        }
+    }
+
+    return self;
+}
+
+
+static
+gboolean gel_code_is_shadowed(const GelSymbol *symbol,
+                              const GelCodeScope *scope)
+{
+    if(scope == NULL)
+        return FALSE;
+
+    /* predefined variables are not kept by contexts,
+     * so any argument or variable with the name hides them */
+    const gchar *name = gel_symbol_get_name(symbol);
+    for(guint i = 0; i < scope->n_slots; i++)
+        if(scope->slot_names[i] == name)
+            return TRUE;
+
+    return gel_context_lookup_interned(scope->context, name) != NULL;
+}
+
+
+static
+gboolean gel_code_is_predefined(const GelSymbol *symbol, const gchar *name)
+{
+    const GelVariable *variable = gel_symbol_get_variable(symbol);
+
+    return variable != NULL
+        && g_strcmp0(gel_symbol_get_name(symbol), name) == 0
+        && variable == gel_variable_lookup_predefined(name);
+}
+
+
+static
+gboolean gel_code_case_is_literal(guint n_args, const GValue *args)
+{
+    /* the tests of each clause are literal arrays */
+    for(guint i = 1; i + 1 < n_args; i += 2)
+        if(!G_VALUE_HOLDS(args + i, GEL_TYPE_ARRAY))
+            return FALSE;
+
+    return TRUE;
+}
+
+
+static
+gboolean gel_code_let_is_literal(guint n_args, const GValue *args)
+{
+    if(!G_VALUE_HOLDS(args + 0, GEL_TYPE_ARRAY))
+        return FALSE;
+
+    const GelArray *bindings = g_value_get_boxed(args + 0);
+    const guint n_values = gel_array_get_n_values(bindings);
+    const GValue *values = gel_array_get_values(bindings);
+
+    if(n_values % 2 != 0)
+        return FALSE;
+
+    for(guint i = 0; i < n_values; i += 2)
+        if(!G_VALUE_HOLDS(values + i, GEL_TYPE_SYMBOL))
+            return FALSE;
+
+    return TRUE;
+}
+
+
+static
+GelCodeType gel_code_type_of_call(const GelSymbol *symbol,
+                                  guint n_args, const GValue *args)
+{
+    if(gel_code_is_predefined(symbol, "if"))
+        return (n_args == 2 || n_args == 3) ? GEL_CODE_IF : GEL_CODE_CALL;
+
+    if(gel_code_is_predefined(symbol, "do"))
+        return GEL_CODE_DO;
+
+    if(gel_code_is_predefined(symbol, "and"))
+        return n_args >= 1 ? GEL_CODE_AND : GEL_CODE_CALL;
+
+    if(gel_code_is_predefined(symbol, "or"))
+        return n_args >= 1 ? GEL_CODE_OR : GEL_CODE_CALL;
+
+    if(gel_code_is_predefined(symbol, "while"))
+        return n_args >= 2 ? GEL_CODE_WHILE : GEL_CODE_CALL;
+
+    if(gel_code_is_predefined(symbol, "cond"))
+        return n_args >= 2 ? GEL_CODE_COND : GEL_CODE_CALL;
+
+    if(gel_code_is_predefined(symbol, "case"))
+        return n_args >= 2 && gel_code_case_is_literal(n_args, args) ?
+            GEL_CODE_CASE : GEL_CODE_CALL;
+
+    if(gel_code_is_predefined(symbol, "let"))
+        return n_args >= 2 && gel_code_let_is_literal(n_args, args) ?
+            GEL_CODE_LET : GEL_CODE_CALL;
+
+    return GEL_CODE_CALL;
+}
+
+
+static
+gboolean gel_code_head_is_native(const GValue *head)
+{
+    if(!G_VALUE_HOLDS(head, GEL_TYPE_SYMBOL))
+        return FALSE;
+
+    const GelSymbol *symbol = g_value_get_boxed(head);
+    const GelVariable *variable = gel_symbol_get_variable(symbol);
+
+    return variable != NULL
+        && variable == gel_variable_lookup_predefined(
+            gel_symbol_get_name(symbol));
+}
+
+
+static
+GelCode* gel_code_new_let(const GValue *value, guint n_args,
+                          const GValue *args, const GelCodeScope *scope)
+{
+    const GelArray *bindings = g_value_get_boxed(args + 0);
+    const guint n_bindings = gel_array_get_n_values(bindings) / 2;
+    const GValue *binding_values = gel_array_get_values(bindings);
+
+    /* the bindings and the body are evaluated in a context of their own */
+    GelCodeScope let_scope;
+    if(scope != NULL)
+    {
+        let_scope = *scope;
+        let_scope.depth++;
+        scope = &let_scope;
+    }
+
+    GelCode *self = gel_code_alloc(GEL_CODE_LET, value,
+        n_bindings + n_args - 1);
+    self->slot = n_bindings;
+
+    for(guint i = 0; i < n_bindings; i++)
+        self->codes[i] = gel_code_compile(binding_values + 2 * i + 1, scope);
+
+    for(guint i = 1; i < n_args; i++)
+        self->codes[n_bindings + i - 1] = gel_code_compile(args + i, scope);
+
+    return self;
+}
+
+
+static
+GelCode* gel_code_new_from_array(const GValue *value,
+                                 const GelCodeScope *scope)
+{
+    GelArray *array = g_value_get_boxed(value);
+    const guint n_values = gel_array_get_n_values(array);
+    const GValue *values = gel_array_get_values(array);
+
+    if(n_values == 0)
+        return gel_code_alloc(GEL_CODE_LITERAL, value, 0);
+
+    GelCodeType type = GEL_CODE_CALL;
+    gboolean shadowed = G_VALUE_HOLDS(values + 0, GEL_TYPE_SYMBOL)
+        && gel_code_is_shadowed(g_value_get_boxed(values + 0), scope);
+    if(G_VALUE_HOLDS(values + 0, GEL_TYPE_SYMBOL) && !shadowed)
+        type = gel_code_type_of_call(g_value_get_boxed(values + 0),
+            n_values - 1, values + 1);
+
+    GelCode *self = NULL;
+    if(type == GEL_CODE_CALL)
+    {
+        /* predefined functions evaluate their own arguments */
+        guint n_codes =
+            !shadowed && gel_code_head_is_native(values + 0) ? 1 : n_values;
+        self = gel_code_alloc(type, value, n_codes);
+        for(guint i = 0; i < n_codes; i++)
+            self->codes[i] = gel_code_compile(values + i, scope);
+    }
+    else
+    if(type == GEL_CODE_LET)
+        self = gel_code_new_let(value, n_values - 1, values + 1, scope);
+    else
+    {
+        /* the loop evaluates its code in a context of its own */
+        GelCodeScope loop_scope;
+        if(type == GEL_CODE_WHILE && scope != NULL)
+        {
+            loop_scope = *scope;
+            loop_scope.depth++;
+            scope = &loop_scope;
+        }
+
+        self = gel_code_alloc(type, value, n_values - 1);
+        for(guint i = 1; i < n_values; i++)
+            if(type == GEL_CODE_CASE && i % 2 == 0 && i + 1 < n_values)
+                self->codes[i - 1] =
+                    gel_code_alloc(GEL_CODE_LITERAL, values + i, 0);
+            else
+                self->codes[i - 1] = gel_code_compile(values + i, scope);
+    }
+
+    return self;
+}
+
+
+static
+GelCode* gel_code_compile(const GValue *value, const GelCodeScope *scope)
+{
+    GType type = G_VALUE_TYPE(value);
+
+    if(type == GEL_TYPE_SYMBOL)
+        return gel_code_new_from_symbol(value, scope);
+
+    if(type == GEL_TYPE_ARRAY)
+        return gel_code_new_from_array(value, scope);
+
+    return gel_code_alloc(GEL_CODE_LITERAL, value, 0);
+}
+
+
+/*
+ * gel_code_new:
+ * @value: a #GValue to compile
+ *
+ * Compiles @value. The code keeps a reference to @value,
+ * so @value must outlive the returned code.
+ */
+GelCode* gel_code_new(const GValue *value)
+{
+    g_return_val_if_fail(value != NULL, NULL);
+
+    return gel_code_compile(value, NULL);
+}
+
+
+/*
+ * gel_code_new_block:
+ * @n_values: number of values in @values
+ * @values: the values to compile
+ * @n_slots: number of names in @slot_names
+ * @slot_names: names of the slots of the frame where the code is evaluated
+ * @context: #GelContext with the variables captured by the code
+ *
+ * Compiles @values as a sequence that evaluates to its last value,
+ * as the body of a closure does. The code must be evaluated in a frame
+ * created by #gel_context_new_frame with @slot_names,
+ * whose outer context is @context.
+ */
+GelCode* gel_code_new_block(guint n_values, const GValue *values,
+                            guint n_slots, const gchar *const *slot_names,
+                            const GelContext *context)
+{
+    g_return_val_if_fail(context != NULL, NULL);
+
+    GelCodeScope scope = {n_slots, slot_names, context, 0};
+
+    GelCode *self = gel_code_alloc(GEL_CODE_DO, NULL, n_values);
+    for(guint i = 0; i < n_values; i++)
+        self->codes[i] = gel_code_compile(values + i, &scope);
+
+    return self;
+}
+
+
+void gel_code_free(GelCode *self)
+{
+    g_return_if_fail(self != NULL);
+
+    for(guint i = 0; i < self->n_codes; i++)
+        gel_code_free(self->codes[i]);
+    if(self->variable != NULL)
+        gel_variable_unref(self->variable);
+    g_free(self);
+}
+
+
+static
+const GValue* gel_code_eval_at(const GelCode *self, GelContext *context,
+                               GValue *out_value, GelCodeCall *tail_call);
+
+
+static
+const GValue* gel_code_eval_codes(GelCode *const *codes, guint n_codes,
+                                  GelContext *context, GValue *out_value,
+                                  GelCodeCall *tail_call)
+{
+    if(n_codes == 0)
+        return out_value;
+
+    guint last = n_codes - 1;
+    for(guint i = 0; i < last; i++)
+    {
+        GValue tmp_value = {0};
+        gel_code_eval_at(codes[i], context, &tmp_value, NULL);
+
+        if(G_IS_VALUE(&tmp_value))
+            g_value_unset(&tmp_value);
+
+        if(gel_context_error(context))
+            return out_value;
+    }
+
+    return gel_code_eval_at(codes[last], context, out_value, tail_call);
+}
+
+
+static
+const GValue* gel_code_eval_head(const GelCode *self, GelContext *context,
+                                 GValue *out_value)
+{
+    const GelCode *head = self->codes[0];
+    if(head->type != GEL_CODE_SYMBOL)
+        return gel_code_eval_at(head, context, out_value, NULL);
+
+    const GelSymbol *symbol = g_value_get_boxed(head->value);
+    const GelContext *outermost = NULL;
+    const GelVariable *variable =
+        gel_context_resolve_local(context, symbol, &outermost);
+    if(variable != NULL)
+        return gel_variable_get_value(variable);
+
+    /* the cache does not change what self means, only how fast it runs */
+    GelCode *cache = (GelCode *)self;
+    guint version = gel_context_get_version(context);
+
+    if(cache->cached == NULL || cache->version != version
+        || cache->outermost != outermost)
+    {
+        variable = gel_context_resolve_global(outermost, symbol);
+        if(variable == NULL)
+            return gel_code_eval_at(head, context, out_value, NULL);
+        if(gel_context_is_parallel(context))
+            return gel_variable_get_value(variable);
+
+        cache->cached = variable;
+        cache->outermost = outermost;
+        cache->version = version;
+    }
+
+    return gel_variable_get_value(cache->cached);
+}
+
+
+static
+const GValue* gel_code_eval_call(const GelCode *self, GelContext *context,
+                                 GValue *out_value, GelCodeCall *tail_call)
+{
+    const GValue *result = self->value;
+
+    GValue tmp_value = {0};
+    const GValue *head_value = gel_code_eval_head(self, context, &tmp_value);
+
+    if(!gel_context_error(context))
+        if(G_VALUE_HOLDS(head_value, G_TYPE_CLOSURE))
+        {
+            GClosure *closure = g_value_get_boxed(head_value);
+            const GelArray *array = g_value_get_boxed(self->value);
+            const guint n_args = gel_array_get_n_values(array) - 1;
+
+            if(self->n_codes == n_args + 1 && gel_closure_is_gel(closure))
+            {
+                if(tail_call != NULL)
+                {
+                    /* the caller invokes the closure once it has returned */
+                    GelContext *frame = gel_closure_new_frame(closure,
+                        n_args, self->codes + 1, context);
+                    if(frame != NULL)
+                    {
+                        tail_call->closure = g_closure_ref(closure);
+                        tail_call->frame = frame;
+                    }
+                }
+                else
+                    gel_closure_call(closure,
+                        out_value, n_args, self->codes + 1, context);
+            }
+            else
+                g_closure_invoke(closure,
+                    out_value, n_args, gel_array_get_values(array) + 1,
+                    context);
+            result = out_value;
+        }
+
+    if(G_IS_VALUE(&tmp_value))
+        g_value_unset(&tmp_value);
+
+    return result;
+}
+
+
+static
+const GValue* gel_code_eval_if(const GelCode *self, GelContext *context,
+                               GValue *out_value, GelCodeCall *tail_call)
+{
+    GValue tmp_value = {0};
+    const GValue *cond_value =
+        gel_code_eval_at(self->codes[0], context, &tmp_value, NULL);
+
+    gboolean cond_is_true = gel_value_to_boolean(cond_value);
+    if(G_IS_VALUE(&tmp_value))
+        g_value_unset(&tmp_value);
+
+    if(gel_context_error(context))
+        return out_value;
+
+    if(cond_is_true)
+        return gel_code_eval_at(self->codes[1],
+            context, out_value, tail_call);
+
+    if(self->n_codes > 2)
+        return gel_code_eval_at(self->codes[2],
+            context, out_value, tail_call);
+
+    return out_value;
+}
+
+
+static
+const GValue* gel_code_eval_logic(const GelCode *self, gboolean stop_on,
+                                  GelContext *context, GValue *out_value,
+                                  GelCodeCall *tail_call)
+{
+    guint last = self->n_codes - 1;
+    for(guint i = 0; i < last; i++)
+    {
+        const GValue *value =
+            gel_code_eval_at(self->codes[i], context, out_value, NULL);
+
+        if(gel_context_error(context))
+            return out_value;
+
+        if(gel_value_to_boolean(value) == stop_on)
+            return value;
+
+        if(G_IS_VALUE(out_value))
+            g_value_unset(out_value);
+    }
+
+    return gel_code_eval_at(self->codes[last], context, out_value, tail_call);
+}
+
+
+static
+const GValue* gel_code_eval_while(const GelCode *self,
+                                  GelContext *context, GValue *out_value)
+{
+    GelContext *loop_context = gel_context_new_with_outer(context);
+    gboolean running = TRUE;
+
+    while(running)
+    {
+        GValue tmp_value = {0};
+        const GValue *cond_value =
+            gel_code_eval_at(self->codes[0], loop_context, &tmp_value, NULL);
+
+        running = !gel_context_error(loop_context)
+            && gel_value_to_boolean(cond_value);
+
+        if(G_IS_VALUE(&tmp_value))
+            g_value_unset(&tmp_value);
+
+        if(running)
+        {
+            const GValue *value = gel_code_eval_codes(self->codes + 1,
+                self->n_codes - 1, loop_context, &tmp_value, NULL);
+
+            if(gel_context_error(loop_context))
+                running = FALSE;
+            else
+            if(G_IS_VALUE(value))
+            {
+                if(G_IS_VALUE(out_value))
+                    g_value_unset(out_value);
+                gel_value_copy(value, out_value);
+            }
+
+            if(G_IS_VALUE(&tmp_value))
+                g_value_unset(&tmp_value);
+        }
+    }
+
+    gel_context_free(loop_context);
+
+    return out_value;
+}
+
+
+static
+const GValue* gel_code_eval_cond(const GelCode *self, GelContext *context,
+                                 GValue *out_value, GelCodeCall *tail_call)
+{
+    guint i = 0;
+    for(; i + 1 < self->n_codes; i += 2)
+    {
+        GValue tmp_value = {0};
+        const GValue *test_value =
+            gel_code_eval_at(self->codes[i], context, &tmp_value, NULL);
+
+        gboolean test_is_true = gel_value_to_boolean(test_value);
+        if(G_IS_VALUE(&tmp_value))
+            g_value_unset(&tmp_value);
+
+        if(gel_context_error(context))
+            return out_value;
+
+        if(test_is_true)
+            return gel_code_eval_at(self->codes[i + 1],
+                context, out_value, tail_call);
+    }
+
+    if(i < self->n_codes)
+        return gel_code_eval_at(self->codes[i],
+            context, out_value, tail_call);
+
+    return out_value;
+}
+
+
+static
+const GValue* gel_code_eval_case(const GelCode *self, GelContext *context,
+                                 GValue *out_value, GelCodeCall *tail_call)
+{
+    GValue probe_value = {0};
+    const GValue *probe =
+        gel_code_eval_at(self->codes[0], context, &probe_value, NULL);
+
+    const GValue *result = out_value;
+    gboolean matched = gel_context_error(context);
+
+    guint i = 1;
+    for(; i + 1 < self->n_codes && !matched; i += 2)
+    {
+        const GelArray *tests = g_value_get_boxed(self->codes[i]->value);
+        const GValue *test_values = gel_array_get_values(tests);
+        const guint test_n_values = gel_array_get_n_values(tests);
+
+        for(guint j = 0; j < test_n_values && !matched; j++)
+            if(gel_values_eq(test_values + j, probe))
+            {
+                result = gel_code_eval_at(self->codes[i + 1],
+                    context, out_value, tail_call);
+                matched = TRUE;
+            }
+    }
+
+    if(!matched && i < self->n_codes)
+        result = gel_code_eval_at(self->codes[i],
+            context, out_value, tail_call);
+
+    if(G_IS_VALUE(&probe_value))
+        g_value_unset(&probe_value);
+
+    return result;
+}
+
+
+static
+const GValue* gel_code_eval_let(const GelCode *self, GelContext *context,
+                                GValue *out_value, GelCodeCall *tail_call)
+{
+    const GelArray *array = g_value_get_boxed(self->value);
+    const GelArray *bindings =
+        g_value_get_boxed(gel_array_get_values(array) + 1);
+    const GValue *binding_values = gel_array_get_values(bindings);
+    const guint n_bindings = self->slot;
+
+    GelContext *let_context = gel_context_new_with_outer(context);
+
+    for(guint i = 0; i < n_bindings; i++)
+    {
+        GValue tmp_value = {0};
+        const GValue *value =
+            gel_code_eval_at(self->codes[i], let_context, &tmp_value, NULL);
+
+        if(!gel_context_error(let_context))
+        {
+            const GelSymbol *symbol =
+                g_value_get_boxed(binding_values + 2 * i);
+            gel_context_define_value(let_context,
+                gel_symbol_get_name(symbol), gel_value_dup(value));
+        }
+
+        if(G_IS_VALUE(&tmp_value))
+            g_value_unset(&tmp_value);
+
+        if(gel_context_error(let_context))
+        {
+            gel_context_free(let_context);
+            return out_value;
+        }
+    }
+
+    GValue tmp_value = {0};
+    const GValue *value = gel_code_eval_codes(self->codes + n_bindings,
+        self->n_codes - n_bindings, let_context, &tmp_value, tail_call);
+
+    /* the value may be owned by the context of the let */
+    if(!gel_context_error(let_context) && G_IS_VALUE(value))
+        gel_value_copy(value, out_value);
+
+    if(G_IS_VALUE(&tmp_value))
+        g_value_unset(&tmp_value);
+
+    gel_context_free(let_context);
+
+    return out_value;
+}
+
+
+static
+const GValue* gel_code_eval_captured(const GelCode *self,
+                                     const GelContext *context)
+{
+    /* the frame and the loops may define a variable with the same name */
+    const GelVariable *variable =
+        gel_context_get_defined(context, self->depth + 1, self->name);
+
+    if(variable == NULL)
+        variable = self->variable;
+
+    return gel_variable_get_value(variable);
+}
+
+
+static
+const GValue* gel_code_eval_at(const GelCode *self, GelContext *context,
+                               GValue *out_value, GelCodeCall *tail_call)
+{
+    switch(self->type)
+    {
+        case GEL_CODE_LITERAL:
+            return self->value;
+        case GEL_CODE_SYMBOL:
+            return gel_context_eval_into_value(context,
+                self->value, out_value);
+        case GEL_CODE_SLOT:
+            return gel_variable_get_value(gel_context_get_slot(context,
+                self->depth, self->slot, self->name));
+        case GEL_CODE_CAPTURED:
+            return gel_code_eval_captured(self, context);
+        case GEL_CODE_CALL:
+            return gel_code_eval_call(self, context, out_value, tail_call);
+        case GEL_CODE_IF:
+            return gel_code_eval_if(self, context, out_value, tail_call);
+        case GEL_CODE_DO:
+            return gel_code_eval_codes(self->codes, self->n_codes,
+                context, out_value, tail_call);
+        case GEL_CODE_AND:
+            return gel_code_eval_logic(self, FALSE,
+                context, out_value, tail_call);
+        case GEL_CODE_OR:
+            return gel_code_eval_logic(self, TRUE,
+                context, out_value, tail_call);
+        case GEL_CODE_WHILE:
+            return gel_code_eval_while(self, context, out_value);
+        case GEL_CODE_COND:
+            return gel_code_eval_cond(self, context, out_value, tail_call);
+        case GEL_CODE_CASE:
+            return gel_code_eval_case(self, context, out_value, tail_call);
+        case GEL_CODE_LET:
+            return gel_code_eval_let(self, context, out_value, tail_call);
+    }
+
+    return self->value;
+}
+
+
+/*
+ * gel_code_eval:
+ * @self: the #GelCode to evaluate
+ * @context: #GelContext where to evaluate @self
+ * @out_value: an unset #GValue where to store temporary results
+ *
+ * Evaluates @self as #gel_context_eval_into_value would do
+ * with the value @self was compiled from.
+ *
+ * Returns: @out_value, or a value owned by @context or by @self
+ */
+const GValue* gel_code_eval(const GelCode *self, GelContext *context,
+                            GValue *out_value)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+    g_return_val_if_fail(context != NULL, NULL);
+    g_return_val_if_fail(out_value != NULL, NULL);
+
+    return gel_code_eval_at(self, context, out_value, NULL);
+}
+
+
+/*
+ * gel_code_eval_tail:
+ * @self: the #GelCode to evaluate
+ * @context: #GelContext where to evaluate @self
+ * @out_value: an unset #GValue where to store temporary results
+ * @tail_call: return location for a call in tail position
+ *
+ * Evaluates @self as #gel_code_eval does, except that a call to a closure
+ * written in gel in tail position of @self is not performed. Instead,
+ * the frame for the call is prepared and returned in @tail_call,
+ * so the caller can invoke the closure after releasing its own frame.
+ *
+ * Returns: @out_value, or a value owned by @context or by @self
+ */
+const GValue* gel_code_eval_tail(const GelCode *self, GelContext *context,
+                                 GValue *out_value, GelCodeCall *tail_call)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+    g_return_val_if_fail(context != NULL, NULL);
+    g_return_val_if_fail(out_value != NULL, NULL);
+    g_return_val_if_fail(tail_call != NULL, NULL);
+
+    tail_call->closure = NULL;
+    tail_call->frame = NULL;
+
+    return gel_code_eval_at(self, context, out_value, tail_call);
+}
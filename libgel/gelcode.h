@@ -0,0 +1,28 @@
+#ifndef __GEL_CODE_H__
+#define __GEL_CODE_H__
+
+#include <glib-object.h>
+#include <gelcontext.h>
+
+typedef struct _GelCode GelCode;
+typedef struct _GelCodeCall GelCodeCall;
+
+struct _GelCodeCall
+{
+    GClosure *closure;
+    GelContext *frame;
+};
+
+GelCode* gel_code_new(const GValue *value);
+GelCode* gel_code_new_block(guint n_values, const GValue *values,
+                            guint n_slots, const gchar *const *slot_names,
+                            const GelContext *context);
+void gel_code_free(GelCode *self);
+
+const GValue* gel_code_eval(const GelCode *self, GelContext *context,
+                            GValue *out_value);
+const GValue* gel_code_eval_tail(const GelCode *self, GelContext *context,
+                                 GValue *out_value, GelCodeCall *tail_call);
+
+#endif
+
@@ -6,6 +6,8 @@
 #include <gelsymbol.h>
 #include <gelvariable.h>
 #include <gelclosure.h>
+#include <gelclosureprivate.h>
+#include <gelcode.h>
 
 #include <gobject/gvaluecollector.h>
 
@@ -20,6 +22,11 @@
  * @include: gel.h
  *
  * #GelContext is a class where symbols are stored and evaluated.
+ *
+ * Each context created by #gel_context_new is an independent interpreter.
+ * Interpreters do not share mutable state, so different threads can use
+ * different interpreters concurrently. A context, its inner contexts
+ * and the closures created in them must be used by one thread at a time.
  */
 
 /**
@@ -56,49 +63,209 @@
  * It is basically a #GClosureMarshal with its arguments used to pass specific information.
  */
 
+/* distinguishes a context from the hint passed to signal handlers */
+#define GEL_CONTEXT_MAGIC 0x47454c43
+
+
+typedef struct _GelRuntime GelRuntime;
+
+/*
+ * State shared by the contexts of an interpreter.
+ * It is released when the last of its contexts is freed.
+ *
+ * The names resolved by the inline caches of the code are kept in cached,
+ * and the version is incremented whenever one of them is defined, removed
+ * or released in an outermost context, so the caches know the variable
+ * they hold may be stale.
+ *
+ * While n_parallel is not zero, closures of the interpreter run in several
+ * threads, so linking contexts and counting them is done holding lock,
+ * and the caches are neither filled nor registered in cached.
+ */
+struct _GelRuntime
+{
+    guint n_contexts;
+    volatile gint n_lambdas;
+    volatile gint version;
+    GHashTable *cached;
+    volatile gint n_parallel;
+    GRecMutex lock;
+};
+
+
+/*
+ * The inner contexts of a context are kept in a doubly linked list,
+ * so entering and leaving a frame does not touch any hash table.
+ * The table of variables is created when the first variable is defined.
+ */
 struct _GelContext
 {
+    guint magic;
+    GelRuntime *runtime;
     GHashTable *variables;
     GelContext *outer;
-    GHashTable *inner;
+    GelContext *inner;
+    GelContext *next;
+    GelContext *prev;
     GError *error;
+    guint n_slots;
+    guint max_slots;
+    const gchar *const *slot_names;
+    GelVariable **slots;
 };
 
 
+/*
+ * Variables are keyed by their interned name, so looking up the variable
+ * of a symbol compares pointers instead of hashing and comparing strings.
+ */
+static
+const gchar* gel_context_try_intern(const gchar *name)
+{
+    GQuark quark = g_quark_try_string(name);
+
+    return quark != 0 ? g_quark_to_string(quark) : NULL;
+}
+
+
 GQuark gel_context_error_quark(void)
 {
     return g_quark_from_static_string("gel-context-error");
 }
 
 
+static
+GelContext* gel_context_alloc(void)
+{
+    GelContext *self = g_slice_new0(GelContext);
+    self->magic = GEL_CONTEXT_MAGIC;
+
+    return self;
+}
+
+
+static
+void gel_context_dispose(GelContext *self)
+{
+    self->magic = 0;
+    if(self->variables != NULL)
+        g_hash_table_unref(self->variables);
+    g_free(self->slots);
+    g_slice_free(GelContext, self);
+}
+
+
 #if GEL_CONTEXT_USE_POOL
-static guint contexts_COUNT;
-static GList *contexts_POOL;
+
+/* maximum number of released contexts kept by each thread */
+#define GEL_CONTEXT_POOL_SIZE 64
+
+typedef struct _GelContextPool GelContextPool;
+
+/*
+ * Released contexts are kept in a free list of the thread that released
+ * them, linked through their next member, to be reused by any interpreter
+ * running in that thread. Beyond GEL_CONTEXT_POOL_SIZE contexts are
+ * disposed, so the pool does not keep the peak of a deep recursion.
+ */
+struct _GelContextPool
+{
+    GelContext *contexts;
+    guint n_contexts;
+};
+
+
+static
+void gel_context_pool_free(GelContextPool *pool)
+{
+    while(pool->contexts != NULL)
+    {
+        GelContext *context = pool->contexts;
+        pool->contexts = context->next;
+        gel_context_dispose(context);
+    }
+    g_free(pool);
+}
+
+
+static GPrivate context_POOL =
+    G_PRIVATE_INIT((GDestroyNotify)gel_context_pool_free);
+
+
+static
+GelContextPool* gel_context_get_pool(void)
+{
+    GelContextPool *pool = g_private_get(&context_POOL);
+    if(pool == NULL)
+    {
+        pool = g_new0(GelContextPool, 1);
+        g_private_set(&context_POOL, pool);
+    }
+
+    return pool;
+}
+
 #endif
 
 
-static GelContext *context_SOLITON;
+static
+gboolean gel_runtime_lock(GelRuntime *runtime)
+{
+    if(g_atomic_int_get(&runtime->n_parallel) == 0)
+        return FALSE;
+
+    g_rec_mutex_lock(&runtime->lock);
+    return TRUE;
+}
 
 
 static
-GelContext* gel_context_alloc(void)
+void gel_runtime_unlock(GelRuntime *runtime, gboolean locked)
 {
-    GelContext *self = g_slice_new0(GelContext);
-    self->inner = g_hash_table_new(g_direct_hash, g_direct_equal);
-    self->variables = g_hash_table_new_full(
-        g_str_hash, g_str_equal,
-        (GDestroyNotify)g_free, (GDestroyNotify)gel_variable_unref);
+    if(locked)
+        g_rec_mutex_unlock(&runtime->lock);
+}
 
-    return self;
+
+static
+GHashTable* gel_context_get_variables(GelContext *self)
+{
+    if(self->variables == NULL)
+        self->variables = g_hash_table_new_full(
+            g_direct_hash, g_direct_equal,
+            NULL, (GDestroyNotify)gel_variable_unref);
+
+    return self->variables;
 }
 
 
+/* Creates a context of the interpreter of runtime, inside outer */
 static
-void gel_context_dispose(GelContext *self)
+GelContext* gel_context_new_in_runtime(GelRuntime *runtime, GelContext *outer)
 {
-    g_hash_table_unref(self->variables);
-    g_hash_table_unref(self->inner);
-    g_slice_free(GelContext, self);
+    GelContext *self = NULL;
+#if GEL_CONTEXT_USE_POOL
+    GelContextPool *pool = gel_context_get_pool();
+    if(pool->contexts != NULL)
+    {
+        self = pool->contexts;
+        pool->contexts = self->next;
+        pool->n_contexts--;
+        self->next = NULL;
+    }
+    else
+        self = gel_context_alloc();
+#else
+    self = gel_context_alloc();
+#endif
+    gboolean locked = gel_runtime_lock(runtime);
+    runtime->n_contexts++;
+    self->runtime = runtime;
+
+    gel_context_set_outer(self, outer);
+    gel_runtime_unlock(runtime, locked);
+
+    return self;
 }
 
 
@@ -106,15 +273,14 @@ void gel_context_dispose(GelContext *self)
  * gel_context_new:
  *
  * Creates a #GelContext, with no outer context set.
+ * The context is the outermost context of a new interpreter,
+ * independent of the interpreters created by other calls.
  *
  * Returns: A new #GelContext, with no outer context assigned.
  */
 GelContext* gel_context_new(void)
 {
-    if(context_SOLITON == NULL)
-        context_SOLITON = gel_context_new_with_outer(NULL);
-
-    return context_SOLITON;
+    return gel_context_new_with_outer(NULL);
 }
 
 
@@ -124,37 +290,204 @@ GelContext* gel_context_new(void)
  *
  * Creates a #GelContext, using @outer as the outer context.
  * This method is used when invoking functions to have local variables.
+ * If @outer is #NULL, the context belongs to a new interpreter,
+ * as if created by #gel_context_new.
  *
  * Returns: A new created #GelContext, with @outer as the outer context.
  */
 GelContext* gel_context_new_with_outer(GelContext *outer)
 {
-    GelContext *self = NULL;
-#if GEL_CONTEXT_USE_POOL
-    if(contexts_POOL != NULL)
+    GelRuntime *runtime = NULL;
+    if(outer != NULL)
+        runtime = outer->runtime;
+    else
     {
-        self = contexts_POOL->data;
-        contexts_POOL = g_list_delete_link(contexts_POOL, contexts_POOL);
+        runtime = g_slice_new0(GelRuntime);
+        runtime->version = 1;
+        g_rec_mutex_init(&runtime->lock);
     }
-    else
-        self = gel_context_alloc();
-    contexts_COUNT++;
-#else
-    self = gel_context_alloc();
-#endif
 
-    gel_context_set_outer(self, outer);
+    return gel_context_new_in_runtime(runtime, outer);
+}
+
+
+GelContext* gel_context_new_frame(GelContext *outer,
+                                  guint n_slots, const gchar *const *names)
+{
+    GelContext *self = gel_context_new_with_outer(outer);
+
+    if(n_slots > self->max_slots)
+    {
+        self->slots = g_renew(GelVariable *, self->slots, n_slots);
+        self->max_slots = n_slots;
+    }
+
+    for(guint i = 0; i < n_slots; i++)
+        self->slots[i] = NULL;
+
+    self->n_slots = n_slots;
+    self->slot_names = names;
 
     return self;
 }
 
 
-GelContext* gel_context_validate(GelContext *context)
+gboolean gel_context_is_valid(const GelContext *context)
 {
-    /* Hack to work around closures invoked as signal callbacks */
-    if(((GSignalInvocationHint*)context)->signal_id < 32767)
-        context = context_SOLITON;
-    return context;
+    /*
+     * Closures invoked as signal handlers receive a GSignalInvocationHint,
+     * whose first member is a signal id, far below the magic number.
+     */
+    return context != NULL && context->magic == GEL_CONTEXT_MAGIC;
+}
+
+
+void gel_context_warn_error(GelContext *self)
+{
+    g_return_if_fail(self != NULL);
+
+    if(self->error != NULL)
+    {
+        g_warning("%s", self->error->message);
+        g_clear_error(&self->error);
+    }
+}
+
+
+guint gel_context_next_lambda_id(GelContext *self)
+{
+    g_return_val_if_fail(self != NULL, 0);
+
+    return g_atomic_int_add(&self->runtime->n_lambdas, 1);
+}
+
+
+guint gel_context_get_version(const GelContext *self)
+{
+    return g_atomic_int_get(&self->runtime->version);
+}
+
+
+/*
+ * Between these calls the closures of the interpreter of self may run in
+ * several threads, each one with its own inner contexts. The closures
+ * must not change the variables they share.
+ */
+void gel_context_begin_parallel(GelContext *self)
+{
+    g_atomic_int_inc(&self->runtime->n_parallel);
+}
+
+
+void gel_context_end_parallel(GelContext *self)
+{
+    g_atomic_int_add(&self->runtime->n_parallel, -1);
+}
+
+
+gboolean gel_context_is_parallel(const GelContext *self)
+{
+    return g_atomic_int_get(&self->runtime->n_parallel) != 0;
+}
+
+
+gboolean gel_context_lock(GelContext *self)
+{
+    return gel_runtime_lock(self->runtime);
+}
+
+
+void gel_context_unlock(GelContext *self, gboolean locked)
+{
+    gel_runtime_unlock(self->runtime, locked);
+}
+
+
+/*
+ * Resolves symbol as gel_context_eval_into_value does, as long as it is not
+ * bound in the outermost context of self. Otherwise returns NULL and stores
+ * that context in outermost, whose variable may be cached.
+ */
+GelVariable* gel_context_resolve_local(const GelContext *self,
+                                       const GelSymbol *symbol,
+                                       const GelContext **outermost)
+{
+    const gchar *name = gel_symbol_get_name(symbol);
+
+    GelVariable *variable = gel_context_get_interned(self, name);
+    if(variable == NULL)
+        variable = gel_symbol_get_variable(symbol);
+    if(variable != NULL)
+        return variable;
+
+    const GelContext *context = self;
+    for(; context->outer != NULL; context = context->outer)
+        if(context != self)
+        {
+            variable = gel_context_get_interned(context, name);
+            if(variable != NULL)
+                return variable;
+        }
+
+    *outermost = context;
+    return NULL;
+}
+
+
+/*
+ * Looks up symbol in the outermost context self, and remembers its name
+ * so later changes to its binding there increment the version returned
+ * by gel_context_get_version.
+ */
+GelVariable* gel_context_resolve_global(const GelContext *self,
+                                        const GelSymbol *symbol)
+{
+    const gchar *name = gel_symbol_get_name(symbol);
+    GelVariable *variable = gel_context_get_interned(self, name);
+
+    if(variable != NULL && !gel_context_is_parallel(self))
+    {
+        GelRuntime *runtime = self->runtime;
+        if(runtime->cached == NULL)
+            runtime->cached = g_hash_table_new(g_direct_hash, g_direct_equal);
+        g_hash_table_insert(runtime->cached, (void *)name, (void *)name);
+    }
+
+    return variable;
+}
+
+
+/* only the variables of outermost contexts are cached */
+void gel_context_binding_changed(GelContext *self, const gchar *name)
+{
+    GelRuntime *runtime = self->runtime;
+    if(self->outer == NULL && runtime->cached != NULL
+        && g_hash_table_contains(runtime->cached, name))
+        g_atomic_int_inc(&runtime->version);
+}
+
+
+/* the variables of self are going away, so the caches must forget them */
+static
+void gel_context_release_bindings(GelContext *self)
+{
+    GelRuntime *runtime = self->runtime;
+    if(self->outer != NULL || runtime->cached == NULL)
+        return;
+
+    if(self->variables != NULL && g_hash_table_size(self->variables) > 0)
+    {
+        const gchar *name;
+        GHashTableIter iter;
+        g_hash_table_iter_init(&iter, self->variables);
+
+        while(g_hash_table_iter_next(&iter, (void **)&name, NULL))
+            if(g_hash_table_contains(runtime->cached, name))
+            {
+                g_atomic_int_inc(&runtime->version);
+                return;
+            }
+    }
 }
 
 
@@ -172,13 +505,24 @@ GelContext* gel_context_copy(const GelContext *self)
 
     const gchar *name;
     GelVariable *variable;
-    GelContext *context = gel_context_new_with_outer(self->outer);
+    /* the copy belongs to the interpreter of self, even if it is outermost */
+    GelContext *context = gel_context_new_in_runtime(self->runtime, self->outer);
 
-    GHashTableIter iter;
-    g_hash_table_iter_init(&iter, self->variables);
+    if(self->variables != NULL)
+    {
+        GHashTableIter iter;
+        g_hash_table_iter_init(&iter, self->variables);
 
-    while(g_hash_table_iter_next(&iter, (void **)&name, (void **)&variable))
-        gel_context_define_variable(context, name, variable);
+        while(g_hash_table_iter_next(&iter,
+                (void **)&name, (void **)&variable))
+            g_hash_table_insert(gel_context_get_variables(context),
+                (void *)name, gel_variable_ref(variable));
+    }
+
+    for(guint i = 0; i < self->n_slots; i++)
+        if(self->slots[i] != NULL)
+            g_hash_table_insert(gel_context_get_variables(context),
+                (void *)self->slot_names[i], gel_variable_ref(self->slots[i]));
 
     return context;
 }
@@ -194,13 +538,13 @@ void gel_context_free(GelContext *self)
 {
     g_return_if_fail(self != NULL);
 
-    GList *inner_list = g_hash_table_get_keys(self->inner);
-    for(GList *iter = inner_list; iter != NULL; iter = iter->next)
-    {
-        GelContext *inner = iter->data;
-        gel_context_set_outer(inner, self->outer);
-    }
-    g_list_free(inner_list);
+    GelRuntime *runtime = self->runtime;
+    gboolean locked = gel_runtime_lock(runtime);
+
+    gel_context_release_bindings(self);
+
+    while(self->inner != NULL)
+        gel_context_set_outer(self->inner, self->outer);
 
     if(self->error != NULL)
     {
@@ -211,22 +555,42 @@ void gel_context_free(GelContext *self)
         self->error = NULL;
     }
 
-#if GEL_CONTEXT_USE_POOL
-    g_hash_table_remove_all(self->variables);
-    g_hash_table_remove_all(self->inner);
+    for(guint i = 0; i < self->n_slots; i++)
+        if(self->slots[i] != NULL)
+            gel_variable_unref(self->slots[i]);
+    self->n_slots = 0;
+    self->slot_names = NULL;
+
+    gel_context_set_outer(self, NULL);
 
-    contexts_POOL = g_list_append(contexts_POOL, self);
-    if(--contexts_COUNT == 0)
+    self->runtime = NULL;
+    gboolean last = (--runtime->n_contexts == 0);
+    gel_runtime_unlock(runtime, locked);
+
+    if(last)
     {
-        g_list_foreach(contexts_POOL, (GFunc)gel_context_dispose, NULL);
-        g_list_free(contexts_POOL);
-        contexts_POOL = 0;
+        if(runtime->cached != NULL)
+            g_hash_table_unref(runtime->cached);
+        g_rec_mutex_clear(&runtime->lock);
+        g_slice_free(GelRuntime, runtime);
     }
+
+#if GEL_CONTEXT_USE_POOL
+    GelContextPool *pool = gel_context_get_pool();
+    if(pool->n_contexts < GEL_CONTEXT_POOL_SIZE)
+    {
+        if(self->variables != NULL && g_hash_table_size(self->variables) > 0)
+            g_hash_table_remove_all(self->variables);
+
+        self->next = pool->contexts;
+        pool->contexts = self;
+        pool->n_contexts++;
+    }
+    else
+        gel_context_dispose(self);
 #else
     gel_context_dispose(self);
 #endif
-    if(self == context_SOLITON)
-        context_SOLITON = NULL;
 }
 
 
@@ -248,7 +612,22 @@ gboolean gel_context_eval(GelContext *self,
     g_return_val_if_fail(value != NULL, FALSE);
     g_return_val_if_fail(dest != NULL, FALSE);
 
-    gboolean result = gel_context_eval_value(self, value, dest);
+    GelCode *code = gel_code_new(value);
+    GValue tmp_value = {0};
+    const GValue *result_value = gel_code_eval(code, self, &tmp_value);
+    gboolean result = FALSE;
+
+    if(G_IS_VALUE(result_value))
+    {
+        if(G_IS_VALUE(dest))
+            g_value_unset(dest);
+        gel_value_copy(result_value, dest);
+        result = TRUE;
+    }
+
+    if(G_IS_VALUE(&tmp_value))
+        g_value_unset(&tmp_value);
+    gel_code_free(code);
 
     if(self->error != NULL)
     {
@@ -320,12 +699,16 @@ const GValue* gel_context_eval_into_value(GelContext *self,
         const GelSymbol *symbol = g_value_get_boxed(value);
         const gchar *name = gel_symbol_get_name(symbol);
 
-        const GelVariable *variable = gel_context_get_variable(self, name);
+        const GelVariable *variable = gel_context_get_interned(self, name);
         result = (variable != NULL) ?
             gel_variable_get_value(variable) : gel_symbol_get_value(symbol);
 
         if(result == NULL)
-            result = gel_context_lookup(self, name);
+        {
+            variable = gel_context_lookup_interned(self, name);
+            if(variable != NULL)
+                result = gel_variable_get_value(variable);
+        }
 
         if(result == NULL)
             gel_error_unknown_symbol(self, __FUNCTION__, name);
@@ -389,6 +772,15 @@ void gel_context_set_error(GelContext* self, GError *error)
 }
 
 
+GError* gel_context_take_error(GelContext *self)
+{
+    GError *error = self->error;
+    self->error = NULL;
+
+    return error;
+}
+
+
 void gel_context_transfer_error(GelContext *self, GelContext *context)
 {
     g_warn_if_fail(self != context);
@@ -415,25 +807,32 @@ void gel_context_clear_error(GelContext* self)
 }
 
 
-GelVariable* gel_context_get_variable(const GelContext *self,
+GelVariable* gel_context_get_interned(const GelContext *self,
                                       const gchar *name)
 {
+    for(guint i = self->n_slots; i > 0; i--)
+    {
+        GelVariable *variable = self->slots[i - 1];
+        if(variable != NULL && self->slot_names[i - 1] == name)
+            return variable;
+    }
+
+    if(self->variables == NULL || g_hash_table_size(self->variables) == 0)
+        return NULL;
+
     return g_hash_table_lookup(self->variables, name);
 }
 
 
-GelVariable* gel_context_lookup_variable(const GelContext *self,
+GelVariable* gel_context_lookup_interned(const GelContext *self,
                                          const gchar *name)
 {
-    g_return_val_if_fail(self != NULL, NULL);
-    g_return_val_if_fail(name != NULL, NULL);
-
     GelVariable *variable = NULL;
     const GelContext *context = self;
 
     while(context != NULL && variable == NULL)
     {
-        variable = gel_context_get_variable(context, name);
+        variable = gel_context_get_interned(context, name);
         context = context->outer;
     }
 
@@ -441,6 +840,93 @@ GelVariable* gel_context_lookup_variable(const GelContext *self,
 }
 
 
+GelVariable* gel_context_get_variable(const GelContext *self,
+                                      const gchar *name)
+{
+    const gchar *interned = gel_context_try_intern(name);
+
+    return interned != NULL ? gel_context_get_interned(self, interned) : NULL;
+}
+
+
+static
+GelVariable* gel_context_find_defined(const GelContext **context,
+                                      guint depth, const gchar *name)
+{
+    for(guint i = 0; i < depth; i++)
+    {
+        const GelContext *self = *context;
+        if(self->variables != NULL && g_hash_table_size(self->variables) > 0)
+        {
+            GelVariable *variable =
+                g_hash_table_lookup(self->variables, name);
+            if(variable != NULL)
+                return variable;
+        }
+        *context = self->outer;
+    }
+
+    return NULL;
+}
+
+
+GelVariable* gel_context_get_defined(const GelContext *self,
+                                     guint depth, const gchar *name)
+{
+    return gel_context_find_defined(&self, depth, name);
+}
+
+
+GelVariable* gel_context_get_slot(const GelContext *self,
+                                  guint depth, guint slot, const gchar *name)
+{
+    GelVariable *variable = gel_context_find_defined(&self, depth, name);
+
+    if(variable != NULL)
+        return variable;
+
+    return self->slots[slot];
+}
+
+
+void gel_context_define_slot(GelContext *self, guint slot, GValue *value)
+{
+    g_return_if_fail(self != NULL);
+    g_return_if_fail(slot < self->n_slots);
+    g_return_if_fail(value != NULL);
+
+    if(self->slots[slot] != NULL)
+        gel_variable_unref(self->slots[slot]);
+    self->slots[slot] = gel_variable_new(value);
+}
+
+
+void gel_context_bind_slot(GelContext *self,
+                           guint slot, GelVariable *variable)
+{
+    g_return_if_fail(self != NULL);
+    g_return_if_fail(slot < self->n_slots);
+    g_return_if_fail(variable != NULL);
+
+    if(self->slots[slot] != NULL)
+        gel_variable_unref(self->slots[slot]);
+    self->slots[slot] = gel_variable_ref(variable);
+}
+
+
+GelVariable* gel_context_lookup_variable(const GelContext *self,
+                                         const gchar *name)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+    g_return_val_if_fail(name != NULL, NULL);
+
+    const gchar *interned = gel_context_try_intern(name);
+
+    return interned != NULL ?
+        gel_context_lookup_interned(self, interned) : NULL;
+}
+
+
 /**
  * gel_context_lookup:
  * @self: #GelContext where to look for the symbol named @name
@@ -474,8 +960,11 @@ void gel_context_define_variable(GelContext *self,
     g_return_if_fail(name != NULL);
     g_return_if_fail(variable != NULL);
 
-    g_hash_table_insert(self->variables,
-        g_strdup(name), gel_variable_ref(variable));
+    const gchar *interned = g_intern_string(name);
+    gel_context_binding_changed(self, interned);
+
+    g_hash_table_insert(gel_context_get_variables(self),
+        (void *)interned, gel_variable_ref(variable));
 }
 
 
@@ -495,8 +984,11 @@ void gel_context_define_value(GelContext *self,
     g_return_if_fail(name != NULL);
     g_return_if_fail(value != NULL);
 
-    g_hash_table_insert(self->variables,
-        g_strdup(name), gel_variable_new(value));
+    const gchar *interned = g_intern_string(name);
+    gel_context_binding_changed(self, interned);
+
+    g_hash_table_insert(gel_context_get_variables(self),
+        (void *)interned, gel_variable_new(value));
 }
 
 
@@ -600,7 +1092,22 @@ gboolean gel_context_remove(GelContext *self, const gchar *name)
     g_return_val_if_fail(self != NULL, FALSE);
     g_return_val_if_fail(name != NULL, FALSE);
 
-    return g_hash_table_remove(self->variables, name);
+    const gchar *interned = gel_context_try_intern(name);
+    if(interned == NULL || self->variables == NULL)
+        return FALSE;
+
+    gel_context_binding_changed(self, interned);
+    return g_hash_table_remove(self->variables, interned);
+}
+
+
+/*
+ * Whether contexts were created inside self, as the frames of the closures
+ * created in self are, and are not freed yet.
+ */
+gboolean gel_context_has_inner(const GelContext *self)
+{
+    return self->inner != NULL;
 }
 
 
@@ -626,11 +1133,83 @@ void gel_context_set_outer(GelContext *self, GelContext *context)
 
     GelContext *old_outer = self->outer;
     if(old_outer != NULL)
-        g_hash_table_remove(old_outer->inner, self);
+    {
+        if(self->prev != NULL)
+            self->prev->next = self->next;
+        else
+            old_outer->inner = self->next;
+
+        if(self->next != NULL)
+            self->next->prev = self->prev;
+    }
+
+    self->prev = NULL;
+    self->next = NULL;
 
     if(context != NULL)
-        g_hash_table_insert(context->inner, self, self);
+    {
+        self->next = context->inner;
+        if(context->inner != NULL)
+            context->inner->prev = self;
+        context->inner = self;
+    }
 
     self->outer = context;
 }
 
+
+/* Whether variable holds a closure created in self that nothing else holds */
+static
+gboolean gel_context_owns_closure(const GelContext *self,
+                                  const GelVariable *variable)
+{
+    if(variable == NULL || gel_variable_is_shared(variable))
+        return FALSE;
+
+    const GValue *value = gel_variable_get_value(variable);
+    if(!G_VALUE_HOLDS(value, G_TYPE_CLOSURE))
+        return FALSE;
+
+    GClosure *closure = g_value_get_boxed(value);
+    if(closure == NULL || !gel_closure_is_gel(closure)
+        || closure->ref_count != 1)
+        return FALSE;
+
+    const GelContext *context = gel_closure_get_context(closure);
+    return context->outer == self && context->inner == NULL;
+}
+
+
+/*
+ * Whether the contexts inside self are those of closures only held by
+ * variables of self. Then nothing but self can reach them, and self can be
+ * freed with them before the code that created it returns.
+ */
+gboolean gel_context_inner_are_owned(const GelContext *self)
+{
+    guint n_inner = 0;
+    for(const GelContext *inner = self->inner; inner; inner = inner->next)
+        n_inner++;
+
+    if(n_inner == 0)
+        return TRUE;
+
+    guint n_owned = 0;
+    for(guint i = 0; i < self->n_slots; i++)
+        if(gel_context_owns_closure(self, self->slots[i]))
+            n_owned++;
+
+    if(self->variables != NULL)
+    {
+        GelVariable *variable;
+        GHashTableIter iter;
+        g_hash_table_iter_init(&iter, self->variables);
+
+        while(g_hash_table_iter_next(&iter, NULL, (void **)&variable))
+            if(gel_context_owns_closure(self, variable))
+                n_owned++;
+    }
+
+    return n_owned == n_inner;
+}
+
@@ -4,63 +4,196 @@
 #include <gelvalue.h>
 #include <gelvalueprivate.h>
 #include <gelsymbol.h>
-
-#define g_node_get_int(node) \
-    (GPOINTER_TO_INT((node)->data))
-
-#define g_node_add_int(node, data) \
-    g_node_append_data(node, GINT_TO_POINTER(data))
+#include <geliterator.h>
+#include <gelvector.h>
+#include <gelrope.h>
+#include <gelhash.h>
 
 #define gel_args_pop(args, type) \
     (**((type **)(*(args))++))
 
+
+/*
+ * A format is compiled once per thread into a flat array of specs.
+ * The first spec stands for the whole format and every group, written
+ * between parentheses, is followed by the specs of its members,
+ * so the next member of a group is found by skipping size specs.
+ */
+typedef struct _GelParamsSpec GelParamsSpec;
+
+struct _GelParamsSpec
+{
+    gchar format;
+    gboolean exact;
+    guint n_args;
+    guint size;
+};
+
+
+typedef struct _GelParamsFormat GelParamsFormat;
+
+struct _GelParamsFormat
+{
+    gchar *format;
+    guint n_pointers;
+    GelParamsSpec specs[];
+};
+
+
 static
-GNode *gel_params_format_to_node(const gchar *format, guint *pos, guint *count)
+void gel_params_format_free(GelParamsFormat *self)
 {
-    GNode *root = g_node_new(NULL);
-    while(format[*pos] != 0)
+    g_free(self->format);
+    g_free(self);
+}
+
+
+static
+GPrivate params_FORMATS = G_PRIVATE_INIT((GDestroyNotify)g_hash_table_unref);
+
+
+static
+guint gel_params_spec_compile(GelParamsSpec *specs, const gchar *format,
+                              guint *pos, guint *n_pointers)
+{
+    GelParamsSpec *group = specs;
+    guint size = 1;
+
+    group->format = '(';
+    group->exact = TRUE;
+    group->n_args = 0;
+
+    while(format[*pos] != 0 && format[*pos] != ')')
     {
-        if(format[*pos] == '(')
+        gchar c = format[(*pos)++];
+        if(c == '(')
         {
-            (*pos)++;
-            GNode *child = gel_params_format_to_node(format, pos, count);
-            g_node_append(root, child);
+            size += gel_params_spec_compile(specs + size,
+                format, pos, n_pointers);
+            group->n_args++;
+            if(format[*pos] == ')')
+                (*pos)++;
         }
         else
-        if(format[*pos] == ')')
-            break;
+        if(c == '*')
+            group->exact = FALSE;
         else
         {
-            gint data = format[*pos];
-            g_node_add_int(root, data);
-            if(data != '*')
-                (*count)++;
+            GelParamsSpec *spec = specs + size;
+            spec->format = c;
+            spec->exact = TRUE;
+            spec->n_args = 0;
+            spec->size = 1;
+            size++;
+            group->n_args++;
+            (*n_pointers)++;
         }
-        (*pos)++;
     }
 
-    return root;
+    group->size = size;
+    return size;
 }
 
 
 static
-GNode* gel_params_parse_format(const gchar *format, guint *count)
+const GelParamsFormat* gel_params_format_get(const gchar *format)
 {
-    g_return_val_if_fail(count != NULL, NULL);
+    GHashTable *formats = g_private_get(&params_FORMATS);
+    if(formats == NULL)
+    {
+        formats = g_hash_table_new_full(g_str_hash, g_str_equal,
+            NULL, (GDestroyNotify)gel_params_format_free);
+        g_private_set(&params_FORMATS, formats);
+    }
 
-    guint pos = 0;
-    *count = 0;
+    GelParamsFormat *self = g_hash_table_lookup(formats, format);
+    if(self == NULL)
+    {
+        /* a format never has more specs than characters, plus the root */
+        self = g_malloc(sizeof(GelParamsFormat)
+            + (strlen(format) + 1) * sizeof(GelParamsSpec));
+        self->format = g_strdup(format);
+        self->n_pointers = 0;
+
+        guint pos = 0;
+        gel_params_spec_compile(self->specs, format, &pos, &self->n_pointers);
+        g_hash_table_insert(formats, self->format, self);
+    }
 
-    return gel_params_format_to_node(format, &pos, count);
+    return self;
+}
+
+
+/*
+ * Evaluates value keeping the result, when it is a temporary,
+ * in the buffer of tmp or, once it is full, in a list.
+ */
+static
+const GValue* gel_params_eval(GelContext *self, const GValue *value,
+                              GList **list, GelParamsTmp *tmp)
+{
+    GValue *tmp_value = NULL;
+    if(tmp != NULL && tmp->n_values < GEL_PARAMS_TMP_SIZE)
+        tmp_value = tmp->values + tmp->n_values;
+
+    GValue local_value = {0};
+    GValue *out_value = tmp_value != NULL ? tmp_value : &local_value;
+
+    const GValue *result =
+        gel_context_eval_param_into_value(self, value, out_value);
+
+    if(result == out_value)
+    {
+        if(out_value == tmp_value)
+            tmp->n_values++;
+        else
+        {
+            GValue *heap_value = gel_value_new();
+            *heap_value = local_value;
+            if(tmp != NULL)
+                tmp->list = g_list_prepend(tmp->list, heap_value);
+            else
+                *list = g_list_append(*list, heap_value);
+            result = heap_value;
+        }
+    }
+    else
+    if(G_IS_VALUE(out_value))
+        g_value_unset(out_value);
+
+    return result;
+}
+
+
+/* Keeps array, built from an iterator, like gel_params_eval does */
+static
+const GValue* gel_params_keep_array(GelArray *array,
+                                    GList **list, GelParamsTmp *tmp)
+{
+    GValue *value = NULL;
+    if(tmp != NULL && tmp->n_values < GEL_PARAMS_TMP_SIZE)
+        value = tmp->values + tmp->n_values++;
+    else
+    {
+        value = gel_value_new();
+        if(tmp != NULL)
+            tmp->list = g_list_prepend(tmp->list, value);
+        else
+            *list = g_list_append(*list, value);
+    }
+
+    g_value_init(value, GEL_TYPE_ARRAY);
+    g_value_take_boxed(value, array);
+    return value;
 }
 
 
 static
 gboolean gel_context_eval_param(GelContext *self, const gchar *func,
                                 guint *n_values, const GValue **values,
-                                GList **list, gchar format, void ***args)
+                                GList **list, GelParamsTmp *tmp,
+                                gchar format, void ***args)
 {
-    GValue *value = NULL;
     const GValue *result = NULL;
     gboolean parsed = TRUE;
 
@@ -70,9 +203,7 @@ gboolean gel_context_eval_param(GelContext *self, const gchar *func,
             gel_args_pop(args, const GValue *) = *values;
             break;
         case 'V':
-            value = gel_value_new();
-            result =
-                gel_context_eval_param_into_value(self, *values, value);
+            result = gel_params_eval(self, *values, list, tmp);
             if(gel_context_error(self))
                 parsed = FALSE;
             else
@@ -89,9 +220,17 @@ gboolean gel_context_eval_param(GelContext *self, const gchar *func,
             }
             break;
         case 'A':
-            value = gel_value_new();
-            result =
-                gel_context_eval_param_into_value(self, *values, value);
+            result = gel_params_eval(self, *values, list, tmp);
+            if(!gel_context_error(self)
+               && (G_VALUE_HOLDS(result, GEL_TYPE_ITERATOR)
+                   || G_VALUE_HOLDS(result, GEL_TYPE_VECTOR)))
+            {
+                /* natives that need the whole array get the values */
+                GelArray *array = gel_iterator_collect(result, self);
+                if(array != NULL)
+                    result = gel_params_keep_array(array, list, tmp);
+            }
+
             if(gel_context_error(self))
                 parsed = FALSE;
             else
@@ -105,18 +244,16 @@ gboolean gel_context_eval_param(GelContext *self, const gchar *func,
             }
             break;
         case 'H':
-            value = gel_value_new();
-            result =
-                gel_context_eval_param_into_value(self, *values, value);
+            result = gel_params_eval(self, *values, list, tmp);
             if(gel_context_error(self))
                 parsed = FALSE;
             else
-            if(G_VALUE_HOLDS(result, G_TYPE_HASH_TABLE))
+            if(G_VALUE_HOLDS(result, GEL_TYPE_HASH))
                 gel_args_pop(args, void *) = g_value_get_boxed(result);
             else
             {
                 gel_error_value_not_of_type(self,
-                    func, result, G_TYPE_HASH_TABLE);
+                    func, result, GEL_TYPE_HASH);
                 parsed = FALSE;
             }
             break;
@@ -134,15 +271,17 @@ gboolean gel_context_eval_param(GelContext *self, const gchar *func,
             }
             break;
         case 'S':
-            value = gel_value_new();
-            result =
-                gel_context_eval_param_into_value(self, *values, value);
+            result = gel_params_eval(self, *values, list, tmp);
             if(gel_context_error(self))
                 parsed = FALSE;
             else
             if(G_VALUE_HOLDS(result, G_TYPE_STRING))
                 gel_args_pop(args, const gchar *) = g_value_get_string(result);
             else
+            if(G_VALUE_HOLDS(result, GEL_TYPE_ROPE))
+                gel_args_pop(args, const gchar *) =
+                    gel_rope_get_string(g_value_get_boxed(result));
+            else
             {
                 gel_error_value_not_of_type(self,
                     func, result, G_TYPE_STRING);
@@ -150,18 +289,14 @@ gboolean gel_context_eval_param(GelContext *self, const gchar *func,
             }
             break;
         case 'B':
-            value = gel_value_new();
-            result =
-                gel_context_eval_param_into_value(self, *values, value);
+            result = gel_params_eval(self, *values, list, tmp);
             if(gel_context_error(self))
                 parsed = FALSE;
             else
                 gel_args_pop(args, gboolean) = gel_value_to_boolean(result);
             break;
         case 'I':
-            value = gel_value_new();
-            result =
-                gel_context_eval_param_into_value(self, *values, value);
+            result = gel_params_eval(self, *values, list, tmp);
             if(gel_context_error(self))
                 parsed = FALSE;
             else
@@ -183,9 +318,7 @@ gboolean gel_context_eval_param(GelContext *self, const gchar *func,
             }
             break;
         case 'F':
-            value = gel_value_new();
-            result =
-                gel_context_eval_param_into_value(self, *values, value);
+            result = gel_params_eval(self, *values, list, tmp);
             if(gel_context_error(self))
                 parsed = FALSE;
             else
@@ -207,9 +340,7 @@ gboolean gel_context_eval_param(GelContext *self, const gchar *func,
             }
             break;
         case 'G':
-            value = gel_value_new();
-            result =
-                gel_context_eval_param_into_value(self, *values, value);
+            result = gel_params_eval(self, *values, list, tmp);
             if(gel_context_error(self))
                 parsed = FALSE;
             else
@@ -223,9 +354,7 @@ gboolean gel_context_eval_param(GelContext *self, const gchar *func,
             }
             break;
         case 'O':
-            value = gel_value_new();
-            result =
-                gel_context_eval_param_into_value(self, *values, value);
+            result = gel_params_eval(self, *values, list, tmp);
             if(gel_context_error(self))
                 parsed = FALSE;
             else
@@ -239,9 +368,7 @@ gboolean gel_context_eval_param(GelContext *self, const gchar *func,
             }
             break;
         case 'X':
-            value = gel_value_new();
-            result =
-                gel_context_eval_param_into_value(self, *values, value);
+            result = gel_params_eval(self, *values, list, tmp);
             if(gel_context_error(self))
                 parsed = FALSE;
             else
@@ -255,9 +382,7 @@ gboolean gel_context_eval_param(GelContext *self, const gchar *func,
             }
             break;
         case 'C':
-            value = gel_value_new();
-            result =
-                gel_context_eval_param_into_value(self, *values, value);
+            result = gel_params_eval(self, *values, list, tmp);
             if(gel_context_error(self))
                 parsed = FALSE;
             else
@@ -272,14 +397,6 @@ gboolean gel_context_eval_param(GelContext *self, const gchar *func,
             break;
     }
 
-    if(value != NULL)
-    {
-        if(parsed && result == value)
-            *list = g_list_append(*list, value);
-        else
-            gel_value_free(value);
-    }
-
     return parsed;
 }
 
@@ -287,7 +404,8 @@ gboolean gel_context_eval_param(GelContext *self, const gchar *func,
 static
 gboolean gel_context_eval_params_args(GelContext *self, const gchar *func,
                                       guint *n_values, const GValue **values,
-                                      GList **list, GNode *format_node,
+                                      GList **list, GelParamsTmp *tmp,
+                                      const GelParamsSpec *group,
                                       void ***args)
 
 {
@@ -295,29 +413,15 @@ gboolean gel_context_eval_params_args(GelContext *self, const gchar *func,
     g_return_val_if_fail(n_values != NULL, FALSE);
     g_return_val_if_fail(values != NULL, FALSE);
 
-    gboolean exact = TRUE;
-    
-    guint n_args = g_node_n_children(format_node);
-
-    if(n_args > 0)
-    {
-        GNode *last_child = g_node_last_child(format_node);
-        if(g_node_get_int(last_child) == '*')
-        {
-            exact = FALSE;
-            g_node_destroy(last_child);
-            n_args--;
-        }
-    }
-
+    guint n_args = group->n_args;
 
-    if(exact && n_args != *n_values)
+    if(group->exact && n_args != *n_values)
     {
         gel_error_needs_n_arguments(self, func, n_args);
         return FALSE;
     }
 
-    if(!exact && n_args > *n_values)
+    if(!group->exact && n_args > *n_values)
     {
         gel_error_needs_at_least_n_arguments(self, func, n_args);
         return FALSE;
@@ -325,39 +429,35 @@ gboolean gel_context_eval_params_args(GelContext *self, const gchar *func,
 
     gboolean parsed = TRUE;
 
-    GList *o_list = *list;
     guint o_n_values = *n_values;
     const GValue *o_values = *values;
-    GNode *node = g_node_first_child(format_node);
+    const GelParamsSpec *spec = group + 1;
 
-    while(node != 0 && *n_values >= 0 && parsed)
+    for(guint i = 0; i < n_args && parsed; i++)
     {
-        if(G_NODE_IS_LEAF(node))
-        {
-            gchar format = g_node_get_int(node);
+        if(spec->format != '(')
             parsed = gel_context_eval_param(self,
-                func, n_values, values, list, format, args);
-        }
+                func, n_values, values, list, tmp, spec->format, args);
         else
-            if(G_VALUE_HOLDS(*values, GEL_TYPE_ARRAY))
-            {
-                GelArray *array = g_value_get_boxed(*values);
-                guint n_values = gel_array_get_n_values(array);
-                const GValue *values = gel_array_get_values(array);
+        if(G_VALUE_HOLDS(*values, GEL_TYPE_ARRAY))
+        {
+            GelArray *array = g_value_get_boxed(*values);
+            guint n_values = gel_array_get_n_values(array);
+            const GValue *values = gel_array_get_values(array);
 
-                gel_context_eval_params_args(self,
-                    func, &n_values, &values, list, node,  args);
-            }
-            else
-            {
-                gel_error_value_not_of_type(self,
-                    func, *values, GEL_TYPE_ARRAY);
-                parsed = FALSE;
-            }
+            parsed = gel_context_eval_params_args(self,
+                func, &n_values, &values, list, tmp, spec, args);
+        }
+        else
+        {
+            gel_error_value_not_of_type(self,
+                func, *values, GEL_TYPE_ARRAY);
+            parsed = FALSE;
+        }
 
         if(parsed)
         {
-            node = g_node_next_sibling(node);
+            spec += spec->size;
             (*values)++;
             (*n_values)--;
         }
@@ -365,7 +465,6 @@ gboolean gel_context_eval_params_args(GelContext *self, const gchar *func,
 
     if(!parsed)
     {
-        *list = o_list;
         *n_values = o_n_values;
         *values = o_values;
     }
@@ -374,6 +473,24 @@ gboolean gel_context_eval_params_args(GelContext *self, const gchar *func,
 }
 
 
+static
+gboolean gel_context_eval_params_va(GelContext *self, const gchar *func,
+                                    guint *n_values, const GValue **values,
+                                    GList **list, GelParamsTmp *tmp,
+                                    const gchar *format, va_list args_va)
+{
+    const GelParamsFormat *params_format = gel_params_format_get(format);
+    void **args = g_newa(void *, params_format->n_pointers);
+
+    for(guint i = 0; i < params_format->n_pointers; i++)
+        args[i] = va_arg(args_va, void *);
+
+    void **args_iter = args;
+    return gel_context_eval_params_args(self, func,
+        n_values, values, list, tmp, params_format->specs, &args_iter);
+}
+
+
 /**
  * gel_context_eval_params:
  * @self: a #GelContext to evaluate
@@ -385,6 +502,7 @@ gboolean gel_context_eval_params_args(GelContext *self, const gchar *func,
  * @...: The return location for the respective variables
  * 
  * Evaluates an array of #GValue and store the results.
+ * Hashes, requested with 'H', are stored as #GelHash.
  * Any temporary values will be stored in @list.
  * The list must be freed with @gel_list_free.
  *
@@ -395,23 +513,41 @@ gboolean gel_context_eval_params(GelContext *self,const gchar *func,
                                  guint *n_values, const GValue **values,
                                  GList **list, const gchar *format, ...)
 {
-    guint n_args;
-    GNode *format_node = gel_params_parse_format(format, &n_args);
-    void **args = g_new0(void *, n_args);
-
     va_list args_va;
     va_start(args_va, format);
-    for(guint i = 0; i < n_args; i++)
-        args[i] = va_arg(args_va, void *);
+    gboolean parsed = gel_context_eval_params_va(self,
+        func, n_values, values, list, NULL, format, args_va);
     va_end(args_va);
 
-    void **args_iter = args;
-    gboolean parsed = gel_context_eval_params_args(self,
-        func, n_values, values, list, format_node, &args_iter);
+    return parsed;
+}
+
+
+/*
+ * Works like gel_context_eval_params, but keeps the temporary values
+ * in tmp, that must be released with gel_params_tmp_clear.
+ */
+gboolean gel_context_eval_params_tmp(GelContext *self, const gchar *func,
+                                     guint *n_values, const GValue **values,
+                                     GelParamsTmp *tmp,
+                                     const gchar *format, ...)
+{
+    va_list args_va;
+    va_start(args_va, format);
+    gboolean parsed = gel_context_eval_params_va(self,
+        func, n_values, values, NULL, tmp, format, args_va);
+    va_end(args_va);
 
-    g_free(args);
-    g_node_destroy(format_node);
- 
     return parsed;
 }
 
+
+void gel_params_tmp_clear(GelParamsTmp *self)
+{
+    for(guint i = 0; i < self->n_values; i++)
+        g_value_unset(self->values + i);
+    self->n_values = 0;
+
+    gel_list_free(self->list);
+    self->list = NULL;
+}
@@ -4,6 +4,7 @@
 #include <gelcontext.h>
 #include <gelvariable.h>
 #include <gelclosure.h>
+#include <gelsymbol.h>
 
 void gel_context_define_variable(GelContext *self,
                                  const gchar *name, GelVariable *variable);
@@ -22,11 +23,67 @@ const GValue* gel_context_eval_param_into_value(GelContext *self,
 
 GelVariable* gel_context_get_variable(const GelContext *self,
                                       const gchar *name);
+GelVariable* gel_context_get_interned(const GelContext *self,
+                                      const gchar *name);
+GelVariable* gel_context_lookup_interned(const GelContext *self,
+                                         const gchar *name);
+
+GelContext* gel_context_new_frame(GelContext *outer,
+                                  guint n_slots, const gchar *const *names);
+void gel_context_define_slot(GelContext *self, guint slot, GValue *value);
+void gel_context_bind_slot(GelContext *self,
+                           guint slot, GelVariable *variable);
+GelVariable* gel_context_get_slot(const GelContext *self,
+                                  guint depth, guint slot, const gchar *name);
+GelVariable* gel_context_get_defined(const GelContext *self,
+                                     guint depth, const gchar *name);
 
+GelContext* gel_context_get_outer(const GelContext* self);
+gboolean gel_context_has_inner(const GelContext *self);
+gboolean gel_context_inner_are_owned(const GelContext *self);
 void gel_context_set_outer(GelContext *self, GelContext *context);
 void gel_context_set_error(GelContext* self, GError *error);
 void gel_context_transfer_error(GelContext *self, GelContext *context);
+GError* gel_context_take_error(GelContext *self);
+
+/*
+ * Temporary values of gel_context_eval_params_tmp,
+ * kept on the stack of the caller until the buffer is full.
+ */
+#define GEL_PARAMS_TMP_SIZE 8
+#define GEL_PARAMS_TMP_INIT {0, {{0}}, NULL}
+
+typedef struct _GelParamsTmp GelParamsTmp;
+
+struct _GelParamsTmp
+{
+    guint n_values;
+    GValue values[GEL_PARAMS_TMP_SIZE];
+    GList *list;
+};
+
+gboolean gel_context_eval_params_tmp(GelContext *self, const gchar *func,
+                                     guint *n_values, const GValue **values,
+                                     GelParamsTmp *tmp,
+                                     const gchar *format, ...);
+void gel_params_tmp_clear(GelParamsTmp *self);
+
+gboolean gel_context_is_valid(const GelContext *context);
+void gel_context_warn_error(GelContext *self);
+guint gel_context_next_lambda_id(GelContext *self);
+
+guint gel_context_get_version(const GelContext *self);
+GelVariable* gel_context_resolve_local(const GelContext *self,
+                                       const GelSymbol *symbol,
+                                       const GelContext **outermost);
+GelVariable* gel_context_resolve_global(const GelContext *self,
+                                        const GelSymbol *symbol);
+void gel_context_binding_changed(GelContext *self, const gchar *name);
 
-GelContext* gel_context_validate(GelContext *context);
+void gel_context_begin_parallel(GelContext *self);
+void gel_context_end_parallel(GelContext *self);
+gboolean gel_context_is_parallel(const GelContext *self);
+gboolean gel_context_lock(GelContext *self);
+void gel_context_unlock(GelContext *self, gboolean locked);
 
 #endif
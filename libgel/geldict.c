@@ -0,0 +1,557 @@
+#include <geldict.h>
+#include <gelvalue.h>
+#include <gelvalueprivate.h>
+
+
+/*
+ * A dict is a persistent hash: it is never changed, and inserting or
+ * removing a key makes a new dict that shares all but a few nodes with
+ * the old one, so both take O(log n) time and memory.
+ *
+ * The entries are kept in a hash array mapped trie, indexed by 5 bits of
+ * the hash of their keys per level. Each node has a bitmap of the slots
+ * that hold an entry and another of those that hold a child node, and
+ * keeps only the entries and the children present, in the order of
+ * their slots. Keys whose hashes are the same in all their bits end in
+ * a collision node, a plain list of entries below the last level.
+ *
+ * Iterating a dict follows the trie, so the order of the entries is
+ * that of their hashes, not the one they were inserted in.
+ */
+#define GEL_DICT_BITS 5
+#define GEL_DICT_MASK ((1 << GEL_DICT_BITS) - 1)
+#define GEL_DICT_HASH_BITS 32
+
+typedef struct _GelDictEntry GelDictEntry;
+typedef struct _GelDictNode GelDictNode;
+
+struct _GelDictEntry
+{
+    guint hash;
+    GValue key;
+    GValue value;
+};
+
+struct _GelDictNode
+{
+    guint32 datamap;
+    guint32 nodemap;
+    guint n_entries;
+    GelDictEntry *entries;
+    GelDictNode **nodes;
+    volatile gint ref_count;
+};
+
+struct _GelDict
+{
+    GelDictNode *root;
+    guint size;
+    volatile gint ref_count;
+};
+
+
+GType gel_dict_get_type(void)
+{
+    static volatile gsize once = 0;
+    static GType type = G_TYPE_INVALID;
+
+    if(g_once_init_enter(&once))
+    {
+        type = g_boxed_type_register_static("GelDict",
+            (GBoxedCopyFunc)gel_dict_ref,
+            (GBoxedFreeFunc)gel_dict_unref);
+        g_once_init_leave(&once, 1);
+    }
+
+    return type;
+}
+
+
+static
+guint gel_dict_popcount(guint32 bits)
+{
+    bits = bits - ((bits >> 1) & 0x55555555);
+    bits = (bits & 0x33333333) + ((bits >> 2) & 0x33333333);
+    return (((bits + (bits >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+}
+
+
+/* the position of bit among the ones set in bitmap */
+#define gel_dict_index(bitmap, bit) gel_dict_popcount((bitmap) & ((bit) - 1))
+
+
+static
+GelDictNode* gel_dict_node_new(guint32 datamap, guint32 nodemap,
+                               guint n_entries)
+{
+    GelDictNode *node = g_slice_new0(GelDictNode);
+    guint n_nodes = gel_dict_popcount(nodemap);
+
+    node->datamap = datamap;
+    node->nodemap = nodemap;
+    node->n_entries = n_entries;
+    if(n_entries > 0)
+        node->entries = g_new0(GelDictEntry, n_entries);
+    if(n_nodes > 0)
+        node->nodes = g_new0(GelDictNode *, n_nodes);
+    node->ref_count = 1;
+
+    return node;
+}
+
+
+static
+void gel_dict_node_unref(GelDictNode *node)
+{
+    if(g_atomic_int_dec_and_test(&node->ref_count))
+    {
+        for(guint i = 0; i < node->n_entries; i++)
+        {
+            g_value_unset(&node->entries[i].key);
+            g_value_unset(&node->entries[i].value);
+        }
+
+        guint n_nodes = gel_dict_popcount(node->nodemap);
+        for(guint i = 0; i < n_nodes; i++)
+            gel_dict_node_unref(node->nodes[i]);
+
+        g_free(node->entries);
+        g_free(node->nodes);
+        g_slice_free(GelDictNode, node);
+    }
+}
+
+
+static
+GelDictNode* gel_dict_node_ref(GelDictNode *node)
+{
+    g_atomic_int_inc(&node->ref_count);
+    return node;
+}
+
+
+static
+void gel_dict_entry_set(GelDictEntry *entry, guint hash,
+                        const GValue *key, const GValue *value)
+{
+    entry->hash = hash;
+    gel_value_copy(key, &entry->key);
+    gel_value_copy(value, &entry->value);
+}
+
+
+/*
+ * Makes a node with the given bitmaps, copying the entries and the
+ * children of node whose slots are in them, except the one at slot bit,
+ * that is left empty for the caller to fill.
+ */
+static
+GelDictNode* gel_dict_node_edit(const GelDictNode *node,
+                                guint32 datamap, guint32 nodemap, guint32 bit)
+{
+    GelDictNode *copy =
+        gel_dict_node_new(datamap, nodemap, gel_dict_popcount(datamap));
+
+    guint32 entries = node->datamap & datamap & ~bit;
+    guint32 nodes = node->nodemap & nodemap & ~bit;
+
+    for(guint i = 0; i < GEL_DICT_HASH_BITS; i++)
+    {
+        guint32 slot = 1u << i;
+        if(entries & slot)
+        {
+            const GelDictEntry *entry =
+                node->entries + gel_dict_index(node->datamap, slot);
+            gel_dict_entry_set(copy->entries + gel_dict_index(datamap, slot),
+                entry->hash, &entry->key, &entry->value);
+        }
+        else
+        if(nodes & slot)
+            copy->nodes[gel_dict_index(nodemap, slot)] = gel_dict_node_ref(
+                node->nodes[gel_dict_index(node->nodemap, slot)]);
+    }
+
+    return copy;
+}
+
+
+/* Makes a collision node with the entries of node but the one at skip */
+static
+GelDictNode* gel_dict_collision_edit(const GelDictNode *node,
+                                     guint n_entries, guint skip)
+{
+    GelDictNode *copy = gel_dict_node_new(0, 0, n_entries);
+    guint n = 0;
+
+    for(guint i = 0; i < node->n_entries; i++)
+        if(i != skip)
+        {
+            const GelDictEntry *entry = node->entries + i;
+            gel_dict_entry_set(copy->entries + n++,
+                entry->hash, &entry->key, &entry->value);
+        }
+
+    return copy;
+}
+
+
+static
+gint gel_dict_collision_find(const GelDictNode *node, const GValue *key)
+{
+    for(guint i = 0; i < node->n_entries; i++)
+        if(gel_values_eq(&node->entries[i].key, key) == 1)
+            return i;
+    return -1;
+}
+
+
+/* Makes a node at shift with two entries whose keys are different */
+static
+GelDictNode* gel_dict_node_new_pair(const GelDictEntry *entry1,
+                                    guint hash2, const GValue *key2,
+                                    const GValue *value2, guint shift)
+{
+    if(shift >= GEL_DICT_HASH_BITS)
+    {
+        GelDictNode *node = gel_dict_node_new(0, 0, 2);
+        gel_dict_entry_set(node->entries,
+            entry1->hash, &entry1->key, &entry1->value);
+        gel_dict_entry_set(node->entries + 1, hash2, key2, value2);
+        return node;
+    }
+
+    guint32 bit1 = 1u << ((entry1->hash >> shift) & GEL_DICT_MASK);
+    guint32 bit2 = 1u << ((hash2 >> shift) & GEL_DICT_MASK);
+
+    if(bit1 == bit2)
+    {
+        GelDictNode *node = gel_dict_node_new(0, bit1, 0);
+        node->nodes[0] = gel_dict_node_new_pair(entry1,
+            hash2, key2, value2, shift + GEL_DICT_BITS);
+        return node;
+    }
+
+    GelDictNode *node = gel_dict_node_new(bit1 | bit2, 0, 2);
+    gel_dict_entry_set(node->entries + (bit1 < bit2 ? 0 : 1),
+        entry1->hash, &entry1->key, &entry1->value);
+    gel_dict_entry_set(node->entries + (bit1 < bit2 ? 1 : 0),
+        hash2, key2, value2);
+
+    return node;
+}
+
+
+static
+GelDictNode* gel_dict_node_insert(const GelDictNode *node, guint hash,
+                                  const GValue *key, const GValue *value,
+                                  guint shift, gboolean *added)
+{
+    if(shift >= GEL_DICT_HASH_BITS)
+    {
+        gint index = gel_dict_collision_find(node, key);
+        GelDictNode *copy;
+
+        if(index >= 0)
+        {
+            /* the entry being replaced goes last */
+            copy = gel_dict_collision_edit(node, node->n_entries, index);
+            gel_dict_entry_set(copy->entries + node->n_entries - 1,
+                hash, key, value);
+        }
+        else
+        {
+            copy = gel_dict_collision_edit(node,
+                node->n_entries + 1, G_MAXUINT);
+            gel_dict_entry_set(copy->entries + node->n_entries,
+                hash, key, value);
+            *added = TRUE;
+        }
+
+        return copy;
+    }
+
+    guint32 bit = 1u << ((hash >> shift) & GEL_DICT_MASK);
+    GelDictNode *copy;
+
+    if(node->datamap & bit)
+    {
+        const GelDictEntry *entry =
+            node->entries + gel_dict_index(node->datamap, bit);
+
+        if(entry->hash == hash && gel_values_eq(&entry->key, key) == 1)
+        {
+            copy = gel_dict_node_edit(node, node->datamap, node->nodemap, bit);
+            gel_dict_entry_set(copy->entries + gel_dict_index(node->datamap, bit),
+                hash, key, value);
+        }
+        else
+        {
+            copy = gel_dict_node_edit(node,
+                node->datamap & ~bit, node->nodemap | bit, bit);
+            copy->nodes[gel_dict_index(copy->nodemap, bit)] =
+                gel_dict_node_new_pair(entry,
+                    hash, key, value, shift + GEL_DICT_BITS);
+            *added = TRUE;
+        }
+    }
+    else
+    if(node->nodemap & bit)
+    {
+        guint index = gel_dict_index(node->nodemap, bit);
+        copy = gel_dict_node_edit(node, node->datamap, node->nodemap, bit);
+        copy->nodes[index] = gel_dict_node_insert(node->nodes[index],
+            hash, key, value, shift + GEL_DICT_BITS, added);
+    }
+    else
+    {
+        copy = gel_dict_node_edit(node,
+            node->datamap | bit, node->nodemap, bit);
+        gel_dict_entry_set(copy->entries + gel_dict_index(copy->datamap, bit),
+            hash, key, value);
+        *added = TRUE;
+    }
+
+    return copy;
+}
+
+
+/*
+ * Returns a node without key, that may be left with no entries,
+ * or NULL if key is not in node.
+ */
+static
+GelDictNode* gel_dict_node_remove(const GelDictNode *node, guint hash,
+                                  const GValue *key, guint shift)
+{
+    if(shift >= GEL_DICT_HASH_BITS)
+    {
+        gint index = gel_dict_collision_find(node, key);
+        if(index < 0)
+            return NULL;
+
+        return gel_dict_collision_edit(node, node->n_entries - 1, index);
+    }
+
+    guint32 bit = 1u << ((hash >> shift) & GEL_DICT_MASK);
+
+    if(node->datamap & bit)
+    {
+        const GelDictEntry *entry =
+            node->entries + gel_dict_index(node->datamap, bit);
+
+        if(entry->hash != hash || gel_values_eq(&entry->key, key) != 1)
+            return NULL;
+
+        return gel_dict_node_edit(node,
+            node->datamap & ~bit, node->nodemap, bit);
+    }
+
+    if(!(node->nodemap & bit))
+        return NULL;
+
+    guint index = gel_dict_index(node->nodemap, bit);
+    GelDictNode *child = gel_dict_node_remove(node->nodes[index],
+        hash, key, shift + GEL_DICT_BITS);
+    if(child == NULL)
+        return NULL;
+
+    GelDictNode *copy;
+
+    if(child->nodemap == 0 && child->n_entries == 0)
+        copy = gel_dict_node_edit(node,
+            node->datamap, node->nodemap & ~bit, bit);
+    else
+    if(child->nodemap == 0 && child->n_entries == 1)
+    {
+        /* a single entry moves up in place of its node */
+        const GelDictEntry *entry = child->entries;
+        copy = gel_dict_node_edit(node,
+            node->datamap | bit, node->nodemap & ~bit, bit);
+        gel_dict_entry_set(copy->entries + gel_dict_index(copy->datamap, bit),
+            entry->hash, &entry->key, &entry->value);
+    }
+    else
+    {
+        copy = gel_dict_node_edit(node, node->datamap, node->nodemap, bit);
+        copy->nodes[index] = child;
+        return copy;
+    }
+
+    gel_dict_node_unref(child);
+    return copy;
+}
+
+
+GelDict* gel_dict_new(void)
+{
+    GelDict *self = g_slice_new0(GelDict);
+    self->root = gel_dict_node_new(0, 0, 0);
+    self->ref_count = 1;
+
+    return self;
+}
+
+
+GelDict* gel_dict_ref(GelDict *self)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+
+    g_atomic_int_inc(&self->ref_count);
+    return self;
+}
+
+
+void gel_dict_unref(GelDict *self)
+{
+    g_return_if_fail(self != NULL);
+
+    if(g_atomic_int_dec_and_test(&self->ref_count))
+    {
+        gel_dict_node_unref(self->root);
+        g_slice_free(GelDict, self);
+    }
+}
+
+
+guint gel_dict_get_size(const GelDict *self)
+{
+    return self->size;
+}
+
+
+const GValue* gel_dict_lookup(const GelDict *self, const GValue *key)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+    g_return_val_if_fail(G_IS_VALUE(key), NULL);
+
+    const GelDictNode *node = self->root;
+    guint hash = gel_value_hash(key);
+
+    for(guint shift = 0;; shift += GEL_DICT_BITS)
+    {
+        if(shift >= GEL_DICT_HASH_BITS)
+        {
+            gint index = gel_dict_collision_find(node, key);
+            return index >= 0 ? &node->entries[index].value : NULL;
+        }
+
+        guint32 bit = 1u << ((hash >> shift) & GEL_DICT_MASK);
+
+        if(node->datamap & bit)
+        {
+            const GelDictEntry *entry =
+                node->entries + gel_dict_index(node->datamap, bit);
+
+            if(entry->hash == hash && gel_values_eq(&entry->key, key) == 1)
+                return &entry->value;
+            return NULL;
+        }
+
+        if(!(node->nodemap & bit))
+            return NULL;
+
+        node = node->nodes[gel_dict_index(node->nodemap, bit)];
+    }
+}
+
+
+GelDict* gel_dict_insert(const GelDict *self,
+                         const GValue *key, const GValue *value)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+    g_return_val_if_fail(G_IS_VALUE(key), NULL);
+    g_return_val_if_fail(G_IS_VALUE(value), NULL);
+
+    GelDict *result = g_slice_new0(GelDict);
+    gboolean added = FALSE;
+
+    result->root = gel_dict_node_insert(self->root,
+        gel_value_hash(key), key, value, 0, &added);
+    result->size = self->size + (added ? 1 : 0);
+    result->ref_count = 1;
+
+    return result;
+}
+
+
+GelDict* gel_dict_remove(const GelDict *self, const GValue *key)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+    g_return_val_if_fail(G_IS_VALUE(key), NULL);
+
+    GelDictNode *root =
+        gel_dict_node_remove(self->root, gel_value_hash(key), key, 0);
+    if(root == NULL)
+        return gel_dict_ref((GelDict *)self);
+
+    GelDict *result = g_slice_new0(GelDict);
+    result->root = root;
+    result->size = self->size - 1;
+    result->ref_count = 1;
+
+    return result;
+}
+
+
+GelDict* gel_dict_merge(const GelDict *self, const GelDict *other)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+    g_return_val_if_fail(other != NULL, NULL);
+
+    GelDict *result = gel_dict_ref((GelDict *)self);
+    GelDictIter iter;
+    const GValue *key;
+    const GValue *value;
+
+    gel_dict_iter_init(&iter, other);
+    while(gel_dict_iter_next(&iter, &key, &value))
+    {
+        GelDict *tmp = gel_dict_insert(result, key, value);
+        gel_dict_unref(result);
+        result = tmp;
+    }
+
+    return result;
+}
+
+
+void gel_dict_iter_init(GelDictIter *iter, const GelDict *dict)
+{
+    iter->nodes[0] = dict->root;
+    iter->positions[0] = 0;
+    iter->depth = 0;
+}
+
+
+/* Each node yields its own entries before the ones of its children */
+gboolean gel_dict_iter_next(GelDictIter *iter,
+                            const GValue **key, const GValue **value)
+{
+    while(iter->depth >= 0)
+    {
+        const GelDictNode *node = iter->nodes[iter->depth];
+        guint position = iter->positions[iter->depth]++;
+
+        if(position < node->n_entries)
+        {
+            if(key != NULL)
+                *key = &node->entries[position].key;
+            if(value != NULL)
+                *value = &node->entries[position].value;
+            return TRUE;
+        }
+
+        position -= node->n_entries;
+        if(position < gel_dict_popcount(node->nodemap))
+        {
+            iter->depth++;
+            iter->nodes[iter->depth] = node->nodes[position];
+            iter->positions[iter->depth] = 0;
+        }
+        else
+            iter->depth--;
+    }
+
+    return FALSE;
+}
+
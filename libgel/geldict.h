@@ -0,0 +1,39 @@
+#ifndef __GEL_DICT_H__
+#define __GEL_DICT_H__
+
+#include <glib-object.h>
+
+#define GEL_TYPE_DICT (gel_dict_get_type())
+
+typedef struct _GelDict GelDict;
+GType gel_dict_get_type(void) G_GNUC_CONST;
+
+GelDict* gel_dict_new(void);
+GelDict* gel_dict_ref(GelDict *self);
+void gel_dict_unref(GelDict *self);
+
+guint gel_dict_get_size(const GelDict *self);
+const GValue* gel_dict_lookup(const GelDict *self, const GValue *key);
+
+GelDict* gel_dict_insert(const GelDict *self,
+                         const GValue *key, const GValue *value);
+GelDict* gel_dict_remove(const GelDict *self, const GValue *key);
+GelDict* gel_dict_merge(const GelDict *self, const GelDict *other);
+
+#define GEL_DICT_MAX_DEPTH 8
+
+typedef struct _GelDictIter GelDictIter;
+
+struct _GelDictIter
+{
+    gconstpointer nodes[GEL_DICT_MAX_DEPTH];
+    guint positions[GEL_DICT_MAX_DEPTH];
+    gint depth;
+};
+
+void gel_dict_iter_init(GelDictIter *iter, const GelDict *dict);
+gboolean gel_dict_iter_next(GelDictIter *iter,
+                            const GValue **key, const GValue **value);
+
+#endif
+
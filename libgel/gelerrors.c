@@ -158,3 +158,11 @@ void gel_error_incompatible(GelContext *context, const gchar *f,
     g_free(s1);
     g_free(s2);
 }
+
+
+void gel_error_division_by_zero(GelContext *context, const gchar *f)
+{
+    gel_context_set_error(context, g_error_new(
+        GEL_CONTEXT_ERROR, GEL_CONTEXT_ERROR_ARGUMENTS,
+        "%s: Division by zero", f));
+}
@@ -49,5 +49,7 @@ void gel_error_expected(GelContext *context,
 void gel_error_incompatible(GelContext *context, const gchar *f,
                             const GValue *v1, const GValue *v2);
 
+void gel_error_division_by_zero(GelContext *context, const gchar *f);
+
 #endif
 
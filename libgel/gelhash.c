@@ -0,0 +1,421 @@
+#include <string.h>
+
+#include <gelhash.h>
+#include <gelvalue.h>
+#include <gelvalueprivate.h>
+
+
+/*
+ * A hash keeps its entries, with the key and the value inline, in an array
+ * in the order they were inserted, so it costs no allocation per entry and
+ * is iterated in insertion order. An open addressing table of indexes,
+ * probed linearly, finds the entries by the hash of their keys, computed
+ * with gel_value_hash and kept in the entry.
+ *
+ * Removing an entry leaves a hole in the array and a tombstone in the
+ * table, both dropped the next time the table is rebuilt. Iterators walk
+ * the array by index up to the entries it had when they started, so
+ * changing a hash while iterating it is safe: removed entries are skipped
+ * and new ones are not seen. While an iterator is live, n_iters is not
+ * zero and rebuilding keeps the holes, so no entry moves under it. An
+ * iterator stops being live when it reaches the end or is cleared.
+ */
+typedef struct _GelHashEntry GelHashEntry;
+
+struct _GelHashEntry
+{
+    guint hash;
+    GValue key;
+    GValue value;
+};
+
+struct _GelHash
+{
+    GelHashEntry *entries;
+    guint n_entries;
+    guint max_entries;
+    guint size;
+    gint *indexes;
+    guint mask;
+    volatile gint n_iters;
+    volatile gint ref_count;
+};
+
+#define GEL_HASH_EMPTY (-1)
+#define GEL_HASH_REMOVED (-2)
+
+/* the table of indexes is kept at most two thirds full, with tombstones */
+#define GEL_HASH_MIN_INDEXES 8
+
+
+GType gel_hash_get_type(void)
+{
+    static volatile gsize once = 0;
+    static GType type = G_TYPE_INVALID;
+
+    if(g_once_init_enter(&once))
+    {
+        type = g_boxed_type_register_static("GelHash",
+            (GBoxedCopyFunc)gel_hash_ref,
+            (GBoxedFreeFunc)gel_hash_unref);
+        g_once_init_leave(&once, 1);
+    }
+
+    return type;
+}
+
+
+static
+guint gel_hash_indexes_for(guint n_entries)
+{
+    guint n_indexes = GEL_HASH_MIN_INDEXES;
+    while(n_indexes * 2 < n_entries * 3)
+        n_indexes *= 2;
+    return n_indexes;
+}
+
+
+/**
+ * SECTION:gelhash
+ * @short_description: Class used to keep a hash of #GValue
+ * @title: GelHash
+ * @include: gel.h
+ *
+ * Class used to keep the keys and values of the hashes of gel,
+ * in the order they were inserted.
+ * The hashes received by natives with the format 'H' are #GelHash.
+ */
+
+/**
+ * gel_hash_new:
+ * @n_prealloced: number of entries to make room for, the initial size is 0
+ *
+ * Creates an empty #GelHash
+ *
+ * Returns: A new #GelHash
+ */
+GelHash* gel_hash_new(guint n_prealloced)
+{
+    GelHash *self = g_slice_new0(GelHash);
+    guint n_indexes = gel_hash_indexes_for(n_prealloced + 1);
+
+    self->max_entries = n_indexes * 2 / 3;
+    self->entries = g_new0(GelHashEntry, self->max_entries);
+    self->indexes = g_new(gint, n_indexes);
+    memset(self->indexes, 0xff, n_indexes * sizeof(gint));
+    self->mask = n_indexes - 1;
+    self->ref_count = 1;
+
+    return self;
+}
+
+
+/**
+ * gel_hash_ref:
+ * @self: a #GelHash
+ *
+ * Increments the reference count of @self
+ *
+ * Returns: @self
+ */
+GelHash* gel_hash_ref(GelHash *self)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+
+    g_atomic_int_inc(&self->ref_count);
+    return self;
+}
+
+
+/**
+ * gel_hash_unref:
+ * @self: a #GelHash
+ *
+ * Decrements the reference count of @self, freeing it when it reaches 0
+ */
+void gel_hash_unref(GelHash *self)
+{
+    g_return_if_fail(self != NULL);
+
+    if(g_atomic_int_dec_and_test(&self->ref_count))
+    {
+        for(guint i = 0; i < self->n_entries; i++)
+            if(G_IS_VALUE(&self->entries[i].key))
+            {
+                g_value_unset(&self->entries[i].key);
+                g_value_unset(&self->entries[i].value);
+            }
+
+        g_free(self->entries);
+        g_free(self->indexes);
+        g_slice_free(GelHash, self);
+    }
+}
+
+
+/**
+ * gel_hash_get_size:
+ * @self: a #GelHash
+ *
+ * Returns: the number of entries in @self
+ */
+guint gel_hash_get_size(const GelHash *self)
+{
+    return self->size;
+}
+
+
+/*
+ * Returns the slot of the table with the index of the entry for key,
+ * or the slot where it would be inserted if it is not there.
+ */
+static
+guint gel_hash_find_slot(const GelHash *self, const GValue *key, guint hash)
+{
+    guint slot = hash & self->mask;
+    guint free_slot = G_MAXUINT;
+
+    for(;; slot = (slot + 1) & self->mask)
+    {
+        gint index = self->indexes[slot];
+
+        if(index == GEL_HASH_EMPTY)
+            return free_slot != G_MAXUINT ? free_slot : slot;
+
+        if(index == GEL_HASH_REMOVED)
+        {
+            if(free_slot == G_MAXUINT)
+                free_slot = slot;
+        }
+        else
+        {
+            const GelHashEntry *entry = self->entries + index;
+            if(entry->hash == hash && gel_values_eq(&entry->key, key) == 1)
+                return slot;
+        }
+    }
+}
+
+
+/*
+ * Compacts the entries and rebuilds a table for at least n_entries,
+ * or for one more entry than it has if it is being iterated.
+ */
+static
+void gel_hash_rebuild(GelHash *self, guint n_entries)
+{
+    guint n = 0;
+    if(g_atomic_int_get(&self->n_iters) == 0)
+    {
+        for(guint i = 0; i < self->n_entries; i++)
+            if(G_IS_VALUE(&self->entries[i].key))
+                self->entries[n++] = self->entries[i];
+        self->n_entries = n;
+    }
+    else
+    {
+        n = self->n_entries;
+        n_entries = MAX(n_entries, n + 1);
+    }
+
+    guint n_indexes = gel_hash_indexes_for(n_entries);
+    if(n_indexes - 1 != self->mask)
+    {
+        self->indexes = g_renew(gint, self->indexes, n_indexes);
+        self->mask = n_indexes - 1;
+    }
+    memset(self->indexes, 0xff, n_indexes * sizeof(gint));
+
+    for(guint i = 0; i < n; i++)
+    {
+        if(!G_IS_VALUE(&self->entries[i].key))
+            continue;
+
+        guint slot = self->entries[i].hash & self->mask;
+        while(self->indexes[slot] != GEL_HASH_EMPTY)
+            slot = (slot + 1) & self->mask;
+        self->indexes[slot] = i;
+    }
+
+    guint max_entries = n_indexes * 2 / 3;
+    if(max_entries != self->max_entries)
+    {
+        self->entries = g_renew(GelHashEntry, self->entries, max_entries);
+        self->max_entries = max_entries;
+    }
+
+    /* entries moved down left copies of their values behind */
+    memset(self->entries + n, 0, (max_entries - n) * sizeof(GelHashEntry));
+}
+
+
+/**
+ * gel_hash_lookup:
+ * @self: a #GelHash
+ * @key: the #GValue to look for
+ *
+ * Looks up the value of @key in @self
+ *
+ * Returns: the value of @key, owned by @self, or #NULL if it is not there
+ */
+const GValue* gel_hash_lookup(const GelHash *self, const GValue *key)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+    g_return_val_if_fail(G_IS_VALUE(key), NULL);
+
+    guint slot = gel_hash_find_slot(self, key, gel_value_hash(key));
+    gint index = self->indexes[slot];
+
+    return index >= 0 ? &self->entries[index].value : NULL;
+}
+
+
+/**
+ * gel_hash_insert:
+ * @self: a #GelHash
+ * @key: the key of the entry
+ * @value: the value of the entry
+ *
+ * Inserts a copy of @key and @value in @self,
+ * replacing the value of @key if it was already there
+ */
+void gel_hash_insert(GelHash *self, const GValue *key, const GValue *value)
+{
+    g_return_if_fail(self != NULL);
+    g_return_if_fail(G_IS_VALUE(key));
+    g_return_if_fail(G_IS_VALUE(value));
+
+    guint hash = gel_value_hash(key);
+    guint slot = gel_hash_find_slot(self, key, hash);
+    gint index = self->indexes[slot];
+
+    if(index >= 0)
+    {
+        GValue *entry_value = &self->entries[index].value;
+        GValue tmp_value = {0};
+
+        /* value may be the one being replaced */
+        gel_value_copy(value, &tmp_value);
+        g_value_unset(entry_value);
+        *entry_value = tmp_value;
+        return;
+    }
+
+    if(self->n_entries == self->max_entries)
+    {
+        /* removed entries are reused before the table grows */
+        gel_hash_rebuild(self, self->size + 1);
+        slot = gel_hash_find_slot(self, key, hash);
+    }
+
+    GelHashEntry *entry = self->entries + self->n_entries;
+    entry->hash = hash;
+    gel_value_copy(key, &entry->key);
+    gel_value_copy(value, &entry->value);
+
+    self->indexes[slot] = self->n_entries++;
+    self->size++;
+}
+
+
+/**
+ * gel_hash_remove:
+ * @self: a #GelHash
+ * @key: the key of the entry to remove
+ *
+ * Removes the entry of @key from @self
+ *
+ * Returns: #TRUE if @key was found, #FALSE otherwise
+ */
+gboolean gel_hash_remove(GelHash *self, const GValue *key)
+{
+    g_return_val_if_fail(self != NULL, FALSE);
+    g_return_val_if_fail(G_IS_VALUE(key), FALSE);
+
+    guint slot = gel_hash_find_slot(self, key, gel_value_hash(key));
+    gint index = self->indexes[slot];
+
+    if(index < 0)
+        return FALSE;
+
+    GelHashEntry *entry = self->entries + index;
+    g_value_unset(&entry->key);
+    g_value_unset(&entry->value);
+
+    self->indexes[slot] = GEL_HASH_REMOVED;
+    self->size--;
+
+    return TRUE;
+}
+
+
+/**
+ * gel_hash_iter_init:
+ * @iter: the #GelHashIter to initialize
+ * @hash: the #GelHash to iterate
+ *
+ * Initializes @iter to walk the entries of @hash in insertion order.
+ * The entries inserted while iterating are not seen,
+ * the removed ones are skipped.
+ */
+void gel_hash_iter_init(GelHashIter *iter, const GelHash *hash)
+{
+    iter->hash = hash;
+    iter->index = 0;
+    iter->end = hash->n_entries;
+
+    g_atomic_int_inc(&((GelHash *)hash)->n_iters);
+}
+
+
+/**
+ * gel_hash_iter_clear:
+ * @iter: a #GelHashIter
+ *
+ * Releases @iter, needed only if it is left before
+ * #gel_hash_iter_next returns #FALSE
+ */
+void gel_hash_iter_clear(GelHashIter *iter)
+{
+    if(iter->hash != NULL)
+    {
+        g_atomic_int_add(&((GelHash *)iter->hash)->n_iters, -1);
+        iter->hash = NULL;
+    }
+}
+
+
+/**
+ * gel_hash_iter_next:
+ * @iter: a #GelHashIter
+ * @key: (allow-none): location of the key of the next entry
+ * @value: (allow-none): location of the value of the next entry
+ *
+ * Advances @iter to the next entry
+ *
+ * Returns: #FALSE once there are no more entries, #TRUE otherwise
+ */
+gboolean gel_hash_iter_next(GelHashIter *iter,
+                            const GValue **key, const GValue **value)
+{
+    const GelHash *hash = iter->hash;
+    if(hash == NULL)
+        return FALSE;
+
+    while(iter->index < iter->end)
+    {
+        const GelHashEntry *entry = hash->entries + iter->index++;
+        if(G_IS_VALUE(&entry->key))
+        {
+            if(key != NULL)
+                *key = &entry->key;
+            if(value != NULL)
+                *value = &entry->value;
+            return TRUE;
+        }
+    }
+
+    gel_hash_iter_clear(iter);
+    return FALSE;
+}
+
@@ -0,0 +1,35 @@
+#ifndef __GEL_HASH_H__
+#define __GEL_HASH_H__
+
+#include <glib-object.h>
+
+#define GEL_TYPE_HASH (gel_hash_get_type())
+
+typedef struct _GelHash GelHash;
+GType gel_hash_get_type(void) G_GNUC_CONST;
+
+GelHash* gel_hash_new(guint n_prealloced);
+GelHash* gel_hash_ref(GelHash *self);
+void gel_hash_unref(GelHash *self);
+
+guint gel_hash_get_size(const GelHash *self);
+const GValue* gel_hash_lookup(const GelHash *self, const GValue *key);
+void gel_hash_insert(GelHash *self, const GValue *key, const GValue *value);
+gboolean gel_hash_remove(GelHash *self, const GValue *key);
+
+typedef struct _GelHashIter GelHashIter;
+
+struct _GelHashIter
+{
+    const GelHash *hash;
+    guint index;
+    guint end;
+};
+
+void gel_hash_iter_init(GelHashIter *iter, const GelHash *hash);
+void gel_hash_iter_clear(GelHashIter *iter);
+gboolean gel_hash_iter_next(GelHashIter *iter,
+                            const GValue **key, const GValue **value);
+
+#endif
+
@@ -0,0 +1,441 @@
+#include <string.h>
+
+#include <geliterator.h>
+#include <geltypedarray.h>
+#include <gelhash.h>
+#include <gelvector.h>
+#include <geldict.h>
+#include <gelvalue.h>
+#include <gelvalueprivate.h>
+
+
+/*
+ * An iterator is a lazy sequence of values: a range of integers, a view of
+ * an array, a hash or a typed array, a generator closure, or the mapping or
+ * filtering of other iterables. Like a typed array it is immutable and
+ * copying it only takes a reference.
+ *
+ * Values are produced one at a time by a cursor, so a loop over an
+ * iterator never builds the whole sequence. Each cursor starts from the
+ * beginning, so ranges and views can be iterated many times, while a
+ * generator goes on from wherever its closure left.
+ *
+ * Iterables are arrays, hashes, typed arrays, vectors, dicts and iterators.
+ * Hashes and dicts yield arrays of a key and its value, a hash in the order
+ * they were inserted.
+ */
+typedef enum
+{
+    GEL_ITERATOR_RANGE,
+    GEL_ITERATOR_VIEW,
+    GEL_ITERATOR_GENERATOR,
+    GEL_ITERATOR_MAP,
+    GEL_ITERATOR_FILTER
+} GelIteratorKind;
+
+struct _GelIterator
+{
+    GelIteratorKind kind;
+    gint64 first;
+    gint64 last;
+    GClosure *closure;
+    guint n_sources;
+    GValue *sources;
+    volatile gint ref_count;
+};
+
+struct _GelIteratorCursor
+{
+    GValue source;
+    GelIterator *iterator;
+    GelHashIter hash_iter;
+    GelDictIter dict_iter;
+    guint index;
+    gint64 next;
+    GelIteratorCursor **cursors;
+};
+
+
+GType gel_iterator_get_type(void)
+{
+    static volatile gsize once = 0;
+    static GType type = G_TYPE_INVALID;
+
+    if(g_once_init_enter(&once))
+    {
+        type = g_boxed_type_register_static("GelIterator",
+            (GBoxedCopyFunc)gel_iterator_ref,
+            (GBoxedFreeFunc)gel_iterator_unref);
+        g_once_init_leave(&once, 1);
+    }
+
+    return type;
+}
+
+
+static
+GelIterator* gel_iterator_new(GelIteratorKind kind, GClosure *closure,
+                              guint n_sources, const GValue *sources)
+{
+    GelIterator *self = g_slice_new0(GelIterator);
+    self->kind = kind;
+    self->ref_count = 1;
+
+    if(closure != NULL)
+    {
+        self->closure = g_closure_ref(closure);
+        g_closure_sink(closure);
+    }
+
+    if(n_sources > 0)
+    {
+        self->n_sources = n_sources;
+        self->sources = g_new0(GValue, n_sources);
+        for(guint i = 0; i < n_sources; i++)
+            gel_value_copy(sources + i, self->sources + i);
+    }
+
+    return self;
+}
+
+
+GelIterator* gel_iterator_new_range(gint64 first, gint64 last)
+{
+    GelIterator *self = gel_iterator_new(GEL_ITERATOR_RANGE, NULL, 0, NULL);
+    self->first = first;
+    self->last = last;
+
+    return self;
+}
+
+
+GelIterator* gel_iterator_new_view(const GValue *value)
+{
+    g_return_val_if_fail(gel_value_is_iterable(value), NULL);
+
+    return gel_iterator_new(GEL_ITERATOR_VIEW, NULL, 1, value);
+}
+
+
+GelIterator* gel_iterator_new_generator(GClosure *closure)
+{
+    g_return_val_if_fail(closure != NULL, NULL);
+
+    return gel_iterator_new(GEL_ITERATOR_GENERATOR, closure, 0, NULL);
+}
+
+
+GelIterator* gel_iterator_new_map(GClosure *closure,
+                                  guint n_sources, const GValue *sources)
+{
+    g_return_val_if_fail(closure != NULL, NULL);
+    g_return_val_if_fail(n_sources > 0, NULL);
+
+    return gel_iterator_new(GEL_ITERATOR_MAP, closure, n_sources, sources);
+}
+
+
+GelIterator* gel_iterator_new_filter(GClosure *closure, const GValue *source)
+{
+    g_return_val_if_fail(closure != NULL, NULL);
+    g_return_val_if_fail(gel_value_is_iterable(source), NULL);
+
+    return gel_iterator_new(GEL_ITERATOR_FILTER, closure, 1, source);
+}
+
+
+GelIterator* gel_iterator_ref(GelIterator *self)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+
+    g_atomic_int_inc(&self->ref_count);
+    return self;
+}
+
+
+void gel_iterator_unref(GelIterator *self)
+{
+    g_return_if_fail(self != NULL);
+
+    if(g_atomic_int_dec_and_test(&self->ref_count))
+    {
+        if(self->closure != NULL)
+            g_closure_unref(self->closure);
+
+        for(guint i = 0; i < self->n_sources; i++)
+            g_value_unset(self->sources + i);
+        g_free(self->sources);
+
+        g_slice_free(GelIterator, self);
+    }
+}
+
+
+gchar* gel_iterator_to_string(const GelIterator *self)
+{
+    if(self->kind == GEL_ITERATOR_RANGE)
+        return g_strdup_printf(
+            "(iter %" G_GINT64_FORMAT " %" G_GINT64_FORMAT ")",
+            self->first, self->last);
+
+    return g_strdup("(iterator)");
+}
+
+
+gboolean gel_value_is_iterable(const GValue *value)
+{
+    return G_VALUE_HOLDS(value, GEL_TYPE_ARRAY)
+        || G_VALUE_HOLDS(value, GEL_TYPE_HASH)
+        || G_VALUE_HOLDS(value, GEL_TYPE_TYPED_ARRAY)
+        || G_VALUE_HOLDS(value, GEL_TYPE_VECTOR)
+        || G_VALUE_HOLDS(value, GEL_TYPE_DICT)
+        || G_VALUE_HOLDS(value, GEL_TYPE_ITERATOR);
+}
+
+
+/*
+ * Returns a cursor at the beginning of iterable,
+ * or NULL if it is not iterable.
+ */
+GelIteratorCursor* gel_iterator_cursor_new(const GValue *iterable)
+{
+    if(!gel_value_is_iterable(iterable))
+        return NULL;
+
+    GelIteratorCursor *self = g_slice_new0(GelIteratorCursor);
+    gel_value_copy(iterable, &self->source);
+
+    if(G_VALUE_HOLDS(iterable, GEL_TYPE_HASH))
+        gel_hash_iter_init(&self->hash_iter, g_value_get_boxed(iterable));
+    else
+    if(G_VALUE_HOLDS(iterable, GEL_TYPE_DICT))
+        gel_dict_iter_init(&self->dict_iter, g_value_get_boxed(iterable));
+    else
+    if(G_VALUE_HOLDS(iterable, GEL_TYPE_ITERATOR))
+    {
+        GelIterator *iterator = g_value_get_boxed(iterable);
+        self->iterator = iterator;
+        self->next = iterator->first;
+
+        if(iterator->n_sources > 0)
+        {
+            self->cursors = g_new0(GelIteratorCursor *, iterator->n_sources);
+            for(guint i = 0; i < iterator->n_sources; i++)
+                self->cursors[i] =
+                    gel_iterator_cursor_new(iterator->sources + i);
+        }
+    }
+
+    return self;
+}
+
+
+void gel_iterator_cursor_free(GelIteratorCursor *self)
+{
+    g_return_if_fail(self != NULL);
+
+    if(self->cursors != NULL)
+    {
+        for(guint i = 0; i < self->iterator->n_sources; i++)
+            gel_iterator_cursor_free(self->cursors[i]);
+        g_free(self->cursors);
+    }
+
+    gel_hash_iter_clear(&self->hash_iter);
+    g_value_unset(&self->source);
+    g_slice_free(GelIteratorCursor, self);
+}
+
+
+static
+gboolean gel_iterator_cursor_next_map(GelIteratorCursor *self, GValue *value,
+                                      GelContext *context)
+{
+    const guint n_sources = self->iterator->n_sources;
+    GValue *args = g_newa(GValue, n_sources);
+    gboolean result = FALSE;
+    gboolean running = TRUE;
+
+    /* like map, calls that return nothing do not count */
+    while(running && !result)
+    {
+        memset(args, 0, n_sources * sizeof(GValue));
+
+        for(guint i = 0; i < n_sources && running; i++)
+            running = gel_iterator_cursor_next(self->cursors[i],
+                args + i, context);
+
+        if(running)
+        {
+            g_closure_invoke(self->iterator->closure,
+                value, n_sources, args, context);
+            result = G_IS_VALUE(value);
+            running = !gel_context_error(context);
+        }
+
+        for(guint i = 0; i < n_sources; i++)
+            if(G_IS_VALUE(args + i))
+                g_value_unset(args + i);
+    }
+
+    if(result && !running)
+    {
+        g_value_unset(value);
+        result = FALSE;
+    }
+
+    return result;
+}
+
+
+static
+gboolean gel_iterator_cursor_next_filter(GelIteratorCursor *self,
+                                         GValue *value, GelContext *context)
+{
+    while(gel_iterator_cursor_next(self->cursors[0], value, context))
+    {
+        GValue tmp_value = {0};
+        g_closure_invoke(self->iterator->closure,
+            &tmp_value, 1, value, context);
+
+        gboolean keep = gel_value_to_boolean(&tmp_value);
+        if(G_IS_VALUE(&tmp_value))
+            g_value_unset(&tmp_value);
+
+        if(keep && !gel_context_error(context))
+            return TRUE;
+
+        g_value_unset(value);
+        if(gel_context_error(context))
+            break;
+    }
+
+    return FALSE;
+}
+
+
+static
+gboolean gel_iterator_cursor_next_iterator(GelIteratorCursor *self,
+                                           GValue *value, GelContext *context)
+{
+    GelIterator *iterator = self->iterator;
+
+    switch(iterator->kind)
+    {
+        case GEL_ITERATOR_RANGE:
+            if(self->next == iterator->last)
+                return FALSE;
+
+            g_value_init(value, G_TYPE_INT64);
+            g_value_set_int64(value, self->next);
+            self->next += iterator->last > iterator->first ? 1 : -1;
+            return TRUE;
+        case GEL_ITERATOR_VIEW:
+            return gel_iterator_cursor_next(self->cursors[0], value, context);
+        case GEL_ITERATOR_GENERATOR:
+            g_closure_invoke(iterator->closure, value, 0, NULL, context);
+            if(G_IS_VALUE(value) && gel_context_error(context))
+                g_value_unset(value);
+            return G_IS_VALUE(value);
+        case GEL_ITERATOR_MAP:
+            return gel_iterator_cursor_next_map(self, value, context);
+        case GEL_ITERATOR_FILTER:
+            return gel_iterator_cursor_next_filter(self, value, context);
+    }
+
+    return FALSE;
+}
+
+
+/*
+ * Moves the cursor to the next value and stores it in value, that must be empty.
+ * Returns FALSE at the end of the sequence or if an error occurred,
+ * leaving value empty.
+ */
+gboolean gel_iterator_cursor_next(GelIteratorCursor *self, GValue *value,
+                                  GelContext *context)
+{
+    g_return_val_if_fail(self != NULL, FALSE);
+    g_return_val_if_fail(value != NULL, FALSE);
+
+    if(self->iterator != NULL)
+        return gel_iterator_cursor_next_iterator(self, value, context);
+
+    if(G_VALUE_HOLDS(&self->source, GEL_TYPE_HASH)
+       || G_VALUE_HOLDS(&self->source, GEL_TYPE_DICT))
+    {
+        const GValue *key = NULL;
+        const GValue *key_value = NULL;
+
+        if(G_VALUE_HOLDS(&self->source, GEL_TYPE_HASH)
+           ? !gel_hash_iter_next(&self->hash_iter, &key, &key_value)
+           : !gel_dict_iter_next(&self->dict_iter, &key, &key_value))
+            return FALSE;
+
+        GelArray *pair = gel_array_new(2);
+        gel_array_append(pair, key);
+        gel_array_append(pair, key_value);
+
+        g_value_init(value, GEL_TYPE_ARRAY);
+        g_value_take_boxed(value, pair);
+        return TRUE;
+    }
+
+    if(G_VALUE_HOLDS(&self->source, GEL_TYPE_TYPED_ARRAY))
+    {
+        GelTypedArray *array = g_value_get_boxed(&self->source);
+        if(self->index >= gel_typed_array_get_n_elements(array))
+            return FALSE;
+
+        return gel_typed_array_get(array, self->index++, value);
+    }
+
+    if(G_VALUE_HOLDS(&self->source, GEL_TYPE_VECTOR))
+    {
+        GelVector *vector = g_value_get_boxed(&self->source);
+        if(self->index >= gel_vector_get_size(vector))
+            return FALSE;
+
+        gel_value_copy(gel_vector_get(vector, self->index++), value);
+        return TRUE;
+    }
+
+    GelArray *array = g_value_get_boxed(&self->source);
+    if(self->index >= gel_array_get_n_values(array))
+        return FALSE;
+
+    gel_value_copy(gel_array_get_values(array) + self->index++, value);
+    return TRUE;
+}
+
+
+/*
+ * Builds an array with the values of iterable,
+ * returns NULL if it is not iterable or an error occurred.
+ */
+GelArray* gel_iterator_collect(const GValue *iterable, GelContext *context)
+{
+    GelIteratorCursor *cursor = gel_iterator_cursor_new(iterable);
+    if(cursor == NULL)
+        return NULL;
+
+    GelArray *array = gel_array_new(0);
+    GValue value = {0};
+
+    while(gel_iterator_cursor_next(cursor, &value, context))
+    {
+        gel_array_append(array, &value);
+        g_value_unset(&value);
+    }
+
+    gel_iterator_cursor_free(cursor);
+
+    if(gel_context_error(context))
+    {
+        gel_array_free(array);
+        return NULL;
+    }
+
+    return array;
+}
+
@@ -0,0 +1,35 @@
+#ifndef __GEL_ITERATOR_H__
+#define __GEL_ITERATOR_H__
+
+#include <glib-object.h>
+#include <gelcontext.h>
+#include <gelarray.h>
+
+#define GEL_TYPE_ITERATOR (gel_iterator_get_type())
+
+typedef struct _GelIterator GelIterator;
+GType gel_iterator_get_type(void) G_GNUC_CONST;
+
+GelIterator* gel_iterator_new_range(gint64 first, gint64 last);
+GelIterator* gel_iterator_new_view(const GValue *value);
+GelIterator* gel_iterator_new_generator(GClosure *closure);
+GelIterator* gel_iterator_new_map(GClosure *closure,
+                                  guint n_sources, const GValue *sources);
+GelIterator* gel_iterator_new_filter(GClosure *closure, const GValue *source);
+GelIterator* gel_iterator_ref(GelIterator *self);
+void gel_iterator_unref(GelIterator *self);
+
+gchar* gel_iterator_to_string(const GelIterator *self);
+gboolean gel_value_is_iterable(const GValue *value);
+
+typedef struct _GelIteratorCursor GelIteratorCursor;
+
+GelIteratorCursor* gel_iterator_cursor_new(const GValue *iterable);
+gboolean gel_iterator_cursor_next(GelIteratorCursor *self, GValue *value,
+                                  GelContext *context);
+void gel_iterator_cursor_free(GelIteratorCursor *self);
+
+GelArray* gel_iterator_collect(const GValue *iterable, GelContext *context);
+
+#endif
+
@@ -4,22 +4,133 @@
 #include <gelparser.h>
 
 
+/*
+ * The code of a macro is compiled into templates when it is defined.
+ * A template keeps an array of the code and the positions in it that
+ * change on every expansion, its slots: symbols that are arguments and
+ * arrays that contain them, which have their own template.
+ * Expanding a template copies the values of its array, filling the slots.
+ * The arrays without arguments are the same for every expansion,
+ * so the expansions share them by reference with the macro. They are
+ * never changed, since quote copies the arrays it returns as data.
+ */
+typedef struct _GelMacroTemplate GelMacroTemplate;
+typedef struct _GelMacroSlot GelMacroSlot;
+
+struct _GelMacroSlot
+{
+    guint index;
+    guint arg;
+    GelMacroTemplate *inner;
+};
+
+struct _GelMacroTemplate
+{
+    GelArray *array;
+    guint n_slots;
+    GelMacroSlot *slots;
+};
+
 struct _GelMacro
 {
     gchar *name;
     GList *args;
+    guint n_args;
     gchar *variadic;
     GelArray *code;
+    GelMacroTemplate *template;
 };
 
 
+/* Returns the index of the argument @name, n_args if it is the variadic one
+ * or -1 if @name is not an argument */
+static
+gint gel_macro_get_arg(const GelMacro *self, const gchar *name)
+{
+    if(g_strcmp0(name, self->variadic) == 0)
+        return self->n_args;
+
+    guint i = 0;
+    for(GList *iter = self->args; iter != NULL; iter = iter->next, i++)
+        if(g_strcmp0(name, iter->data) == 0)
+            return i;
+
+    return -1;
+}
+
+
+static
+void gel_macro_template_free(GelMacroTemplate *template)
+{
+    for(guint i = 0; i < template->n_slots; i++)
+        if(template->slots[i].inner != NULL)
+            gel_macro_template_free(template->slots[i].inner);
+
+    g_free(template->slots);
+    g_slice_free(GelMacroTemplate, template);
+}
+
+
+/* Returns NULL if @array does not contain any argument */
+static
+GelMacroTemplate* gel_macro_template_new(const GelMacro *self,
+                                         GelArray *array)
+{
+    const GValue *values = gel_array_get_values(array);
+    guint n_values = gel_array_get_n_values(array);
+    GArray *slots = g_array_new(FALSE, FALSE, sizeof(GelMacroSlot));
+
+    for(guint i = 0; i < n_values; i++)
+    {
+        GelMacroSlot slot = {i, 0, NULL};
+        GType type = G_VALUE_TYPE(values + i);
+
+        if(type == GEL_TYPE_SYMBOL)
+        {
+            const GelSymbol *symbol = g_value_get_boxed(values + i);
+            gint arg = gel_macro_get_arg(self, gel_symbol_get_name(symbol));
+            if(arg < 0)
+                continue;
+            slot.arg = arg;
+        }
+        else
+        if(type == GEL_TYPE_ARRAY)
+        {
+            slot.inner =
+                gel_macro_template_new(self, g_value_get_boxed(values + i));
+            if(slot.inner == NULL)
+                continue;
+        }
+        else
+            continue;
+
+        g_array_append_val(slots, slot);
+    }
+
+    if(slots->len == 0)
+    {
+        g_array_free(slots, TRUE);
+        return NULL;
+    }
+
+    GelMacroTemplate *template = g_slice_new0(GelMacroTemplate);
+    template->array = array;
+    template->n_slots = slots->len;
+    template->slots = (GelMacroSlot *)g_array_free(slots, FALSE);
+
+    return template;
+}
+
+
 GelMacro* gel_macro_new(GList *args, gchar *variadic, GelArray *code)
 {
     GelMacro *self = g_slice_new0(GelMacro);
 
     self->args = args;
+    self->n_args = g_list_length(args);
     self->variadic = variadic;
     self->code = code;
+    self->template = gel_macro_template_new(self, code);
 
     return self;
 }
@@ -30,64 +141,47 @@ void gel_macro_free(GelMacro *self)
     g_list_foreach(self->args, (GFunc)g_free, NULL);
     g_list_free(self->args);
     g_free(self->variadic);
+    if(self->template != NULL)
+        gel_macro_template_free(self->template);
     gel_array_free(self->code);
     g_slice_free(GelMacro, self);
 }
 
 
 static
-GelArray* gel_macro_map_code(const GelMacro *self,
-                             GHashTable *mappings, GelArray *array,
-                             GError **error)
+GelArray* gel_macro_expand(const GelMacro *self,
+                           const GelMacroTemplate *template,
+                           guint n_values, const GValue *values)
 {
-    GValue *values = gel_array_get_values(array);
-    guint n_values = gel_array_get_n_values(array);
-    GelArray *code = gel_array_new(n_values);
+    const GValue *code_values = gel_array_get_values(template->array);
+    guint n_code_values = gel_array_get_n_values(template->array);
+    GelArray *code = gel_array_new(n_code_values);
+    const GelMacroSlot *slot = template->slots;
+    const GelMacroSlot *last_slot = template->slots + template->n_slots;
 
-    for(guint i = 0; i < n_values; i++)
+    for(guint i = 0; i < n_code_values; i++)
     {
-        GType type = G_VALUE_TYPE(values + i);
-        if(type == GEL_TYPE_SYMBOL)
+        if(slot == last_slot || slot->index != i)
+            gel_array_append(code, code_values + i);
+        else
         {
-            GelSymbol *symbol = g_value_get_boxed(values + i);
-            const gchar *name = gel_symbol_get_name(symbol);
-            GValue *value = g_hash_table_lookup(mappings, name);
-
-            if(g_strcmp0(name, self->variadic) != 0)
+            if(slot->inner != NULL)
             {
-                if(value != NULL)
-                    gel_array_append(code, value);
-                else
-                    gel_array_append(code, values + i);
+                GValue tmp_value = {0};
+                g_value_init(&tmp_value, GEL_TYPE_ARRAY);
+                g_value_take_boxed(&tmp_value,
+                    gel_macro_expand(self, slot->inner, n_values, values));
+                gel_array_append(code, &tmp_value);
+                g_value_unset(&tmp_value);
             }
             else
-            if(G_VALUE_HOLDS(value, GEL_TYPE_ARRAY))
-            {
-                GelArray *var_array = g_value_get_boxed(value);
-                guint var_n_values = gel_array_get_n_values(var_array);
-                GValue *var_values = gel_array_get_values(var_array);
-
-                for(guint i = 0; i < var_n_values; i++)
-                    gel_array_append(code, var_values + i);
-            }
-        }
-        else
-        if(type == GEL_TYPE_ARRAY)
-        {
-            GelArray *array = g_value_get_boxed(values + i);
-            GelArray *new_array =
-                gel_macro_map_code(self, mappings, array, error);
-
-            GValue tmp_value = {0};
-            g_value_init(&tmp_value, GEL_TYPE_ARRAY);
-
-            g_value_take_boxed(&tmp_value, new_array);
-            gel_array_append(code, &tmp_value);
-
-            g_value_unset(&tmp_value);
+            if(slot->arg < self->n_args)
+                gel_array_append(code, values + slot->arg);
+            else
+                for(guint j = self->n_args; j < n_values; j++)
+                    gel_array_append(code, values + j);
+            slot++;
         }
-        else
-            gel_array_append(code, values + i);
     }
 
     return code;
@@ -98,7 +192,7 @@ GelArray* gel_macro_invoke(const GelMacro *self, const gchar *name,
                            guint n_values, const GValue *values,
                            GError **error)
 {
-    guint n_args = g_list_length(self->args);
+    guint n_args = self->n_args;
     gboolean is_variadic = (self->variadic != NULL);
 
     if(is_variadic)
@@ -122,32 +216,9 @@ GelArray* gel_macro_invoke(const GelMacro *self, const gchar *name,
         return NULL;
     }
 
-    GHashTable *mappings = g_hash_table_new(g_str_hash, g_str_equal);
+    if(self->template == NULL)
+        return gel_array_copy(self->code);
 
-    guint i = 0;
-    for(GList *iter = self->args; iter != NULL; iter = iter->next, i++)
-    {
-        const gchar *arg = iter->data;
-        const GValue *value = values + i;
-        g_hash_table_insert(mappings, (void* )arg, (void *)value);
-    }
-
-    if(is_variadic)
-    {
-        guint array_n_values = n_values - i;
-        GelArray *array = gel_array_new(array_n_values);
-
-        for(guint j = 0; i < n_values; i++, j++)
-            gel_array_append(array, values + i);
-
-        GValue *value = gel_value_new_from_boxed(GEL_TYPE_ARRAY, array);
-        g_hash_table_insert(mappings, self->variadic, value);
-    }
-
-    GelArray *code =
-        gel_macro_map_code(self, mappings, self->code, error);
-    g_hash_table_unref(mappings);
-
-    return code;
+    return gel_macro_expand(self, self->template, n_values, values);
 }
 
@@ -0,0 +1,382 @@
+#include <gelparallel.h>
+#include <gelcontextprivate.h>
+
+#include <string.h>
+
+
+/*
+ * A parallel job splits a range of items in chunks, that the calling thread
+ * and the threads of a shared pool take one after the other until none is
+ * left. Threads that finish early take more chunks, so items that cost
+ * more than others do not leave the rest of the threads waiting.
+ *
+ * Each thread runs its chunks in its own inner context of the context of
+ * the caller, and frees it before reporting the items it has done, so the
+ * caller returns only when no thread uses its context. A thread of the pool
+ * that starts after every chunk was taken leaves without touching it.
+ *
+ * When a chunk fails the chunks not taken yet are dropped, and the error of
+ * the failed chunk with the lowest items is the one reported.
+ */
+
+/* chunks for each thread, the more chunks the better the balance */
+#define GEL_PARALLEL_CHUNKS_PER_THREAD 8
+
+typedef struct _GelParallelJob GelParallelJob;
+
+struct _GelParallelJob
+{
+    GelContext *context;
+    GelParallelFunc func;
+    gpointer user_data;
+    guint n_items;
+    guint chunk_size;
+    volatile gint next;
+    volatile gint ref_count;
+    GMutex mutex;
+    GCond done_cond;
+    guint n_done;
+    guint error_start;
+    GError *error;
+};
+
+
+static
+void gel_parallel_job_unref(GelParallelJob *job)
+{
+    if(g_atomic_int_dec_and_test(&job->ref_count))
+    {
+        g_mutex_clear(&job->mutex);
+        g_cond_clear(&job->done_cond);
+        if(job->error != NULL)
+            g_error_free(job->error);
+        g_slice_free(GelParallelJob, job);
+    }
+}
+
+
+/* Drops the chunks not taken yet, returns the number of items dropped */
+static
+guint gel_parallel_job_cancel(GelParallelJob *job)
+{
+    const gint n_items = job->n_items;
+    gint next;
+
+    do
+        next = g_atomic_int_get(&job->next);
+    while(next < n_items
+        && !g_atomic_int_compare_and_exchange(&job->next, next, n_items));
+
+    return next < n_items ? n_items - next : 0;
+}
+
+
+static
+void gel_parallel_job_work(GelParallelJob *job, GelContext *context)
+{
+    GelContext *worker_context = NULL;
+    guint n_done = 0;
+    guint start;
+
+    while((start = g_atomic_int_add(&job->next, job->chunk_size))
+            < job->n_items)
+    {
+        guint end = MIN(start + job->chunk_size, job->n_items);
+
+        if(context == NULL)
+            context = worker_context = gel_context_new_with_outer(job->context);
+
+        job->func(context, start, end, job->user_data);
+        n_done += end - start;
+
+        if(gel_context_error(context))
+        {
+            GError *error = gel_context_take_error(context);
+            n_done += gel_parallel_job_cancel(job);
+
+            g_mutex_lock(&job->mutex);
+            if(job->error == NULL || start < job->error_start)
+            {
+                if(job->error != NULL)
+                    g_error_free(job->error);
+                job->error = error;
+                job->error_start = start;
+            }
+            else
+                g_error_free(error);
+            g_mutex_unlock(&job->mutex);
+        }
+    }
+
+    if(worker_context != NULL)
+        gel_context_free(worker_context);
+
+    g_mutex_lock(&job->mutex);
+    job->n_done += n_done;
+    if(job->n_done == job->n_items)
+        g_cond_signal(&job->done_cond);
+    g_mutex_unlock(&job->mutex);
+}
+
+
+static
+void gel_parallel_worker(GelParallelJob *job, gpointer user_data)
+{
+    gel_parallel_job_work(job, NULL);
+    gel_parallel_job_unref(job);
+}
+
+
+static
+GThreadPool* gel_parallel_get_pool(guint *n_threads)
+{
+    static GThreadPool *pool = NULL;
+    static guint pool_n_threads = 0;
+    static volatile gsize once = 0;
+
+    if(g_once_init_enter(&once))
+    {
+        pool_n_threads = MAX(g_get_num_processors(), 1);
+
+        /* the thread calling gel_parallel_run works too */
+        if(pool_n_threads > 1)
+            pool = g_thread_pool_new((GFunc)gel_parallel_worker,
+                NULL, pool_n_threads - 1, FALSE, NULL);
+        g_once_init_leave(&once, 1);
+    }
+
+    *n_threads = pool != NULL ? pool_n_threads : 1;
+    return pool;
+}
+
+
+/*
+ * Calls func for chunks of the items from 0 to n_items, in the thread of
+ * the caller and in the threads of a pool, and returns when every item is
+ * done. Chunks running in other threads receive an inner context of
+ * context, and func must not change the variables they share.
+ * If func sets an error in its context, the error is moved to context.
+ *
+ * Returns FALSE if an error occurred.
+ */
+gboolean gel_parallel_run(GelContext *context, guint n_items,
+                          GelParallelFunc func, gpointer user_data)
+{
+    g_return_val_if_fail(context != NULL, FALSE);
+    g_return_val_if_fail(func != NULL, FALSE);
+
+    guint n_threads = 1;
+    GThreadPool *pool = gel_parallel_get_pool(&n_threads);
+    guint n_chunks = MIN(n_items, n_threads * GEL_PARALLEL_CHUNKS_PER_THREAD);
+
+    if(pool == NULL || n_chunks < 2 || n_items > G_MAXINT / 2)
+    {
+        func(context, 0, n_items, user_data);
+        return !gel_context_error(context);
+    }
+
+    GelParallelJob *job = g_slice_new0(GelParallelJob);
+    job->context = context;
+    job->func = func;
+    job->user_data = user_data;
+    job->n_items = n_items;
+    job->chunk_size = (n_items + n_chunks - 1) / n_chunks;
+    job->ref_count = 1;
+    g_mutex_init(&job->mutex);
+    g_cond_init(&job->done_cond);
+
+    gel_context_begin_parallel(context);
+
+    guint n_workers = MIN(n_threads, n_chunks) - 1;
+    for(guint i = 0; i < n_workers; i++)
+    {
+        g_atomic_int_inc(&job->ref_count);
+        g_thread_pool_push(pool, job, NULL);
+    }
+
+    gel_parallel_job_work(job, context);
+
+    g_mutex_lock(&job->mutex);
+    while(job->n_done < job->n_items)
+        g_cond_wait(&job->done_cond, &job->mutex);
+    g_mutex_unlock(&job->mutex);
+
+    gel_context_end_parallel(context);
+
+    gboolean result = (job->error == NULL);
+    if(job->error != NULL)
+    {
+        gel_context_set_error(context, job->error);
+        job->error = NULL;
+    }
+
+    gel_parallel_job_unref(job);
+    return result;
+}
+
+/*
+ * gel_parallel_sort is a stable bottom-up merge sort. Runs of a few items
+ * are sorted by insertion, and then merged in pairs of runs of doubling
+ * width, going back and forth between the items and a buffer. Each level
+ * sorts or merges its runs with gel_parallel_run, so the lower levels use
+ * every thread while the last merges have fewer runs than threads.
+ *
+ * Items are only moved, never copied, and compare is called once for each
+ * step, asking whether the second item goes before the first one. After an
+ * error the items keep being moved as usual so none is lost or duplicated.
+ */
+
+/* items sorted by insertion before merging */
+#define GEL_PARALLEL_SORT_RUN 16
+
+/* arrays smaller than this are sorted in the thread of the caller */
+#define GEL_PARALLEL_SORT_MIN_ITEMS 8192
+
+typedef struct _GelParallelSort GelParallelSort;
+
+struct _GelParallelSort
+{
+    guchar *src;
+    guchar *dest;
+    guint n_items;
+    gsize item_size;
+    gsize width;
+    GelParallelCompareFunc compare;
+    gpointer user_data;
+};
+
+
+static
+void gel_parallel_sort_runs(GelContext *context, guint start, guint end,
+                            GelParallelSort *sort)
+{
+    const gsize size = sort->item_size;
+    guchar *tmp = g_alloca(size);
+
+    for(guint run = start; run < end; run++)
+    {
+        guchar *first = sort->src + (gsize)run * GEL_PARALLEL_SORT_RUN * size;
+        guint n = MIN(GEL_PARALLEL_SORT_RUN,
+            sort->n_items - run * GEL_PARALLEL_SORT_RUN);
+
+        for(guint i = 1; i < n; i++)
+        {
+            guint j = i;
+            memcpy(tmp, first + i * size, size);
+
+            while(j > 0 && sort->compare(
+                    first + (j - 1) * size, tmp, context, sort->user_data) > 0)
+                j--;
+
+            if(j < i)
+            {
+                memmove(first + (j + 1) * size, first + j * size, (i - j) * size);
+                memcpy(first + j * size, tmp, size);
+            }
+        }
+    }
+}
+
+
+static
+void gel_parallel_sort_merges(GelContext *context, guint start, guint end,
+                              GelParallelSort *sort)
+{
+    const gsize size = sort->item_size;
+
+    for(guint pair = start; pair < end; pair++)
+    {
+        gsize low = (gsize)pair * 2 * sort->width;
+        gsize middle = MIN(low + sort->width, sort->n_items);
+        gsize high = MIN(middle + sort->width, sort->n_items);
+
+        guchar *left = sort->src + low * size;
+        guchar *left_end = sort->src + middle * size;
+        guchar *right = left_end;
+        guchar *right_end = sort->src + high * size;
+        guchar *dest = sort->dest + low * size;
+
+        while(left < left_end && right < right_end)
+            if(sort->compare(left, right, context, sort->user_data) > 0)
+            {
+                memcpy(dest, right, size);
+                right += size;
+                dest += size;
+            }
+            else
+            {
+                memcpy(dest, left, size);
+                left += size;
+                dest += size;
+            }
+
+        memcpy(dest, left, left_end - left);
+        memcpy(dest + (left_end - left), right, right_end - right);
+    }
+}
+
+
+static
+gboolean gel_parallel_sort_level(GelContext *context, guint n_runs,
+                                 GelParallelFunc func, GelParallelSort *sort)
+{
+    if(sort->n_items < GEL_PARALLEL_SORT_MIN_ITEMS)
+    {
+        func(context, 0, n_runs, sort);
+        return !gel_context_error(context);
+    }
+
+    return gel_parallel_run(context, n_runs, func, sort);
+}
+
+
+/*
+ * Sorts n_items of item_size bytes, compare returns a positive number when
+ * its first item goes after the second one, like a #GCompareFunc.
+ * The items are sorted in several threads if there are many of them,
+ * with the same rules as gel_parallel_run.
+ *
+ * Returns FALSE if an error occurred, the items are then partly sorted.
+ */
+gboolean gel_parallel_sort(GelContext *context,
+                           gpointer items, guint n_items, gsize item_size,
+                           GelParallelCompareFunc compare, gpointer user_data)
+{
+    g_return_val_if_fail(context != NULL, FALSE);
+    g_return_val_if_fail(items != NULL || n_items == 0, FALSE);
+    g_return_val_if_fail(compare != NULL, FALSE);
+
+    if(n_items < 2)
+        return TRUE;
+
+    guchar *buffer = g_malloc(n_items * item_size);
+    GelParallelSort sort =
+        {items, buffer, n_items, item_size, 0, compare, user_data};
+
+    gboolean result = gel_parallel_sort_level(context,
+        (n_items + GEL_PARALLEL_SORT_RUN - 1) / GEL_PARALLEL_SORT_RUN,
+        (GelParallelFunc)gel_parallel_sort_runs, &sort);
+
+    for(sort.width = GEL_PARALLEL_SORT_RUN;
+        result && sort.width < n_items; sort.width *= 2)
+    {
+        guint n_pairs = (n_items - 1) / (2 * sort.width) + 1;
+
+        result = gel_parallel_sort_level(context, n_pairs,
+            (GelParallelFunc)gel_parallel_sort_merges, &sort);
+
+        /* the items are in dest only if every pair was merged */
+        if(result)
+        {
+            guchar *src = sort.src;
+            sort.src = sort.dest;
+            sort.dest = src;
+        }
+    }
+
+    if(sort.src != items)
+        memcpy(items, sort.src, n_items * item_size);
+
+    g_free(buffer);
+    return result;
+}
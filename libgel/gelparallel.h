@@ -0,0 +1,23 @@
+#ifndef __GEL_PARALLEL_H__
+#define __GEL_PARALLEL_H__
+
+#include <glib-object.h>
+#include <gelcontext.h>
+
+typedef
+void (*GelParallelFunc)(GelContext *context,
+                        guint start, guint end, gpointer user_data);
+
+gboolean gel_parallel_run(GelContext *context, guint n_items,
+                          GelParallelFunc func, gpointer user_data);
+
+typedef
+gint (*GelParallelCompareFunc)(gconstpointer a, gconstpointer b,
+                               GelContext *context, gpointer user_data);
+
+gboolean gel_parallel_sort(GelContext *context,
+                           gpointer items, guint n_items, gsize item_size,
+                           GelParallelCompareFunc compare, gpointer user_data);
+
+#endif
+
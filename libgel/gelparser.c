@@ -1,10 +1,13 @@
 #include <string.h>
+#include <errno.h>
+#include <unistd.h>
 
 #include <gelparser.h>
 #include <gelsymbol.h>
 #include <gelvalue.h>
 #include <gelvalueprivate.h>
 #include <gelmacro.h>
+#include <gelcache.h>
 
 #define ARRAY_N_PREALLOCATED 8
 
@@ -51,7 +54,7 @@ GQuark gel_parser_error_quark(void)
 }
 
 static
-const gchar *scanner_errors[] = {
+const gchar *parser_errors[] = {
     "Unknown error",
     "Unexpected end of file",
     "Unterminated string constant",
@@ -62,24 +65,34 @@ const gchar *scanner_errors[] = {
     "Malformed floating point number"
 };
 
+#define PARSER_READ_SIZE 4096
 
-static
-GScanner* gel_scanner_new(void)
+typedef enum _GelTokenType
 {
-    GScanner *scanner = g_scanner_new(NULL);
-    GScannerConfig *config = scanner->config;
+    GEL_TOKEN_EOF = 0,
+    GEL_TOKEN_ERROR = 256,
+    GEL_TOKEN_IDENTIFIER,
+    GEL_TOKEN_INT,
+    GEL_TOKEN_FLOAT,
+    GEL_TOKEN_STRING
+} GelTokenType;
 
-    config->cset_identifier_first =
-        G_CSET_a_2_z G_CSET_A_2_Z "=_+-*/%!&<>.";
-    config->cset_identifier_nth =
-        G_CSET_a_2_z G_CSET_A_2_Z "=_+-*/%!&<>.?" G_CSET_DIGITS;
-    config->cset_skip_characters = " \t\n,";
-    config->scan_identifier_1char = TRUE;
-    config->store_int64 = TRUE;
-    config->scan_string_sq = FALSE;
+typedef struct _GelToken GelToken;
 
-    return scanner;
-}
+struct _GelToken
+{
+    guint type;
+    const gchar *start;
+    gsize len;
+    guint line;
+    guint position;
+    union
+    {
+        gint64 v_int64;
+        gdouble v_float;
+        GelParserError v_error;
+    } value;
+};
 
 
 /**
@@ -93,9 +106,25 @@ GScanner* gel_scanner_new(void)
 
 struct _GelParser
 {
-    GScanner *scanner;
+    const gchar *text;
+    const gchar *text_end;
+    guint line;
+    guint position;
+
+    gint fd;
+    GMappedFile *mapped;
+    gchar *contents;
+    GelCache *cache;
+    gchar *buffer;
+    gsize buffer_size;
+    GString *scratch;
+
     GHashTable *macros;
-    GList *next;
+
+    GValue *pending;
+    guint pending_size;
+    guint pending_first;
+    guint n_pending;
 };
 
 
@@ -110,7 +139,9 @@ GelParser* gel_parser_new(void)
 {
     GelParser *self = g_slice_new0(GelParser);
 
-    self->scanner = gel_scanner_new();
+    self->line = 1;
+    self->fd = -1;
+    self->scratch = g_string_sized_new(64);
     self->macros = g_hash_table_new_full(
         g_str_hash, g_str_equal,
         g_free, (GDestroyNotify)gel_macro_free);
@@ -129,12 +160,573 @@ void gel_parser_free(GelParser *self)
 {
     g_return_if_fail(self != NULL);
 
-    g_scanner_destroy(self->scanner);
+    if(self->cache != NULL)
+        gel_cache_free(self->cache);
+    if(self->mapped != NULL)
+        g_mapped_file_unref(self->mapped);
+    g_free(self->contents);
+    for(guint i = 0; i < self->n_pending; i++)
+    {
+        guint index = (self->pending_first + i) % self->pending_size;
+        g_value_unset(self->pending + index);
+    }
+    g_free(self->pending);
+
+    g_free(self->buffer);
+    g_string_free(self->scratch, TRUE);
     g_hash_table_unref(self->macros);
     g_slice_free(GelParser, self);
 }
 
 
+static inline
+gboolean gel_char_is_identifier_first(gchar c)
+{
+    if(g_ascii_isalpha(c))
+        return TRUE;
+
+    switch(c)
+    {
+        case '=': case '_': case '+': case '-': case '*': case '/':
+        case '%': case '!': case '&': case '<': case '>': case '.':
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+
+static inline
+gboolean gel_char_is_identifier_nth(gchar c)
+{
+    return gel_char_is_identifier_first(c) || g_ascii_isdigit(c) || c == '?';
+}
+
+
+/* Reads more input from the file descriptor, keeping the unconsumed text */
+static
+gboolean gel_parser_read(GelParser *self)
+{
+    if(self->fd < 0)
+        return FALSE;
+
+    gsize n_pending = self->text_end - self->text;
+    if(n_pending + PARSER_READ_SIZE > self->buffer_size)
+    {
+        gchar *buffer = g_malloc(n_pending + PARSER_READ_SIZE);
+        if(n_pending > 0)
+            memcpy(buffer, self->text, n_pending);
+        g_free(self->buffer);
+        self->buffer = buffer;
+        self->buffer_size = n_pending + PARSER_READ_SIZE;
+    }
+    else
+    if(n_pending > 0)
+        memmove(self->buffer, self->text, n_pending);
+
+    self->text = self->buffer;
+    self->text_end = self->buffer + n_pending;
+
+    gssize n_read;
+    do
+        n_read = read(self->fd, self->buffer + n_pending, PARSER_READ_SIZE);
+    while(n_read < 0 && errno == EINTR);
+
+    if(n_read <= 0)
+    {
+        self->fd = -1;
+        return FALSE;
+    }
+
+    self->text_end += n_read;
+    return TRUE;
+}
+
+
+/* Returns the char @offset bytes ahead of the cursor, or 0 at the end */
+static inline
+gchar gel_parser_peek(GelParser *self, gsize offset)
+{
+    while(self->text + offset >= self->text_end)
+        if(!gel_parser_read(self))
+            return 0;
+    return self->text[offset];
+}
+
+
+static
+void gel_parser_advance(GelParser *self, gsize n_chars)
+{
+    const gchar *end = self->text + n_chars;
+    for(; self->text < end; self->text++)
+        if(*self->text == '\n')
+        {
+            self->line++;
+            self->position = 0;
+        }
+        else
+            self->position++;
+}
+
+
+/* Parses the digits of @text, saturating on overflow as strtoull does */
+static
+gboolean gel_parser_digits_to_int(const gchar *text, const gchar *end,
+                                  guint radix, gint64 *value)
+{
+    guint64 result = 0;
+    gboolean overflow = FALSE;
+
+    for(; text < end; text++)
+    {
+        gint digit = g_ascii_xdigit_value(*text);
+        if(digit < 0 || (guint)digit >= radix)
+            return FALSE;
+
+        if(result > (G_MAXUINT64 - digit) / radix)
+            overflow = TRUE;
+        else
+            result = result * radix + digit;
+    }
+
+    *value = overflow ? (gint64)G_MAXUINT64 : (gint64)result;
+    return TRUE;
+}
+
+
+/*
+ * Scans the number starting at @text, which must be a digit.
+ * On return *@stop points past the last consumed char, which for errors
+ * is the offending one.
+ */
+static
+void gel_parser_scan_number(const gchar *text, const gchar *end,
+                            GString *scratch, GelToken *token,
+                            const gchar **stop)
+{
+    const gchar *p = text;
+    const gchar *digits = text;
+    gchar last = *p++;
+    guint type = GEL_TOKEN_INT;
+    guint radix = 10;
+
+    token->type = GEL_TOKEN_ERROR;
+    if(last == '0')
+    {
+        radix = 8;
+        if(p < end && (*p == 'x' || *p == 'X'))
+        {
+            p++;
+            if(p == end)
+            {
+                token->value.v_error = GEL_PARSER_ERROR_UNEXP_EOF;
+                *stop = p;
+                return;
+            }
+
+            last = *p++;
+            if(!g_ascii_isxdigit(last))
+            {
+                token->value.v_error = GEL_PARSER_ERROR_DIGIT_RADIX;
+                *stop = p;
+                return;
+            }
+            digits = p - 1;
+            radix = 16;
+        }
+    }
+
+    for(; p < end; p++)
+    {
+        gchar c = *p;
+        gboolean after_e = type == GEL_TOKEN_FLOAT &&
+            (last == 'e' || last == 'E');
+
+        if(!g_ascii_isalnum(c) && c != '.' &&
+           !(after_e && (c == '+' || c == '-')))
+            break;
+
+        switch(c)
+        {
+            case '.':
+                if(radix == 16 || type == GEL_TOKEN_FLOAT)
+                {
+                    token->value.v_error = radix == 16 ?
+                        GEL_PARSER_ERROR_FLOAT_RADIX :
+                        GEL_PARSER_ERROR_FLOAT_MALFORMED;
+                    *stop = p + 1;
+                    return;
+                }
+                type = GEL_TOKEN_FLOAT;
+                break;
+            case 'e':
+            case 'E':
+                if(radix != 16)
+                    type = GEL_TOKEN_FLOAT;
+                break;
+            default:
+                if(!g_ascii_isdigit(c) && c != '+' && c != '-' &&
+                   radix != 16)
+                {
+                    token->value.v_error = GEL_PARSER_ERROR_NON_DIGIT_IN_CONST;
+                    *stop = p + 1;
+                    return;
+                }
+                break;
+        }
+        last = c;
+    }
+
+    *stop = p;
+    if(type == GEL_TOKEN_FLOAT)
+    {
+        gchar *endptr;
+        g_string_truncate(scratch, 0);
+        g_string_append_len(scratch, text, p - text);
+        token->value.v_float = g_ascii_strtod(scratch->str, &endptr);
+        if(*endptr != 0)
+        {
+            token->value.v_error = *endptr == 'e' || *endptr == 'E' ?
+                GEL_PARSER_ERROR_NON_DIGIT_IN_CONST :
+                GEL_PARSER_ERROR_DIGIT_RADIX;
+            return;
+        }
+    }
+    else
+    if(!gel_parser_digits_to_int(digits, p, radix, &token->value.v_int64))
+    {
+        token->value.v_error = GEL_PARSER_ERROR_DIGIT_RADIX;
+        return;
+    }
+
+    token->type = type;
+}
+
+
+/* Decodes the escape sequences of a string literal, as GScanner did */
+static
+gchar* gel_parser_unescape(const gchar *text, const gchar *end)
+{
+    gchar *result = g_malloc(end - text + 1);
+    gchar *dest = result;
+
+    while(text < end)
+    {
+        const gchar *escape = memchr(text, '\\', end - text);
+        if(escape == NULL)
+            escape = end;
+
+        memcpy(dest, text, escape - text);
+        dest += escape - text;
+        text = escape;
+        if(text == end)
+            break;
+
+        gchar c = text[1];
+        text += 2;
+        switch(c)
+        {
+            case 'n':
+                *dest++ = '\n';
+                break;
+            case 't':
+                *dest++ = '\t';
+                break;
+            case 'r':
+                *dest++ = '\r';
+                break;
+            case 'b':
+                *dest++ = '\b';
+                break;
+            case 'f':
+                *dest++ = '\f';
+                break;
+            case '0': case '1': case '2': case '3':
+            case '4': case '5': case '6': case '7':
+            {
+                guint code = c - '0';
+                for(guint i = 0; i < 2 && text < end &&
+                    *text >= '0' && *text <= '7'; i++)
+                    code = code * 8 + *text++ - '0';
+                *dest++ = (gchar)code;
+                break;
+            }
+            default:
+                *dest++ = c;
+                break;
+        }
+    }
+
+    *dest = 0;
+    return result;
+}
+
+
+/*
+ * Obtains the next token, skipping blanks and comments,
+ * from '#' to the end of the line or between '/' '*' and '*' '/'.
+ * Identifier and string tokens are slices of the input text,
+ * valid until the next call.
+ */
+static
+void gel_parser_next_token(GelParser *self, GelToken *token)
+{
+    gchar c;
+    for(;;)
+    {
+        c = gel_parser_peek(self, 0);
+        if(c == ' ' || c == '\t' || c == ',' || c == '\n')
+            gel_parser_advance(self, 1);
+        else
+        if(c == '#')
+        {
+            gsize len = 1;
+            while((c = gel_parser_peek(self, len)) != 0 && c != '\n')
+                len++;
+            gel_parser_advance(self, c == '\n' ? len + 1 : len);
+        }
+        else
+        if(c == '/' && gel_parser_peek(self, 1) == '*')
+        {
+            gsize len = 2;
+            while((c = gel_parser_peek(self, len)) != 0
+                  && (c != '*' || gel_parser_peek(self, len + 1) != '/'))
+                len++;
+
+            if(c == 0)
+            {
+                token->start = self->text;
+                token->len = 0;
+                token->type = GEL_TOKEN_ERROR;
+                token->value.v_error = GEL_PARSER_ERROR_UNEXP_EOF_IN_COMMENT;
+                gel_parser_advance(self, len);
+                self->position++;
+                token->line = self->line;
+                token->position = self->position;
+                return;
+            }
+
+            gel_parser_advance(self, len + 2);
+        }
+        else
+            break;
+    }
+
+    token->start = self->text;
+    token->len = 0;
+    if(c == 0)
+        token->type = GEL_TOKEN_EOF;
+    else
+    if(gel_char_is_identifier_first(c) || g_ascii_isdigit(c))
+    {
+        gsize len = 1;
+        while(gel_char_is_identifier_nth(gel_parser_peek(self, len)))
+            len++;
+
+        token->start = self->text;
+        if(g_ascii_isdigit(c))
+        {
+            const gchar *stop;
+            gel_parser_scan_number(self->text, self->text_end,
+                                   self->scratch, token, &stop);
+            len = stop - self->text;
+        }
+        else
+            token->type = GEL_TOKEN_IDENTIFIER;
+
+        token->len = len;
+        gel_parser_advance(self, len);
+        if(token->type == GEL_TOKEN_ERROR &&
+           token->value.v_error == GEL_PARSER_ERROR_UNEXP_EOF)
+            self->position++;
+    }
+    else
+    if(c == '"')
+    {
+        gsize len = 1;
+        while((c = gel_parser_peek(self, len)) != 0 && c != '"')
+            len += c == '\\' && gel_parser_peek(self, len + 1) != 0 ? 2 : 1;
+
+        token->start = self->text + 1;
+        token->len = len - 1;
+        if(c == 0)
+        {
+            token->type = GEL_TOKEN_ERROR;
+            token->value.v_error = GEL_PARSER_ERROR_UNEXP_EOF_IN_STRING;
+            gel_parser_advance(self, self->text_end - self->text);
+            self->position++;
+        }
+        else
+        {
+            token->type = GEL_TOKEN_STRING;
+            gel_parser_advance(self, len + 1);
+        }
+    }
+    else
+    {
+        token->type = (guchar)c;
+        gel_parser_advance(self, 1);
+    }
+
+    token->line = self->line;
+    token->position = self->position;
+}
+
+
+/*
+ * Checks if an identifier starting with '-' is a negative number.
+ * Returns TRUE and initializes @value if so.
+ */
+static
+gboolean gel_parser_negative_number(GelParser *self, const GelToken *token,
+                                    GValue *value)
+{
+    const gchar *text = token->start + 1;
+    const gchar *end = token->start + token->len;
+    if(token->len < 2 || token->start[0] != '-' || !g_ascii_isdigit(*text))
+        return FALSE;
+
+    GelToken number;
+    const gchar *stop;
+    gel_parser_scan_number(text, end, self->scratch, &number, &stop);
+    if(stop != end)
+        return FALSE;
+
+    switch(number.type)
+    {
+        case GEL_TOKEN_FLOAT:
+            g_value_init(value, G_TYPE_DOUBLE);
+            g_value_set_double(value, -number.value.v_float);
+            return TRUE;
+        case GEL_TOKEN_INT:
+            g_value_init(value, G_TYPE_INT64);
+            /* negated unsigned, so -9223372036854775808 does not overflow */
+            g_value_set_int64(value,
+                (gint64)(0 - (guint64)number.value.v_int64));
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+
+/*
+ * Initializes @value with the literal or symbol of @token.
+ * Symbols are bound to predefined variables, unless @data is TRUE.
+ * In that case strings without escapes are not copied, so @value is only
+ * valid until the next token is read.
+ */
+static
+void gel_parser_atom(GelParser *self, const GelToken *token,
+                     GValue *value, gboolean data)
+{
+    switch(token->type)
+    {
+        case GEL_TOKEN_IDENTIFIER:
+            if(!gel_parser_negative_number(self, token, value))
+            {
+                g_string_truncate(self->scratch, 0);
+                g_string_append_len(self->scratch, token->start, token->len);
+
+                const gchar *name = self->scratch->str;
+                GelVariable *variable =
+                    data ? NULL : gel_variable_lookup_predefined(name);
+                g_value_init(value, GEL_TYPE_SYMBOL);
+                g_value_take_boxed(value, gel_symbol_new(name, variable));
+            }
+            break;
+        case GEL_TOKEN_FLOAT:
+            g_value_init(value, G_TYPE_DOUBLE);
+            g_value_set_double(value, token->value.v_float);
+            break;
+        case GEL_TOKEN_INT:
+            g_value_init(value, G_TYPE_INT64);
+            g_value_set_int64(value, token->value.v_int64);
+            break;
+        case GEL_TOKEN_STRING:
+            g_value_init(value, G_TYPE_STRING);
+            if(memchr(token->start, '\\', token->len) != NULL)
+                g_value_take_string(value, gel_parser_unescape(
+                    token->start, token->start + token->len));
+            else
+            if(data)
+            {
+                g_string_truncate(self->scratch, 0);
+                g_string_append_len(self->scratch, token->start, token->len);
+                g_value_set_static_string(value, self->scratch->str);
+            }
+            else
+                g_value_take_string(value,
+                    g_strndup(token->start, token->len));
+            break;
+        default:
+            break;
+    }
+}
+
+
+/*
+ * Checks that @token closes the array opened with @delim at @line, @pos.
+ * Sets @error and returns FALSE if it does not.
+ */
+static
+gboolean gel_parser_check_close(const GelToken *token, gchar delim,
+                                guint line, guint pos, GError **error)
+{
+    if((delim == '(' && token->type != ')') ||
+       (delim == '[' && token->type != ']') ||
+       (delim == '{' && token->type != '}'))
+    {
+        g_propagate_error(error, g_error_new(
+            GEL_PARSER_ERROR, GEL_PARSER_ERROR_UNEXP_DELIM,
+            "Cannot close '%c' at line %u, char %u "
+            "with '%c' at line %u, char %u",
+            delim, line, pos, token->type,
+            token->line, token->position));
+        return FALSE;
+    }
+    else
+    if(delim == 0)
+    {
+        g_propagate_error(error, g_error_new(
+            GEL_PARSER_ERROR, GEL_PARSER_ERROR_UNEXP_DELIM,
+            "Unexpected '%c' at line %u, char %u",
+            token->type, token->line, token->position));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+static
+void gel_parser_eof_error(gchar delim, guint line, guint pos, GError **error)
+{
+    g_propagate_error(error, g_error_new(
+        GEL_PARSER_ERROR, GEL_PARSER_ERROR_UNEXP_EOF_IN_ARRAY,
+        "'%c' opened at line %u, char %u was not closed",
+        delim, line, pos));
+}
+
+
+/* Sets @error for an error token or for a token that is not expected */
+static
+void gel_parser_token_error(const GelToken *token, GError **error)
+{
+    if(token->type == GEL_TOKEN_ERROR)
+        g_propagate_error(error, g_error_new(
+            GEL_PARSER_ERROR, token->value.v_error,
+            "%s at line %u, char %u",
+            parser_errors[token->value.v_error],
+            token->line, token->position));
+    else
+        g_propagate_error(error, g_error_new(
+            GEL_PARSER_ERROR, GEL_PARSER_ERROR_UNKNOWN_TOKEN,
+            "Unknown token '%c' (%d) at line %u, char %u",
+            token->type, token->type, token->line, token->position));
+}
+
+
 static
 GelArray* gel_parser_macro_code_from_value(GelParser *self,
                                            GValue *pre_value, GError **error)
@@ -192,6 +784,9 @@ GelArray* gel_parser_macro_code_from_value(GelParser *self,
             g_hash_table_insert(self->macros,
                 g_strdup(name), gel_macro_new(args, variadic, code));
 
+            if(self->cache != NULL)
+                gel_cache_add_macro(self->cache, pre_value);
+
             return NULL;
         }
         else
@@ -206,23 +801,63 @@ GelArray* gel_parser_macro_code_from_value(GelParser *self,
 }
 
 
+/*
+ * When a macro expands into several values at the top level, the values
+ * after the first one are kept in a ring buffer to be returned later.
+ */
+static
+void gel_parser_push_pending(GelParser *self, const GValue *value)
+{
+    if(self->n_pending == self->pending_size)
+    {
+        guint size = self->pending_size > 0 ?
+            self->pending_size * 2 : ARRAY_N_PREALLOCATED;
+        GValue *pending = g_new0(GValue, size);
+
+        for(guint i = 0; i < self->n_pending; i++)
+        {
+            guint index = (self->pending_first + i) % self->pending_size;
+            pending[i] = self->pending[index];
+        }
+
+        g_free(self->pending);
+        self->pending = pending;
+        self->pending_size = size;
+        self->pending_first = 0;
+    }
+
+    guint last = (self->pending_first + self->n_pending) % self->pending_size;
+    gel_value_copy(value, self->pending + last);
+    self->n_pending++;
+}
+
+
+/* Moves the first pending value into @dest_value, that must be unset */
+static
+void gel_parser_pop_pending(GelParser *self, GValue *dest_value)
+{
+    GValue *first = self->pending + self->pending_first;
+    *dest_value = *first;
+    memset(first, 0, sizeof(GValue));
+
+    self->pending_first = (self->pending_first + 1) % self->pending_size;
+    self->n_pending--;
+}
+
+
 static
 GelArray* gel_parser_scan(GelParser *self, GValue *dest_value,
                           guint line, guint pos,
                           gchar delim, GError **error)
 {
-    GScanner *scanner = self->scanner;
     GelArray *array = NULL;
 
     if(dest_value == NULL)
         array = gel_array_new(ARRAY_N_PREALLOCATED);
     else
-    if(self->next != NULL)
+    if(self->n_pending > 0)
     {
-        GValue *next_value = self->next->data;
-        gel_value_copy(next_value, dest_value);
-        self->next = g_list_delete_link(self->next, self->next);
-        gel_value_free(next_value);
+        gel_parser_pop_pending(self, dest_value);
         return NULL;
     }
 
@@ -253,32 +888,22 @@ GelArray* gel_parser_scan(GelParser *self, GValue *dest_value,
     while(parsing && !failed)
     {
         GValue value = {0};
-        const gchar *name = NULL;
-
-        guint token = g_scanner_peek_next_token(scanner);
-        switch(token)
+        GelToken token;
+        gel_parser_next_token(self, &token);
+        switch(token.type)
         {
-            case G_TOKEN_IDENTIFIER:
-                g_scanner_get_next_token(scanner);
-                name = scanner->value.v_identifier;
-                break;
-            case G_TOKEN_FLOAT:
-                g_scanner_get_next_token(scanner);
-                g_value_init(&value, G_TYPE_DOUBLE);
-                g_value_set_double(&value, (gdouble)scanner->value.v_float);
-                break;
-            case G_TOKEN_INT:
-                g_scanner_get_next_token(scanner);
-                g_value_init(&value, G_TYPE_INT64);
-                g_value_set_int64(&value, (gint64)scanner->value.v_int64);
+            case GEL_TOKEN_IDENTIFIER:
+            case GEL_TOKEN_FLOAT:
+            case GEL_TOKEN_INT:
+            case GEL_TOKEN_STRING:
+                gel_parser_atom(self, &token, &value, FALSE);
                 break;
             case '(':
             case '[':
             case '{':
             {
-                g_scanner_get_next_token(scanner);
                 GelArray *inner_array = gel_parser_scan(self, NULL,
-                        scanner->line, scanner->position, token, error);
+                        token.line, token.position, token.type, error);
                 if(inner_array != NULL)
                 {
                     g_value_init(&value, GEL_TYPE_ARRAY);
@@ -291,113 +916,28 @@ GelArray* gel_parser_scan(GelParser *self, GValue *dest_value,
             case ')':
             case ']':
             case '}':
-                g_scanner_get_next_token(scanner);
-                if((delim == '(' && token != ')') ||
-                   (delim == '[' && token != ']') ||
-                   (delim == '{' && token != '}'))
-                {
-                    g_propagate_error(error, g_error_new(
-                        GEL_PARSER_ERROR, GEL_PARSER_ERROR_UNEXP_DELIM,
-                        "Cannot close '%c' at line %u, char %u "
-                        "with '%c' at line %u, char %u",
-                        delim, line, pos, token,
-                        scanner->next_line, scanner->next_position));
-                    failed = TRUE;
-                }
+                if(gel_parser_check_close(&token, delim, line, pos, error))
+                    parsing = FALSE;
                 else
-                if(delim == 0)
-                {
-                    g_propagate_error(error, g_error_new(
-                        GEL_PARSER_ERROR, GEL_PARSER_ERROR_UNEXP_DELIM,
-                        "Unexpected '%c' at line %u, char %u",
-                        token, scanner->next_line, scanner->next_position));
                     failed = TRUE;
-                }
-                else
-                    parsing = FALSE;
                 break;
-            case G_TOKEN_EOF:
+            case GEL_TOKEN_EOF:
                 if(line != 0)
                 {
-                    g_propagate_error(error, g_error_new(
-                        GEL_PARSER_ERROR, GEL_PARSER_ERROR_UNEXP_EOF_IN_ARRAY,
-                        "'%c' opened at line %u, char %u was not closed",
-                        delim, line, pos));
+                    gel_parser_eof_error(delim, line, pos, error);
                     failed = TRUE;
                 }
                 parsing = FALSE;
                 break;
-            case G_TOKEN_STRING:
-                g_scanner_get_next_token(scanner);
-                g_value_init(&value, G_TYPE_STRING);
-                g_value_set_string(&value, scanner->value.v_string);
-                break;
-            case G_TOKEN_ERROR:
-                g_scanner_get_next_token(scanner);
-                g_propagate_error(error, g_error_new(
-                    GEL_PARSER_ERROR, scanner->value.v_error,
-                    "%s at line %u, char %u",
-                    scanner_errors[scanner->value.v_error],
-                    scanner->line, scanner->position));
-                failed = TRUE;
-                break;
             case '\'':
-                g_scanner_get_next_token(scanner);
                 quoted = TRUE;
                 break;
             default:
-                g_scanner_get_next_token(scanner);
-                g_propagate_error(error, g_error_new(
-                    GEL_PARSER_ERROR, GEL_PARSER_ERROR_UNKNOWN_TOKEN,
-                    "Unknown token '%c' (%d) at line %u, char %u",
-                    token, token, scanner->next_line, scanner->next_position));
+                gel_parser_token_error(&token, error);
                 failed = TRUE;
                 break;
         }
 
-        if(name != NULL)
-        {
-            gboolean is_number = FALSE;
-            guint len = strlen(name);
-            if(name[0] == '-' && len > 1)
-            {
-                GScanner *num_scanner = gel_scanner_new();
-                g_scanner_input_text(num_scanner, name+1, len-1);
-                guint num_token = g_scanner_get_next_token(num_scanner);
-
-                if(g_scanner_peek_next_token(num_scanner) != G_TOKEN_EOF)
-                    num_token = G_TOKEN_EOF;
-
-                switch(num_token)
-                {
-                    case G_TOKEN_FLOAT:
-                        g_value_init(&value, G_TYPE_DOUBLE);
-                        g_value_set_double(&value,
-                            -(gdouble)num_scanner->value.v_float);
-                        is_number = TRUE;
-                        break;
-                    case G_TOKEN_INT:
-                        g_value_init(&value, G_TYPE_INT64);
-                        g_value_set_int64(&value,
-                            -(gint64)num_scanner->value.v_int64);
-                        is_number = TRUE;
-                        break;
-                    default:
-                        break;
-                }
-
-                g_scanner_destroy(num_scanner);
-            }
-            
-            if(!is_number)
-            {
-                GelVariable *variable = gel_variable_lookup_predefined(name);
-                GelSymbol *symbol = gel_symbol_new(name, variable);
-                g_value_init(&value, GEL_TYPE_SYMBOL);
-                g_value_take_boxed(&value, symbol);
-            }
-        }
-
         if(G_IS_VALUE(&value))
         {
             if(quoted)
@@ -430,10 +970,7 @@ GelArray* gel_parser_scan(GelParser *self, GValue *dest_value,
                     parsing = FALSE;
 
                     for(guint i = 1; i < code_n_values; i++)
-                    {
-                        GValue *next_value = gel_value_dup(code_values + i);
-                        self->next = g_list_append(self->next, next_value);
-                    }
+                        gel_parser_push_pending(self, code_values + i);
                 }
 
                 gel_array_free(code);
@@ -462,6 +999,33 @@ GelArray* gel_parser_scan(GelParser *self, GValue *dest_value,
 }
 
 
+/* Reads the values of a valid cache, defining the macros it holds */
+static
+gboolean gel_parser_next_cached_value(GelParser *self, GValue *value,
+                                      GError **error)
+{
+    gboolean is_macro = FALSE;
+
+    while(gel_cache_next_value(self->cache, value, &is_macro))
+    {
+        if(!is_macro)
+            return TRUE;
+
+        GError *macro_error = NULL;
+        gel_parser_macro_code_from_value(self, value, &macro_error);
+        g_value_unset(value);
+
+        if(macro_error != NULL)
+        {
+            g_propagate_error(error, macro_error);
+            return FALSE;
+        }
+    }
+
+    return FALSE;
+}
+
+
 /**
  * gel_parser_next_value:
  * @self: a #GelParser
@@ -480,6 +1044,9 @@ gboolean gel_parser_next_value(GelParser *self, GValue *value, GError **error)
     if(G_IS_VALUE(value))
         g_value_unset(value);
 
+    if(self->cache != NULL && gel_cache_is_valid(self->cache))
+        return gel_parser_next_cached_value(self, value, error);
+
     gboolean result = FALSE;
     GError *parsed_error = NULL;
 
@@ -494,6 +1061,19 @@ gboolean gel_parser_next_value(GelParser *self, GValue *value, GError **error)
     else
         result = G_IS_VALUE(value);
 
+    if(self->cache != NULL)
+    {
+        if(result)
+            gel_cache_add(self->cache, value);
+        else
+        {
+            if(parsed_error == NULL)
+                gel_cache_save(self->cache, NULL);
+            gel_cache_free(self->cache);
+            self->cache = NULL;
+        }
+    }
+
     return result;
 }
 
@@ -509,7 +1089,312 @@ gboolean gel_parser_next_value(GelParser *self, GValue *value, GError **error)
  */
 GelArray* gel_parser_get_values(GelParser *self, GError **error)
 {
-    return gel_parser_scan(self, NULL, 0, 0, 0, error);
+    if(self->cache == NULL)
+        return gel_parser_scan(self, NULL, 0, 0, 0, error);
+
+    GelArray *array = gel_array_new(ARRAY_N_PREALLOCATED);
+    GError *parsed_error = NULL;
+    GValue value = {0};
+
+    while(gel_parser_next_value(self, &value, &parsed_error))
+    {
+        gel_array_append(array, &value);
+        g_value_unset(&value);
+    }
+
+    if(parsed_error != NULL)
+    {
+        g_propagate_error(error, parsed_error);
+        gel_array_free(array);
+        array = NULL;
+    }
+
+    return array;
+}
+
+
+static
+gboolean gel_parser_data(GelParser *self, GelToken *token,
+                         const GelParserCallbacks *callbacks,
+                         gpointer user_data, GError **error)
+{
+    switch(token->type)
+    {
+        case '(':
+        case '[':
+        case '{':
+        {
+            gchar delim = token->type;
+            guint line = token->line;
+            guint pos = token->position;
+
+            if(callbacks->start_array != NULL &&
+               !callbacks->start_array(self, delim, user_data, error))
+                return FALSE;
+
+            for(;;)
+            {
+                gel_parser_next_token(self, token);
+                if(token->type == ')' || token->type == ']' ||
+                   token->type == '}')
+                    break;
+
+                if(token->type == GEL_TOKEN_EOF)
+                {
+                    gel_parser_eof_error(delim, line, pos, error);
+                    return FALSE;
+                }
+
+                if(!gel_parser_data(self, token, callbacks, user_data, error))
+                    return FALSE;
+            }
+
+            if(!gel_parser_check_close(token, delim, line, pos, error))
+                return FALSE;
+
+            return callbacks->end_array == NULL ||
+                callbacks->end_array(self, delim, user_data, error);
+        }
+        case ')':
+        case ']':
+        case '}':
+            gel_parser_check_close(token, 0, 0, 0, error);
+            return FALSE;
+        case '\'':
+        {
+            if(callbacks->start_array != NULL &&
+               !callbacks->start_array(self, '(', user_data, error))
+                return FALSE;
+
+            if(callbacks->atom != NULL)
+            {
+                GValue value = {0};
+                g_value_init(&value, GEL_TYPE_SYMBOL);
+                g_value_take_boxed(&value, gel_symbol_new("quote", NULL));
+                gboolean result =
+                    callbacks->atom(self, &value, user_data, error);
+                g_value_unset(&value);
+                if(!result)
+                    return FALSE;
+            }
+
+            gel_parser_next_token(self, token);
+            if(token->type == GEL_TOKEN_EOF)
+            {
+                token->type = GEL_TOKEN_ERROR;
+                token->value.v_error = GEL_PARSER_ERROR_UNEXP_EOF;
+                gel_parser_token_error(token, error);
+                return FALSE;
+            }
+
+            if(!gel_parser_data(self, token, callbacks, user_data, error))
+                return FALSE;
+
+            return callbacks->end_array == NULL ||
+                callbacks->end_array(self, '(', user_data, error);
+        }
+        case GEL_TOKEN_IDENTIFIER:
+        case GEL_TOKEN_FLOAT:
+        case GEL_TOKEN_INT:
+        case GEL_TOKEN_STRING:
+        {
+            if(callbacks->atom == NULL)
+                return TRUE;
+
+            GValue value = {0};
+            gel_parser_atom(self, token, &value, TRUE);
+            gboolean result = callbacks->atom(self, &value, user_data, error);
+            g_value_unset(&value);
+            return result;
+        }
+        default:
+            gel_parser_token_error(token, error);
+            return FALSE;
+    }
+}
+
+
+/**
+ * GelParserCallbacks:
+ * @start_array: called when an array is opened with @delim,
+ *   that can be '(', '[' or '{'
+ * @end_array: called when the array opened with @delim is closed
+ * @atom: called for each literal or symbol. @value is owned by the parser
+ *   and is only valid during the call
+ *
+ * Callbacks used by #gel_parser_parse_data. Any of them can be NULL.
+ * A callback can return #FALSE to stop the parsing,
+ * optionally setting the #GError it receives.
+ */
+
+/**
+ * gel_parser_parse_data:
+ * @self: a #GelParser
+ * @callbacks: a #GelParserCallbacks with the functions to call
+ * @user_data: data to pass to the callbacks
+ * @error: return location for a #GError, or NULL
+ *
+ * Parses all the remaining input of @self as data, calling @callbacks
+ * as the elements are found, without building any #GelArray.
+ * Macros are not expanded and symbols are not bound to predefined values.
+ * A quoted value 'x is reported as the array (quote x).
+ *
+ * Returns: #TRUE if the input was parsed until the end,
+ * #FALSE if an error occured or a callback stopped the parsing
+ */
+gboolean gel_parser_parse_data(GelParser *self,
+                               const GelParserCallbacks *callbacks,
+                               gpointer user_data, GError **error)
+{
+    g_return_val_if_fail(self != NULL, FALSE);
+    g_return_val_if_fail(callbacks != NULL, FALSE);
+
+    GelToken token;
+    for(;;)
+    {
+        gel_parser_next_token(self, &token);
+        if(token.type == GEL_TOKEN_EOF)
+            return TRUE;
+
+        if(!gel_parser_data(self, &token, callbacks, user_data, error))
+            return FALSE;
+    }
+}
+
+
+typedef struct _GelParserBuilder GelParserBuilder;
+
+struct _GelParserBuilder
+{
+    GValue *value;
+    GSList *arrays;
+};
+
+
+static
+void gel_parser_builder_add(GelParserBuilder *builder, const GValue *value)
+{
+    if(builder->arrays != NULL)
+        gel_array_append(builder->arrays->data, value);
+    else
+        gel_value_copy(value, builder->value);
+}
+
+
+static
+gboolean gel_parser_builder_start(GelParser *self, gchar delim,
+                                  gpointer user_data, GError **error)
+{
+    GelParserBuilder *builder = user_data;
+    GelArray *array = gel_array_new(ARRAY_N_PREALLOCATED);
+
+    if(delim != '(')
+    {
+        GValue value = {0};
+        g_value_init(&value, GEL_TYPE_SYMBOL);
+        g_value_take_boxed(&value,
+            gel_symbol_new(delim == '[' ? "array" : "hash", NULL));
+        gel_array_append(array, &value);
+        g_value_unset(&value);
+    }
+
+    builder->arrays = g_slist_prepend(builder->arrays, array);
+    return TRUE;
+}
+
+
+static
+gboolean gel_parser_builder_end(GelParser *self, gchar delim,
+                                gpointer user_data, GError **error)
+{
+    GelParserBuilder *builder = user_data;
+    GValue value = {0};
+
+    g_value_init(&value, GEL_TYPE_ARRAY);
+    g_value_take_boxed(&value, builder->arrays->data);
+    builder->arrays = g_slist_delete_link(builder->arrays, builder->arrays);
+
+    gel_parser_builder_add(builder, &value);
+    g_value_unset(&value);
+    return TRUE;
+}
+
+
+static
+gboolean gel_parser_builder_atom(GelParser *self, const GValue *value,
+                                 gpointer user_data, GError **error)
+{
+    gel_parser_builder_add(user_data, value);
+    return TRUE;
+}
+
+
+/**
+ * gel_parser_next_data_value:
+ * @self: a #GelParser
+ * @value: address of a #GValue to store the result
+ * @error: return location for a #GError, or NULL
+ *
+ * Obtains the next top level #GValue parsed as data,
+ * like #gel_parser_parse_data does.
+ * Arrays opened with '[' or '{' start with the unbound symbols
+ * array and hash. The parser does not keep any reference to @value,
+ * so the input can be consumed one value at a time with bounded memory.
+ *
+ * Returns: #TRUE if a value was obtained, #FALSE at the end of the input
+ * or if an error occured
+ */
+gboolean gel_parser_next_data_value(GelParser *self, GValue *value,
+                                    GError **error)
+{
+    g_return_val_if_fail(self != NULL, FALSE);
+    g_return_val_if_fail(value != NULL, FALSE);
+
+    static const GelParserCallbacks callbacks = {
+        gel_parser_builder_start,
+        gel_parser_builder_end,
+        gel_parser_builder_atom
+    };
+
+    if(G_IS_VALUE(value))
+        g_value_unset(value);
+
+    GelToken token;
+    gel_parser_next_token(self, &token);
+    if(token.type == GEL_TOKEN_EOF)
+        return FALSE;
+
+    GelParserBuilder builder = {value, NULL};
+    if(!gel_parser_data(self, &token, &callbacks, &builder, error))
+    {
+        g_slist_free_full(builder.arrays, (GDestroyNotify)gel_array_free);
+        if(G_IS_VALUE(value))
+            g_value_unset(value);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+static
+void gel_parser_release_input(GelParser *self)
+{
+    if(self->cache != NULL)
+    {
+        gel_cache_free(self->cache);
+        self->cache = NULL;
+    }
+    if(self->mapped != NULL)
+    {
+        g_mapped_file_unref(self->mapped);
+        self->mapped = NULL;
+    }
+    g_free(self->contents);
+    self->contents = NULL;
+    self->fd = -1;
+    self->line = 1;
+    self->position = 0;
 }
 
 
@@ -519,14 +1404,20 @@ GelArray* gel_parser_get_values(GelParser *self, GError **error)
  * @text: text to parse
  * @text_len: length of the content to parse, or -1 if it is zero terminated.
  *
- * Prepares the scanner associated to the #GelParser @self to scan a text
+ * Prepares the #GelParser @self to parse a text.
+ * @text is not copied, so it must be kept until the parsing ends.
  *
  */
 void gel_parser_input_text(GelParser *self, const gchar *text, gsize text_len)
 {
     g_return_if_fail(self != NULL);
 
-    g_scanner_input_text(self->scanner, text, (guint)text_len);
+    if(text_len == (gsize)-1)
+        text_len = strlen(text);
+
+    gel_parser_release_input(self);
+    self->text = text;
+    self->text_end = text + text_len;
 }
 
 
@@ -535,13 +1426,111 @@ void gel_parser_input_text(GelParser *self, const gchar *text, gsize text_len)
  * @self: a #GelParser
  * @fd: a file descriptor
  *
- * Prepares the scanner associated to the #GelParser @self to scan a file
+ * Prepares the #GelParser @self to parse the content read from @fd
  */
 void gel_parser_input_file(GelParser *self, gint fd)
 {
     g_return_if_fail(self != NULL);
 
-    g_scanner_input_file(self->scanner, fd);
+    gel_parser_release_input(self);
+    self->text = self->buffer;
+    self->text_end = self->buffer;
+    self->fd = fd;
+}
+
+
+/**
+ * gel_parser_input_mapped_file:
+ * @self: a #GelParser
+ * @filename: path of the file to parse
+ * @error: return location for a #GError, or NULL
+ *
+ * Maps the file @filename into memory and prepares the #GelParser @self
+ * to parse it in place, without reading it into a buffer first.
+ * The mapping is kept by @self until another input is set or it is freed.
+ *
+ * Files that can not be mapped, as pipes or /dev/stdin,
+ * are read into memory instead.
+ *
+ * Returns: #TRUE if the file was mapped or read, #FALSE if an error occured
+ */
+gboolean gel_parser_input_mapped_file(GelParser *self, const gchar *filename,
+                                      GError **error)
+{
+    g_return_val_if_fail(self != NULL, FALSE);
+    g_return_val_if_fail(filename != NULL, FALSE);
+
+    /* a pipe would be mapped as an empty file */
+    GMappedFile *mapped = NULL;
+    if(g_file_test(filename, G_FILE_TEST_IS_REGULAR))
+        mapped = g_mapped_file_new(filename, FALSE, NULL);
+
+    if(mapped == NULL)
+    {
+        gchar *contents = NULL;
+        gsize length = 0;
+        if(!g_file_get_contents(filename, &contents, &length, error))
+            return FALSE;
+
+        gel_parser_release_input(self);
+        self->contents = contents;
+        self->text = contents;
+        self->text_end = contents + length;
+        return TRUE;
+    }
+
+    gel_parser_release_input(self);
+    self->mapped = mapped;
+    self->text = g_mapped_file_get_contents(mapped);
+    self->text_end = self->text + g_mapped_file_get_length(mapped);
+
+    return TRUE;
+}
+
+
+/**
+ * gel_parser_input_cached_file:
+ * @self: a #GelParser
+ * @filename: path of the file to parse
+ * @cache_filename: path of the file that caches the values of @filename
+ * @error: return location for a #GError, or NULL
+ *
+ * Prepares the #GelParser @self to parse the file @filename,
+ * like #gel_parser_input_mapped_file does, using @cache_filename
+ * to avoid parsing it again.
+ *
+ * If @cache_filename holds the values of the current content of @filename,
+ * they are read from it, already expanded, and the macros defined by
+ * @filename are defined again.
+ * Otherwise @filename is parsed and, once it is parsed to the end
+ * without errors, its values are saved in @cache_filename.
+ * Failing to save the cache is not reported.
+ *
+ * As the expansion of @filename depends on the macros defined before,
+ * the cache is silently bypassed if @self already has macros:
+ * @filename is then parsed as usual and @cache_filename is neither
+ * read nor written.
+ *
+ * Files that can not be mapped are read into memory,
+ * and their content is checked against the cache the same way.
+ *
+ * Returns: #TRUE if the file was mapped or read, #FALSE if an error occured
+ */
+gboolean gel_parser_input_cached_file(GelParser *self, const gchar *filename,
+                                      const gchar *cache_filename,
+                                      GError **error)
+{
+    g_return_val_if_fail(self != NULL, FALSE);
+    g_return_val_if_fail(cache_filename != NULL, FALSE);
+
+    if(!gel_parser_input_mapped_file(self, filename, error))
+        return FALSE;
+
+    if(g_hash_table_size(self->macros) == 0)
+        self->cache = gel_cache_new(cache_filename,
+            self->text, self->text_end - self->text);
+
+    return TRUE;
 }
 
 
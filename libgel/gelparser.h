@@ -35,10 +35,33 @@ void gel_parser_free(GelParser *self);
 
 void gel_parser_input_text(GelParser *self, const gchar *text, gsize text_len);
 void gel_parser_input_file(GelParser *self, gint fd);
+gboolean gel_parser_input_mapped_file(GelParser *self, const gchar *filename,
+                                      GError **error);
+gboolean gel_parser_input_cached_file(GelParser *self, const gchar *filename,
+                                      const gchar *cache_filename,
+                                      GError **error);
 
 gboolean gel_parser_next_value(GelParser *self, GValue *value, GError **error);
 GelArray* gel_parser_get_values(GelParser *self, GError **error);
 
+typedef struct _GelParserCallbacks GelParserCallbacks;
+
+struct _GelParserCallbacks
+{
+    gboolean (*start_array)(GelParser *parser, gchar delim,
+                            gpointer user_data, GError **error);
+    gboolean (*end_array)(GelParser *parser, gchar delim,
+                          gpointer user_data, GError **error);
+    gboolean (*atom)(GelParser *parser, const GValue *value,
+                     gpointer user_data, GError **error);
+};
+
+gboolean gel_parser_parse_data(GelParser *self,
+                               const GelParserCallbacks *callbacks,
+                               gpointer user_data, GError **error);
+gboolean gel_parser_next_data_value(GelParser *self, GValue *value,
+                                    GError **error);
+
 typedef struct _GelParserIter GelParserIter;
 
 struct _GelParserIter
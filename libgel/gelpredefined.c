@@ -8,12 +8,37 @@
 #include <gelsymbol.h>
 #include <gelclosure.h>
 #include <gelclosureprivate.h>
+#include <geltypedarray.h>
+#include <geliterator.h>
+#include <gelhash.h>
+#include <gelvector.h>
+#include <geldict.h>
+#include <gelrope.h>
+#include <gelstringbuilder.h>
+#include <gelwriter.h>
+#include <gelparallel.h>
 
 #ifdef HAVE_GOBJECT_INTROSPECTION
 #include <geltypelib.h>
 #endif
 
 
+/*
+ * Stores value in dest_value as gel_value_copy does, except that a rope
+ * replaces a string instead of being flattened into it, so a string grown
+ * with (set s (+ s x)) stays a rope.
+ */
+static
+void store_value(const GValue *value, GValue *dest_value)
+{
+    if(G_VALUE_HOLDS(value, GEL_TYPE_ROPE)
+       && G_VALUE_HOLDS(dest_value, G_TYPE_STRING))
+        g_value_unset(dest_value);
+
+    gel_value_copy(value, dest_value);
+}
+
+
 static
 void symbol_set(GValue *return_value,
                 guint n_values, const GValue *values, GelContext *context)
@@ -37,7 +62,9 @@ void symbol_set(GValue *return_value,
         if(dest_value == NULL)
         {
             const gchar *name = gel_symbol_get_name(symbol);
-            dest_value = gel_context_lookup(context, name);
+            GelVariable *variable = gel_context_lookup_interned(context, name);
+            if(variable != NULL)
+                dest_value = gel_variable_get_value(variable);
         }
     }
     else
@@ -66,7 +93,7 @@ void symbol_set(GValue *return_value,
 
         if(src_value != NULL)
         {
-            gel_value_copy(src_value, dest_value);
+            store_value(src_value, dest_value);
             copied = TRUE;
         }
     }
@@ -87,12 +114,12 @@ static
 void array_set(GelArray *array, GValue *return_value,
                guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     gint64 index = 0;
     GValue *value = NULL;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "IV", &index, &value))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "IV", &index, &value))
     {
         guint array_n_values = gel_array_get_n_values(array);
         if(index < 0)
@@ -102,26 +129,110 @@ void array_set(GelArray *array, GValue *return_value,
             gel_error_index_out_of_bounds(context, __FUNCTION__, index);
             return;
         }
-        gel_value_copy(value, gel_array_get_values(array) + index);
+        store_value(value, gel_array_get_values(array) + index);
+    }
+
+    gel_params_tmp_clear(&tmp_params);
+}
+
+
+static
+void typed_array_error_element(GelTypedArray *array,
+                               GelContext *context, const gchar *f)
+{
+    if(gel_typed_array_get_kind(array) == GEL_TYPED_ARRAY_BYTE)
+        gel_error_expected(context, f, "number from 0 to 255");
+    else
+        gel_error_expected(context, f, "number");
+}
+
+
+static
+void typed_array_set(GelTypedArray *array, GValue *return_value,
+                     guint n_values, const GValue *values,
+                     GelContext *context)
+{
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
+    gint64 index = 0;
+    GValue *value = NULL;
+
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "IV", &index, &value))
+    {
+        guint array_n_values = gel_typed_array_get_n_elements(array);
+        if(index < 0)
+            index += array_n_values;
+        if(index < 0 || index >= array_n_values)
+            gel_error_index_out_of_bounds(context, __FUNCTION__, index);
+        else
+        if(!gel_typed_array_set(array, index, value))
+            typed_array_error_element(array, context, __FUNCTION__);
+    }
+
+    gel_params_tmp_clear(&tmp_params);
+}
+
+
+static
+void hash_set(GelHash *hash, GValue *return_value,
+              guint n_values, const GValue *values, GelContext *context)
+{
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
+    GValue *key = NULL;
+    GValue *value = NULL;
+
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "VV", &key, &value))
+        gel_hash_insert(hash, key, value);
+
+    gel_params_tmp_clear(&tmp_params);
+}
+
+
+static
+void vector_set(GelVector *vector, GValue *return_value,
+                guint n_values, const GValue *values, GelContext *context)
+{
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
+    gint64 index = 0;
+    GValue *value = NULL;
+
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "IV", &index, &value))
+    {
+        guint size = gel_vector_get_size(vector);
+        if(index < 0)
+            index += size;
+        if(index < 0 || index >= size)
+            gel_error_index_out_of_bounds(context, __FUNCTION__, index);
+        else
+        {
+            g_value_init(return_value, GEL_TYPE_VECTOR);
+            g_value_take_boxed(return_value,
+                gel_vector_set(vector, index, value));
+        }
     }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
 static
-void hash_set(GHashTable *hash, GValue *return_value,
+void dict_set(GelDict *dict, GValue *return_value,
               guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     GValue *key = NULL;
     GValue *value = NULL;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "VV", &key, &value))
-        g_hash_table_insert(hash, gel_value_dup(key), gel_value_dup(value));
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "VV", &key, &value))
+    {
+        g_value_init(return_value, GEL_TYPE_DICT);
+        g_value_take_boxed(return_value, gel_dict_insert(dict, key, value));
+    }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -131,10 +242,10 @@ void object_set(GObject *object, GValue *return_value,
 {
     gchar *name = NULL;
     GValue *value = NULL;
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "SV", &name, &value))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "SV", &name, &value))
         if(G_IS_OBJECT(object))
         {
             GObjectClass *gclass = G_OBJECT_GET_CLASS(object);
@@ -157,7 +268,7 @@ void object_set(GObject *object, GValue *return_value,
                 gel_error_no_such_property(context, __FUNCTION__, name);
         }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -165,11 +276,11 @@ static
 void array_get(GelArray *array, GValue *return_value,
                guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     gint64 index = 0;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "I", &index)) 
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "I", &index)) 
     {
         guint array_n_values = gel_array_get_n_values(array);
         if(index < 0)
@@ -184,28 +295,98 @@ void array_get(GelArray *array, GValue *return_value,
         gel_value_copy(gel_array_get_values(array) + index, return_value);
     }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
+}
+
+
+static
+void typed_array_get(GelTypedArray *array, GValue *return_value,
+                     guint n_values, const GValue *values,
+                     GelContext *context)
+{
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
+    gint64 index = 0;
+
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "I", &index))
+    {
+        guint array_n_values = gel_typed_array_get_n_elements(array);
+        if(index < 0)
+            index += array_n_values;
+
+        if(index < 0 || index >= array_n_values)
+            gel_error_index_out_of_bounds(context, __FUNCTION__, index);
+        else
+            gel_typed_array_get(array, index, return_value);
+    }
+
+    gel_params_tmp_clear(&tmp_params);
+}
+
+
+static
+void hash_get(GelHash *hash, GValue *return_value,
+              guint n_values, const GValue *values, GelContext *context)
+{
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
+    GValue *key = NULL;
+
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "V", &key))
+    {
+        const GValue *value = gel_hash_lookup(hash, key);
+        if(value != NULL)
+            gel_value_copy(value, return_value);
+        else
+            gel_error_invalid_key(context, __FUNCTION__, key);
+    }
+
+    gel_params_tmp_clear(&tmp_params);
+}
+
+
+static
+void vector_get(GelVector *vector, GValue *return_value,
+                guint n_values, const GValue *values, GelContext *context)
+{
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
+    gint64 index = 0;
+
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "I", &index))
+    {
+        guint size = gel_vector_get_size(vector);
+        if(index < 0)
+            index += size;
+
+        if(index < 0 || index >= size)
+            gel_error_index_out_of_bounds(context, __FUNCTION__, index);
+        else
+            gel_value_copy(gel_vector_get(vector, index), return_value);
+    }
+
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
 static
-void hash_get(GHashTable *hash, GValue *return_value,
+void dict_get(GelDict *dict, GValue *return_value,
               guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     GValue *key = NULL;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "V", &key))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "V", &key))
     {
-        GValue *value = g_hash_table_lookup(hash, key);
+        const GValue *value = gel_dict_lookup(dict, key);
         if(value != NULL)
             gel_value_copy(value, return_value);
         else
             gel_error_invalid_key(context, __FUNCTION__, key);
     }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -214,10 +395,10 @@ void object_get(GObject *object, GValue *return_value,
                 guint n_values, const GValue *values, GelContext *context)
 {
     const gchar *name = NULL;
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "S", &name))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "S", &name))
         if(G_IS_OBJECT(object))
         {
             GObjectClass *gclass = G_OBJECT_GET_CLASS(object);
@@ -232,7 +413,7 @@ void object_get(GObject *object, GValue *return_value,
                 gel_error_no_such_property(context, __FUNCTION__, name);
         }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -240,7 +421,59 @@ static
 void array_append(GelArray *array, GValue *return_value,
                   guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
+
+    for(guint i = 0; i < n_values; i++)
+    {
+        GValue tmp_value = {0};
+        const GValue *value =
+            gel_context_eval_into_value(context, values + i, &tmp_value);
+
+        if(gel_context_error(context))
+            goto end;
+
+        if(G_IS_VALUE(value))
+            gel_array_append(array, value);
+
+        if(G_IS_VALUE(&tmp_value))
+            g_value_unset(&tmp_value);
+    }
+
+    end:
+    gel_params_tmp_clear(&tmp_params);
+}
+
+
+static
+void hash_append(GelHash *hash, GValue *return_value,
+                 guint n_values, const GValue *values, GelContext *context)
+{
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
+
+    if(n_values % 2 == 0)
+        while(n_values > 0)
+        {
+            GValue *key = NULL;
+            GValue *value = NULL;
+
+            if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                    &n_values, &values, &tmp_params, "VV*", &key, &value))
+                gel_hash_insert(hash, key, value);
+            else
+                break;
+        }
+    else
+        gel_error_expected(context, __FUNCTION__, "an even number of values");
+
+    gel_params_tmp_clear(&tmp_params);
+}
+
+
+static
+void vector_append(GelVector *vector, GValue *return_value,
+                   guint n_values, const GValue *values, GelContext *context)
+{
+    GelArray *array = gel_array_new(n_values);
 
     for(guint i = 0; i < n_values; i++)
     {
@@ -258,16 +491,21 @@ void array_append(GelArray *array, GValue *return_value,
             g_value_unset(&tmp_value);
     }
 
+    g_value_init(return_value, GEL_TYPE_VECTOR);
+    g_value_take_boxed(return_value, gel_vector_append(vector,
+        gel_array_get_n_values(array), gel_array_get_values(array)));
+
     end:
-    gel_list_free(tmp_list);
+    gel_array_free(array);
 }
 
 
 static
-void hash_append(GHashTable *hash, GValue *return_value,
+void dict_append(GelDict *dict, GValue *return_value,
                  guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
+    GelDict *result = gel_dict_ref(dict);
 
     if(n_values % 2 == 0)
         while(n_values > 0)
@@ -275,17 +513,51 @@ void hash_append(GHashTable *hash, GValue *return_value,
             GValue *key = NULL;
             GValue *value = NULL;
 
-            if(gel_context_eval_params(context, __FUNCTION__,
-                    &n_values, &values, &tmp_list, "VV*", &key, &value))
-                g_hash_table_insert(hash,
-                    gel_value_dup(key), gel_value_dup(value));
+            if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                    &n_values, &values, &tmp_params, "VV*", &key, &value))
+            {
+                GelDict *tmp = gel_dict_insert(result, key, value);
+                gel_dict_unref(result);
+                result = tmp;
+            }
             else
                 break;
         }
     else
         gel_error_expected(context, __FUNCTION__, "an even number of values");
 
-    gel_list_free(tmp_list);
+    if(n_values == 0)
+    {
+        g_value_init(return_value, GEL_TYPE_DICT);
+        g_value_take_boxed(return_value, result);
+    }
+    else
+        gel_dict_unref(result);
+
+    gel_params_tmp_clear(&tmp_params);
+}
+
+
+static
+void string_builder_append(GelStringBuilder *builder, GValue *return_value,
+                           guint n_values, const GValue *values,
+                           GelContext *context)
+{
+    for(guint i = 0; i < n_values; i++)
+    {
+        GValue tmp_value = {0};
+        const GValue *value =
+            gel_context_eval_into_value(context, values + i, &tmp_value);
+
+        if(gel_context_error(context))
+            break;
+
+        if(G_IS_VALUE(value))
+            gel_string_builder_append(builder, value);
+
+        if(G_IS_VALUE(&tmp_value))
+            g_value_unset(&tmp_value);
+    }
 }
 
 
@@ -293,11 +565,11 @@ static
 void array_remove(GelArray *array, GValue *return_value,
                   guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     gint64 index = 0;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values,&tmp_list, "I", &index))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values,&tmp_params, "I", &index))
     {
         guint array_n_values = gel_array_get_n_values(array);
         if(index < 0)
@@ -312,29 +584,47 @@ void array_remove(GelArray *array, GValue *return_value,
         gel_array_remove(array, index);
     }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
 static
-void hash_remove(GHashTable *hash, GValue *return_value,
+void hash_remove(GelHash *hash, GValue *return_value,
                  guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     GValue *key = NULL;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "V", &key))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "V", &key))
     {
-        GValue *value = g_hash_table_lookup(hash, key);
+        const GValue *value = gel_hash_lookup(hash, key);
         if(value != NULL)
         {
             gel_value_copy(value, return_value); 
-            g_hash_table_remove(hash, key);
+            gel_hash_remove(hash, key);
         }
     }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
+}
+
+
+static
+void dict_remove(GelDict *dict, GValue *return_value,
+                 guint n_values, const GValue *values, GelContext *context)
+{
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
+    GValue *key = NULL;
+
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "V", &key))
+    {
+        g_value_init(return_value, GEL_TYPE_DICT);
+        g_value_take_boxed(return_value, gel_dict_remove(dict, key));
+    }
+
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -342,26 +632,26 @@ static
 void array_size(GelArray *array, GValue *return_value,
                 guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
 
     g_value_init(return_value, G_TYPE_INT64);
     g_value_set_int64(return_value, gel_array_get_n_values(array));
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
 static
-void hash_size(GHashTable *hash, GValue *return_value,
+void hash_size(GelHash *hash, GValue *return_value,
                guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
 
     g_value_init(return_value, G_TYPE_INT64);
-    guint result = g_hash_table_size(hash);
+    guint result = gel_hash_get_size(hash);
     g_value_set_int64(return_value, result);
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -369,7 +659,7 @@ static
 void array_find(GClosure *closure, GelArray *array, GValue *return_value,
                 guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
 
     const GValue *array_values = gel_array_get_values(array);
     guint array_n_values = gel_array_get_n_values(array);
@@ -387,36 +677,134 @@ void array_find(GClosure *closure, GelArray *array, GValue *return_value,
     g_value_init(return_value, G_TYPE_INT64);
     g_value_set_int64(return_value, result);
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
 static
-void hash_find(GClosure *closure, GHashTable *hash, GValue *return_value,
+void hash_find(GClosure *closure, GelHash *hash, GValue *return_value,
                guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
 
-    GHashTableIter iter = {0};
-    g_hash_table_iter_init(&iter, hash);
+    GelHashIter iter = {0};
+    gel_hash_iter_init(&iter, hash);
 
     const GValue *k = NULL;
     const GValue *v = NULL;
     gboolean running = TRUE;
 
-    while(g_hash_table_iter_next(&iter, (void**)&k, (void**)&v) && running)
+    while(running && gel_hash_iter_next(&iter, &k, &v))
     {
+        /* the closure may change the hash, moving its entries */
+        GValue key = {0};
         GValue value = {0};
+        gel_value_copy(k, &key);
         g_closure_invoke(closure, &value, 1, v, context);
         if(gel_value_to_boolean(&value))
         {
-            gel_value_copy(k, return_value);
+            gel_value_copy(&key, return_value);
             running = FALSE;
         }
         g_value_unset(&value);
+        g_value_unset(&key);
+    }
+
+    gel_hash_iter_clear(&iter);
+    gel_params_tmp_clear(&tmp_params);
+}
+
+
+/* like array_find, stops at the first value found */
+static
+void iterator_find(GClosure *closure, const GValue *iterator,
+                   GValue *return_value, GelContext *context)
+{
+    GelIteratorCursor *cursor = gel_iterator_cursor_new(iterator);
+    GValue element = {0};
+    gint64 result = -1;
+
+    for(gint64 i = 0; result == -1
+            && gel_iterator_cursor_next(cursor, &element, context); i++)
+    {
+        GValue value = {0};
+        g_closure_invoke(closure, &value, 1, &element, context);
+        if(gel_value_to_boolean(&value))
+            result = i;
+        if(G_IS_VALUE(&value))
+            g_value_unset(&value);
+        g_value_unset(&element);
+    }
+
+    gel_iterator_cursor_free(cursor);
+
+    if(!gel_context_error(context))
+    {
+        g_value_init(return_value, G_TYPE_INT64);
+        g_value_set_int64(return_value, result);
+    }
+}
+
+
+/* Tells if @head names the predefined @name, as it does unless shadowed */
+static
+gboolean is_predefined_head(GelContext *context, const GValue *head,
+                            const gchar *name)
+{
+    if(!G_VALUE_HOLDS(head, GEL_TYPE_SYMBOL))
+        return FALSE;
+
+    const GelSymbol *symbol = g_value_get_boxed(head);
+    const GelVariable *variable =
+        gel_context_get_variable(context, gel_symbol_get_name(symbol));
+    const GValue *value = (variable != NULL) ?
+        gel_variable_get_value(variable) : gel_symbol_get_value(symbol);
+    const GValue *predefined = gel_value_lookup_predefined(name);
+
+    return value != NULL && predefined != NULL
+        && G_VALUE_HOLDS(value, G_TYPE_CLOSURE)
+        && g_value_get_boxed(value) == g_value_get_boxed(predefined);
+}
+
+
+/*
+ * Evaluates @value as the sequence walked by find or for. A call to the
+ * predefined range gives the lazy range of iter instead, since the array
+ * it would build is only walked once.
+ */
+static
+const GValue* eval_iterable(GelContext *context, const GValue *value,
+                            GValue *tmp_value)
+{
+    if(G_VALUE_HOLDS(value, GEL_TYPE_ARRAY))
+    {
+        GelArray *array = g_value_get_boxed(value);
+        const GValue *values = gel_array_get_values(array);
+        guint n_values = gel_array_get_n_values(array) - 1;
+
+        if(n_values == 2 && is_predefined_head(context, values + 0, "range"))
+        {
+            GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
+            const GValue *result = NULL;
+            gint64 first = 0;
+            gint64 last = 0;
+
+            values++;
+            if(gel_context_eval_params_tmp(context, "range_",
+                    &n_values, &values, &tmp_params, "II", &first, &last))
+            {
+                g_value_init(tmp_value, GEL_TYPE_ITERATOR);
+                g_value_take_boxed(tmp_value,
+                    gel_iterator_new_range(first, last));
+                result = tmp_value;
+            }
+
+            gel_params_tmp_clear(&tmp_params);
+            return result;
+        }
     }
 
-    gel_list_free(tmp_list);
+    return gel_context_eval_into_value(context, value, tmp_value);
 }
 
 
@@ -424,7 +812,7 @@ static
 void array_filter(GClosure *closure, GelArray *array, GValue *return_value,
                   guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
 
     guint array_n_values = gel_array_get_n_values(array);
     GValue *array_values = gel_array_get_values(array);
@@ -443,37 +831,43 @@ void array_filter(GClosure *closure, GelArray *array, GValue *return_value,
     g_value_init(return_value, GEL_TYPE_ARRAY);
     g_value_take_boxed(return_value, result_array);
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
 static
-void hash_filter(GClosure *closure, GHashTable *hash, GValue *return_value,
+void hash_filter(GClosure *closure, GelHash *hash, GValue *return_value,
                  guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
 
-    GHashTable *result_hash = gel_hash_table_new();
-    GHashTableIter iter = {0};
-    g_hash_table_iter_init(&iter, hash);
+    GelHash *result_hash = gel_hash_new(0);
+    GelHashIter iter = {0};
+    gel_hash_iter_init(&iter, hash);
 
     const GValue *k = NULL;
     const GValue *v = NULL;
 
-    while(g_hash_table_iter_next(&iter, (void**)&k, (void**)&v))
+    while(gel_hash_iter_next(&iter, &k, &v))
     {
+        /* the closure may change the hash, moving its entries */
+        GValue key = {0};
+        GValue entry_value = {0};
         GValue value = {0};
-        g_closure_invoke(closure, &value, 1, v, context);
+        gel_value_copy(k, &key);
+        gel_value_copy(v, &entry_value);
+        g_closure_invoke(closure, &value, 1, &entry_value, context);
         if(gel_value_to_boolean(&value))
-            g_hash_table_insert(result_hash,
-                gel_value_dup(k), gel_value_dup(v));
+            gel_hash_insert(result_hash, &key, &entry_value);
         g_value_unset(&value);
+        g_value_unset(&entry_value);
+        g_value_unset(&key);
     }
 
-    g_value_init(return_value, G_TYPE_HASH_TABLE);
+    g_value_init(return_value, GEL_TYPE_HASH);
     g_value_take_boxed(return_value, result_hash);
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -481,20 +875,20 @@ static
 void def_(GClosure *self, GValue *return_value,
           guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     gchar *name = NULL;
     GValue *value = NULL;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "sV", &name, &value))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "sV", &name, &value))
     {
-        if(gel_context_get_variable(context, name) != NULL)
+        if(gel_context_get_interned(context, name) != NULL)
             gel_error_symbol_exists(context, __FUNCTION__, name);
         else
             gel_context_define_value(context, name, gel_value_dup(value));
     }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -502,12 +896,12 @@ static
 void defn_(GClosure *self, GValue *return_value,
            guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     const gchar *name = NULL;
     const GelArray *vars = NULL;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "sa*", &name, &vars))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "sa*", &name, &vars))
     {
         gchar *variadic = NULL;
         gchar *invalid = NULL;
@@ -522,7 +916,6 @@ void defn_(GClosure *self, GValue *return_value,
             GValue *value = gel_value_new_from_boxed(G_TYPE_CLOSURE, closure);
 
             gel_context_define_value(context, name, value);
-            gel_closure_close_over(closure);
         }
         else
         {
@@ -537,11 +930,11 @@ static
 void fn_(GClosure *self, GValue *return_value,
          guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     const GelArray *vars = NULL;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "a*", &vars))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "a*", &vars))
     {
         gchar *variadic = NULL;
         gchar *invalid = NULL;
@@ -553,10 +946,8 @@ void fn_(GClosure *self, GValue *return_value,
                 gel_closure_new(NULL, args, variadic,
                     n_values, values, context);
 
-            gel_closure_close_over(closure);
-
             g_value_init(return_value, G_TYPE_CLOSURE);
-            g_value_set_boxed(return_value, closure);
+            g_value_take_boxed(return_value, closure);
         }
         else
         {
@@ -604,11 +995,11 @@ void let_(GClosure *self, GValue *return_value,
         return;
     }
 
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     GelArray *bindings = NULL;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "a*", &bindings))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "a*", &bindings))
     {
         guint binding_n_values = gel_array_get_n_values(bindings);
         const GValue *binding_values = gel_array_get_values(bindings);
@@ -623,9 +1014,9 @@ void let_(GClosure *self, GValue *return_value,
                 const gchar *name = NULL;
                 GValue *value = NULL;
 
-                if(gel_context_eval_params(let_context, __FUNCTION__,
+                if(gel_context_eval_params_tmp(let_context, __FUNCTION__,
                         &binding_n_values, &binding_values,
-                        &tmp_list, "sV*", &name, &value))
+                        &tmp_params, "sV*", &name, &value))
                     gel_context_define_value(let_context, name, gel_value_dup(value));
                 else
                     failed = TRUE;
@@ -644,7 +1035,7 @@ void let_(GClosure *self, GValue *return_value,
                 "an even number of values in bindings");
     }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -677,6 +1068,37 @@ void eval_(GClosure *self, GValue *return_value,
 }
 
 
+/*
+ * Copies the arrays of value, as code arrays are shared by closures and
+ * macro expansions and a quoted array can be changed by the script.
+ */
+static
+void quote_copy(const GValue *value, GValue *dest_value)
+{
+    if(!G_VALUE_HOLDS(value, GEL_TYPE_ARRAY))
+    {
+        gel_value_copy(value, dest_value);
+        return;
+    }
+
+    const GelArray *array = g_value_get_boxed(value);
+    const GValue *array_values = gel_array_get_values(array);
+    const guint n_values = gel_array_get_n_values(array);
+    GelArray *copy = gel_array_new(n_values);
+
+    for(guint i = 0; i < n_values; i++)
+    {
+        GValue tmp_value = {0};
+        quote_copy(array_values + i, &tmp_value);
+        gel_array_append(copy, &tmp_value);
+        g_value_unset(&tmp_value);
+    }
+
+    g_value_init(dest_value, GEL_TYPE_ARRAY);
+    g_value_take_boxed(dest_value, copy);
+}
+
+
 static
 void quote_(GClosure *self, GValue *return_value,
             guint n_values, const GValue *values, GelContext *context)
@@ -688,7 +1110,7 @@ void quote_(GClosure *self, GValue *return_value,
         return;
     }
 
-    gel_value_copy(values + 0, return_value);
+    quote_copy(values + 0, return_value);
 }
 
 
@@ -720,49 +1142,83 @@ static
 void apply_(GClosure *self, GValue *return_value,
             guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     GClosure *closure = NULL;
     GelArray *array = NULL;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "CA", &closure, &array))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "CA", &closure, &array))
         g_closure_invoke(closure, return_value,
             gel_array_get_n_values(array),
             gel_array_get_values(array),
             context);
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
+/*
+ * map over an iterator is lazy and returns an iterator, its closure is
+ * called each time the result is iterated. Other values are collected,
+ * see gel_iterator_collect, and mapped into an array at once.
+ */
 static
 void map_(GClosure *self, GValue *return_value,
           guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     GClosure *closure = NULL;
 
     guint n_arrays = n_values - 1;
+    GValue *sources = g_new0(GValue, n_arrays);
     GelArray **arrays = g_new0(GelArray *, n_arrays);
+    GelArray **collected = g_new0(GelArray *, n_arrays);
     guint32 result_n_values = G_MAXUINT;
+    gboolean lazy = FALSE;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "C*", &closure))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "C*", &closure))
     {
         guint i_array = 0;
         while(n_values > 0)
-            if(gel_context_eval_params(context, __FUNCTION__,
-                    &n_values, &values, &tmp_list, "A*", &arrays[i_array]))
+        {
+            GValue *value = NULL;
+            if(!gel_context_eval_params_tmp(context, __FUNCTION__,
+                    &n_values, &values, &tmp_params, "V*", &value))
+                break;
+
+            if(G_VALUE_HOLDS(value, GEL_TYPE_ITERATOR))
+                lazy = TRUE;
+            else
+            if(G_VALUE_HOLDS(value, GEL_TYPE_ARRAY))
+                arrays[i_array] = g_value_get_boxed(value);
+            else
+            if(G_VALUE_HOLDS(value, GEL_TYPE_VECTOR))
+                arrays[i_array] = collected[i_array] =
+                    gel_iterator_collect(value, context);
+            else
             {
+                gel_error_value_not_of_type(context,
+                    __FUNCTION__, value, GEL_TYPE_ARRAY);
+                break;
+            }
+
+            if(arrays[i_array] != NULL)
                 result_n_values =
                     MIN(result_n_values,
                         gel_array_get_n_values(arrays[i_array]));
-                    
-                i_array++;
-            }
-            else
-                break;
 
+            /* the values are kept by tmp_params, a shallow copy is enough */
+            sources[i_array++] = *value;
+        }
+
+        if(i_array == n_arrays && lazy)
+        {
+            g_value_init(return_value, GEL_TYPE_ITERATOR);
+            g_value_take_boxed(return_value,
+                gel_iterator_new_map(closure, n_arrays, sources));
+        }
+        else
         if(i_array == n_arrays)
         {
             GelArray *result_array = gel_array_new(result_n_values);
@@ -795,7 +1251,270 @@ void map_(GClosure *self, GValue *return_value,
         }
     }
 
-    gel_list_free(tmp_list);
+    for(guint i = 0; i < n_arrays; i++)
+        if(collected[i] != NULL)
+            gel_array_free(collected[i]);
+
+    g_free(collected);
+    g_free(arrays);
+    g_free(sources);
+    gel_params_tmp_clear(&tmp_params);
+}
+
+
+/*
+ * The parallel versions of map, filter and reduce run the closure for
+ * chunks of the arrays in several threads, see gel_parallel_run.
+ * The closure must not change the variables it shares with other calls.
+ */
+typedef struct _GelParallelCall GelParallelCall;
+
+struct _GelParallelCall
+{
+    GClosure *closure;
+    guint n_arrays;
+    GelArray **arrays;
+    GValue *results;
+};
+
+
+static
+void pmap_chunk(GelContext *context, guint start, guint end,
+                GelParallelCall *call)
+{
+    for(guint i = start; i < end && !gel_context_error(context); i++)
+    {
+        GelArray *args = gel_array_new(call->n_arrays);
+        for(guint ia = 0; ia < call->n_arrays; ia++)
+            gel_array_append(args, gel_array_get_values(call->arrays[ia]) + i);
+
+        g_closure_invoke(call->closure, call->results + i,
+            gel_array_get_n_values(args), gel_array_get_values(args),
+            context);
+
+        gel_array_free(args);
+    }
+}
+
+
+static
+void pfilter_chunk(GelContext *context, guint start, guint end,
+                   GelParallelCall *call)
+{
+    const GValue *array_values = gel_array_get_values(call->arrays[0]);
+
+    for(guint i = start; i < end && !gel_context_error(context); i++)
+        g_closure_invoke(call->closure, call->results + i,
+            1, array_values + i, context);
+}
+
+
+/* the result of each chunk is kept at the index of its first item */
+static
+void preduce_chunk(GelContext *context, guint start, guint end,
+                   GelParallelCall *call)
+{
+    const GValue *array_values = gel_array_get_values(call->arrays[0]);
+    GValue *result = call->results + start;
+
+    gel_value_copy(array_values + start, result);
+
+    for(guint i = start + 1; i < end && !gel_context_error(context); i++)
+    {
+        GValue args[2] = {{0}, {0}};
+        args[0] = *result;
+        gel_value_copy(array_values + i, args + 1);
+
+        memset(result, 0, sizeof(GValue));
+        g_closure_invoke(call->closure, result, 2, args, context);
+
+        g_value_unset(args + 0);
+        g_value_unset(args + 1);
+
+        if(!G_IS_VALUE(result) && !gel_context_error(context))
+            gel_error_expected(context, "preduce_", "a value");
+    }
+}
+
+
+static
+void parallel_results_free(GValue *results, guint n_results)
+{
+    for(guint i = 0; i < n_results; i++)
+        if(G_IS_VALUE(results + i))
+            g_value_unset(results + i);
+    g_free(results);
+}
+
+
+static
+void pmap_(GClosure *self, GValue *return_value,
+           guint n_values, const GValue *values, GelContext *context)
+{
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
+    GClosure *closure = NULL;
+
+    guint n_arrays = n_values - 1;
+    GelArray **arrays = g_new0(GelArray *, n_arrays);
+    guint32 result_n_values = G_MAXUINT;
+
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "C*", &closure))
+    {
+        guint i_array = 0;
+        while(n_values > 0)
+            if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                    &n_values, &values, &tmp_params, "A*", &arrays[i_array]))
+            {
+                result_n_values =
+                    MIN(result_n_values,
+                        gel_array_get_n_values(arrays[i_array]));
+                i_array++;
+            }
+            else
+                break;
+
+        if(i_array == n_arrays && n_arrays > 0)
+        {
+            GelParallelCall call =
+                {closure, n_arrays, arrays, g_new0(GValue, result_n_values)};
+
+            if(gel_parallel_run(context, result_n_values,
+                    (GelParallelFunc)pmap_chunk, &call))
+            {
+                GelArray *result_array = gel_array_new(result_n_values);
+
+                for(guint i = 0; i < result_n_values; i++)
+                    if(G_IS_VALUE(call.results + i))
+                        gel_array_append(result_array, call.results + i);
+
+                g_value_init(return_value, GEL_TYPE_ARRAY);
+                g_value_take_boxed(return_value, result_array);
+            }
+
+            parallel_results_free(call.results, result_n_values);
+        }
+        else
+        if(i_array == n_arrays)
+            gel_error_needs_at_least_n_arguments(context, __FUNCTION__, 2);
+    }
+
+    g_free(arrays);
+    gel_params_tmp_clear(&tmp_params);
+}
+
+
+static
+void pfilter_(GClosure *self, GValue *return_value,
+              guint n_values, const GValue *values, GelContext *context)
+{
+    guint n_args = 2;
+    if(n_values != n_args)
+    {
+        gel_error_needs_n_arguments(context, __FUNCTION__, n_args);
+        return;
+    }
+
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
+    GClosure *closure = NULL;
+    GelArray *array = NULL;
+
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "CA", &closure, &array))
+    {
+        guint array_n_values = gel_array_get_n_values(array);
+        GelParallelCall call =
+            {closure, 1, &array, g_new0(GValue, array_n_values)};
+
+        if(gel_parallel_run(context, array_n_values,
+                (GelParallelFunc)pfilter_chunk, &call))
+        {
+            const GValue *array_values = gel_array_get_values(array);
+            GelArray *result_array = gel_array_new(array_n_values);
+
+            for(guint i = 0; i < array_n_values; i++)
+                if(G_IS_VALUE(call.results + i)
+                   && gel_value_to_boolean(call.results + i))
+                    gel_array_append(result_array, array_values + i);
+
+            g_value_init(return_value, GEL_TYPE_ARRAY);
+            g_value_take_boxed(return_value, result_array);
+        }
+
+        parallel_results_free(call.results, array_n_values);
+    }
+
+    gel_params_tmp_clear(&tmp_params);
+}
+
+
+/*
+ * Chunks are reduced in parallel and their results are then reduced in
+ * order starting with the initial value, so the closure must be
+ * associative, but the initial value is used only once.
+ */
+static
+void preduce_(GClosure *self, GValue *return_value,
+              guint n_values, const GValue *values, GelContext *context)
+{
+    guint n_args = 3;
+    if(n_values != n_args)
+    {
+        gel_error_needs_n_arguments(context, __FUNCTION__, n_args);
+        return;
+    }
+
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
+    GClosure *closure = NULL;
+    GValue *initial = NULL;
+    GelArray *array = NULL;
+
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "CVA",
+            &closure, &initial, &array))
+    {
+        guint array_n_values = gel_array_get_n_values(array);
+        GelParallelCall call =
+            {closure, 1, &array, g_new0(GValue, array_n_values)};
+
+        if(gel_parallel_run(context, array_n_values,
+                (GelParallelFunc)preduce_chunk, &call))
+        {
+            GValue result = {0};
+            gel_value_copy(initial, &result);
+
+            for(guint i = 0; i < array_n_values; i++)
+                if(G_IS_VALUE(call.results + i))
+                {
+                    GValue args[2] = {{0}, {0}};
+                    args[0] = result;
+                    args[1] = call.results[i];
+
+                    memset(&result, 0, sizeof(GValue));
+                    g_closure_invoke(closure, &result, 2, args, context);
+
+                    g_value_unset(args + 0);
+                    if(gel_context_error(context))
+                        break;
+                    if(!G_IS_VALUE(&result))
+                    {
+                        gel_error_expected(context, __FUNCTION__, "a value");
+                        break;
+                    }
+                }
+
+            if(G_IS_VALUE(&result))
+            {
+                if(!gel_context_error(context))
+                    gel_value_copy(&result, return_value);
+                g_value_unset(&result);
+            }
+        }
+
+        parallel_results_free(call.results, array_n_values);
+    }
+
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -836,18 +1555,17 @@ static
 void hash_(GClosure *self, GValue *return_value,
            guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
-    GHashTable *hash = gel_hash_table_new();
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
+    GelHash *hash = gel_hash_new(n_values / 2);
 
     if(n_values % 2 == 0)
         while(n_values > 0)
         {
             GValue *key = NULL;
             GValue *value = NULL;
-            if(gel_context_eval_params(context, __FUNCTION__,
-                    &n_values, &values, &tmp_list, "VV*", &key, &value))
-                g_hash_table_insert(hash,
-                    gel_value_dup(key), gel_value_dup(value));
+            if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                    &n_values, &values, &tmp_params, "VV*", &key, &value))
+                gel_hash_insert(hash, key, value);
             else
                 break;
         }
@@ -856,11 +1574,190 @@ void hash_(GClosure *self, GValue *return_value,
 
     if(n_values == 0)
     {
-        g_value_init(return_value, G_TYPE_HASH_TABLE);
+        g_value_init(return_value, GEL_TYPE_HASH);
         g_value_take_boxed(return_value, hash);
     }
+    else
+        gel_hash_unref(hash);
+
+    gel_params_tmp_clear(&tmp_params);
+}
+
+
+static
+void vector_(GClosure *self, GValue *return_value,
+             guint n_values, const GValue *values, GelContext *context)
+{
+    GelArray *array = gel_array_new(n_values);
+    guint i;
+
+    for(i = 0; i < n_values; i++)
+    {
+        GValue tmp_value = {0};
+        const GValue *value =
+            gel_context_eval_into_value(context, values + i, &tmp_value);
+
+        if(gel_context_error(context))
+            break;
+
+        if(G_IS_VALUE(value))
+            gel_array_append(array, value);
+
+        if(G_IS_VALUE(&tmp_value))
+            g_value_unset(&tmp_value);
+    }
+
+    if(i == n_values)
+    {
+        g_value_init(return_value, GEL_TYPE_VECTOR);
+        g_value_take_boxed(return_value, gel_vector_new(
+            gel_array_get_n_values(array), gel_array_get_values(array)));
+    }
+
+    gel_array_free(array);
+}
+
+
+static
+void dict_(GClosure *self, GValue *return_value,
+           guint n_values, const GValue *values, GelContext *context)
+{
+    GelDict *dict = gel_dict_new();
+
+    dict_append(dict, return_value, n_values, values, context);
+    gel_dict_unref(dict);
+}
+
+
+static
+void string_builder_(GClosure *self, GValue *return_value,
+                     guint n_values, const GValue *values,
+                     GelContext *context)
+{
+    GelStringBuilder *builder = gel_string_builder_new();
+
+    string_builder_append(builder, return_value, n_values, values, context);
+
+    if(!gel_context_error(context))
+    {
+        g_value_init(return_value, GEL_TYPE_STRING_BUILDER);
+        g_value_take_boxed(return_value, builder);
+    }
+    else
+        gel_string_builder_unref(builder);
+}
+
+
+static
+void typed_array(GClosure *self, GValue *return_value,
+                 guint n_values, const GValue *values,
+                 GelContext *context, GelTypedArrayKind kind, const gchar *f)
+{
+    GValue *args = g_new0(GValue, n_values);
+    guint n_elements = 0;
+    guint i;
+
+    /* numbers are taken as they are, arrays are flattened */
+    for(i = 0; i < n_values; i++)
+    {
+        gel_context_eval_value(context, values + i, args + i);
+        if(gel_context_error(context))
+            break;
+
+        if(G_VALUE_HOLDS(args + i, GEL_TYPE_ARRAY))
+            n_elements += gel_array_get_n_values(g_value_get_boxed(args + i));
+        else
+        if(G_VALUE_HOLDS(args + i, GEL_TYPE_TYPED_ARRAY))
+            n_elements +=
+                gel_typed_array_get_n_elements(g_value_get_boxed(args + i));
+        else
+            n_elements++;
+    }
+
+    GelTypedArray *array = NULL;
+    if(i == n_values)
+    {
+        array = gel_typed_array_new(kind, n_elements);
+        guint index = 0;
+
+        for(i = 0; i < n_values && array != NULL; i++)
+        {
+            const GValue *arg = args + i;
+            gboolean valid = TRUE;
+
+            if(G_VALUE_HOLDS(arg, GEL_TYPE_ARRAY))
+            {
+                const GelArray *source = g_value_get_boxed(arg);
+                const GValue *source_values = gel_array_get_values(source);
+                const guint n = gel_array_get_n_values(source);
+
+                for(guint j = 0; j < n && valid; j++)
+                    valid = gel_typed_array_set(array,
+                        index++, source_values + j);
+            }
+            else
+            if(G_VALUE_HOLDS(arg, GEL_TYPE_TYPED_ARRAY))
+            {
+                const GelTypedArray *source = g_value_get_boxed(arg);
+                const guint n = gel_typed_array_get_n_elements(source);
+
+                for(guint j = 0; j < n && valid; j++)
+                {
+                    GValue element = {0};
+                    gel_typed_array_get(source, j, &element);
+                    valid = gel_typed_array_set(array, index++, &element);
+                    g_value_unset(&element);
+                }
+            }
+            else
+                valid = gel_typed_array_set(array, index++, arg);
+
+            if(!valid)
+            {
+                typed_array_error_element(array, context, f);
+                gel_typed_array_unref(array);
+                array = NULL;
+            }
+        }
+    }
+
+    if(array != NULL)
+    {
+        g_value_init(return_value, GEL_TYPE_TYPED_ARRAY);
+        g_value_take_boxed(return_value, array);
+    }
+
+    for(i = 0; i < n_values; i++)
+        if(G_IS_VALUE(args + i))
+            g_value_unset(args + i);
+    g_free(args);
+}
+
+
+static
+void byte_array_(GClosure *self, GValue *return_value,
+                 guint n_values, const GValue *values, GelContext *context)
+{
+    typed_array(self, return_value, n_values, values,
+        context, GEL_TYPED_ARRAY_BYTE, __FUNCTION__);
+}
+
+
+static
+void int64_array_(GClosure *self, GValue *return_value,
+                  guint n_values, const GValue *values, GelContext *context)
+{
+    typed_array(self, return_value, n_values, values,
+        context, GEL_TYPED_ARRAY_INT64, __FUNCTION__);
+}
+
 
-    gel_list_free(tmp_list);
+static
+void double_array_(GClosure *self, GValue *return_value,
+                   guint n_values, const GValue *values, GelContext *context)
+{
+    typed_array(self, return_value, n_values, values,
+        context, GEL_TYPED_ARRAY_DOUBLE, __FUNCTION__);
 }
 
 
@@ -878,17 +1775,18 @@ void var_(GClosure *self, GValue *return_value,
     if(G_VALUE_HOLDS(values, GEL_TYPE_SYMBOL))
     {
         GelSymbol *symbol = g_value_get_boxed(values);
-        GelVariable *variable = gel_symbol_get_variable(symbol);
+        const gchar *name = gel_symbol_get_name(symbol);
+        GelVariable *variable = gel_context_lookup_interned(context, name);
+        if(variable == NULL)
+            variable = gel_symbol_get_variable(symbol);
+
         if(variable != NULL)
         {
             g_value_init(return_value, GEL_TYPE_VARIABLE);
             g_value_set_boxed(return_value, variable);
         }
         else
-        {
-            const gchar *name = gel_symbol_get_name(symbol);
             gel_error_unknown_symbol(context, __FUNCTION__, name);
-        }
     }
     else
         gel_error_value_not_of_type(context,
@@ -913,12 +1811,12 @@ void set_(GClosure *self, GValue *return_value,
         return;
     }
 
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     GValue *value = NULL;
 
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "V*", &value))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "V*", &value))
     {
         GType type = G_VALUE_TYPE(value);
         if(type == GEL_TYPE_ARRAY)
@@ -927,12 +1825,30 @@ void set_(GClosure *self, GValue *return_value,
             array_set(array, return_value, n_values, values, context);
         }
         else
-        if(type == G_TYPE_HASH_TABLE)
+        if(type == GEL_TYPE_TYPED_ARRAY)
+        {
+            GelTypedArray *array = g_value_get_boxed(value);
+            typed_array_set(array, return_value, n_values, values, context);
+        }
+        else
+        if(type == GEL_TYPE_HASH)
         {
-            GHashTable *hash = g_value_get_boxed(value);
+            GelHash *hash = g_value_get_boxed(value);
             hash_set(hash, return_value, n_values, values, context);
         }
         else
+        if(type == GEL_TYPE_VECTOR)
+        {
+            GelVector *vector = g_value_get_boxed(value);
+            vector_set(vector, return_value, n_values, values, context);
+        }
+        else
+        if(type == GEL_TYPE_DICT)
+        {
+            GelDict *dict = g_value_get_boxed(value);
+            dict_set(dict, return_value, n_values, values, context);
+        }
+        else
         if(G_TYPE_IS_OBJECT(type))
         {
             GObject *object = g_value_get_object(value);
@@ -940,10 +1856,43 @@ void set_(GClosure *self, GValue *return_value,
         }
         else
             gel_error_expected(context,
-                __FUNCTION__, "array, hash or object");
+                __FUNCTION__, "array, hash, vector, dict or object");
     }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
+}
+
+
+/* Tells if @value makes a division or a modulo fail by being zero */
+static
+gboolean is_zero_divisor(const GValue *value)
+{
+    GelNumber number;
+
+    if(G_VALUE_HOLDS(value, GEL_TYPE_TYPED_ARRAY))
+    {
+        GelTypedArray *array = g_value_get_boxed(value);
+        return array != NULL && gel_typed_array_has_zero(array);
+    }
+
+    if(gel_value_get_number(value, &number))
+        return number.is_double ?
+            number.v.d > -1 && number.v.d < 1 : number.v.i == 0;
+
+    return FALSE;
+}
+
+
+static
+void arithmetic_error(GelContext *context, const gchar *f,
+                      GelNumbersArithmetic numbers_function,
+                      const GValue *v1, const GValue *v2)
+{
+    if((numbers_function == gel_numbers_div
+        || numbers_function == gel_numbers_mod) && is_zero_divisor(v2))
+        gel_error_division_by_zero(context, f);
+    else
+        gel_error_incompatible(context, f, v1, v2);
 }
 
 
@@ -951,7 +1900,8 @@ static
 void arithmetic(GClosure *self, GValue *return_value,
                 guint n_values, const GValue *values,
                 GelContext *context,
-                GelValuesArithmetic values_function, const gchar *f)
+                GelValuesArithmetic values_function,
+                GelNumbersArithmetic numbers_function, const gchar *f)
 {
     guint n_args = 2;
     if(n_values < n_args)
@@ -960,113 +1910,219 @@ void arithmetic(GClosure *self, GValue *return_value,
         return;
     }
 
-    GValue tmp1 = {0};
-    GValue tmp2 = {0};
-    GValue tmp3 = {0};
-    GValue *v2 = &tmp3;
-
-    gboolean running = FALSE;
+    /* the result stays in number until an operand is not a number */
+    GelNumber number;
+    GValue result = {0};
+    GValue tmp_value = {0};
 
-    const GValue *v0 =
-        gel_context_eval_into_value(context, values + 0, &tmp1);
+    const GValue *value =
+        gel_context_eval_into_value(context, values + 0, &tmp_value);
 
-    if(!gel_context_error(context))
+    if(gel_context_error(context))
     {
-        const GValue *v1 =
-            gel_context_eval_into_value(context, values + 1, &tmp2);
-
-        if(!gel_context_error(context))
-            running = values_function(v0, v1, &tmp3);
-
-        if(!running)
-            gel_error_incompatible(context, f, v0, v1);
+        if(G_IS_VALUE(&tmp_value))
+            g_value_unset(&tmp_value);
+        return;
     }
 
-    if(G_IS_VALUE(&tmp1))
-        g_value_unset(&tmp1);
-    if(G_IS_VALUE(&tmp2))
-        g_value_unset(&tmp2);
+    gboolean is_number = gel_value_get_number(value, &number);
+    if(!is_number)
+        gel_value_copy(value, &result);
+    if(G_IS_VALUE(&tmp_value))
+        g_value_unset(&tmp_value);
+
+    gboolean running = TRUE;
 
-    for(guint i = 2; i < n_values && running; i++)
+    for(guint i = 1; i < n_values && running; i++)
     {
-        GValue *v1;
-
-        if(i%2 == 0)
-            v1 = &tmp3, v2 = &tmp2;
-        else
-            v2 = &tmp3, v1 = &tmp2;
+        GelNumber operand;
 
-        const GValue *v =
-            gel_context_eval_into_value(context, values + i, &tmp1);
+        value = gel_context_eval_into_value(context, values + i, &tmp_value);
 
-        if(!gel_context_error(context))
+        if(gel_context_error(context))
+            running = FALSE;
+        else
+        if(is_number && gel_value_get_number(value, &operand))
         {
-            running = values_function(v1, v, v2);
+            running = numbers_function(&number, &operand);
             if(!running)
-                gel_error_incompatible(context, f, v1, v);
+            {
+                gel_value_set_number(&result, &number);
+                arithmetic_error(context, f, numbers_function, &result, value);
+            }
         }
+        else
+        {
+            if(is_number)
+            {
+                gel_value_set_number(&result, &number);
+                is_number = FALSE;
+            }
 
-        if(G_IS_VALUE(v1))
-            g_value_unset(v1);
-        if(G_IS_VALUE(&tmp1))
-            g_value_unset(&tmp1);
+            GValue next_result = {0};
+            running = values_function(&result, value, &next_result);
 
-        if(gel_context_error(context))
-        {
-            running = FALSE;
-            break;
+            if(running)
+            {
+                g_value_unset(&result);
+                result = next_result;
+            }
+            else
+            {
+                arithmetic_error(context, f, numbers_function, &result, value);
+                if(G_IS_VALUE(&next_result))
+                    g_value_unset(&next_result);
+            }
         }
+
+        if(G_IS_VALUE(&tmp_value))
+            g_value_unset(&tmp_value);
+    }
+
+    if(running)
+    {
+        if(is_number)
+            gel_value_set_number(return_value, &number);
+        else
+            gel_value_copy(&result, return_value);
+    }
+
+    if(G_IS_VALUE(&result))
+        g_value_unset(&result);
+}
+
+
+static
+void add_(GClosure *self, GValue *return_value,
+          guint n_values, const GValue *values, GelContext *context)
+{
+    arithmetic(self, return_value, n_values, values,
+        context, gel_values_add, gel_numbers_add, __FUNCTION__);
+}
+
+
+static
+void sub_(GClosure *self, GValue *return_value,
+          guint n_values, const GValue *values, GelContext *context)
+{
+    arithmetic(self, return_value, n_values, values,
+        context, gel_values_sub, gel_numbers_sub, __FUNCTION__);
+}
+
+
+static
+void mul_(GClosure *self, GValue *return_value,
+          guint n_values, const GValue *values, GelContext *context)
+{
+    arithmetic(self, return_value, n_values, values,
+        context, gel_values_mul, gel_numbers_mul, __FUNCTION__);
+}
+
+
+static
+void div_(GClosure *self, GValue *return_value,
+          guint n_values, const GValue *values, GelContext *context)
+{
+    arithmetic(self, return_value, n_values, values,
+        context, gel_values_div, gel_numbers_div, __FUNCTION__);
+}
+
+
+static
+void mod_(GClosure *self, GValue *return_value,
+          guint n_values, const GValue *values, GelContext *context)
+{
+    arithmetic(self, return_value, n_values, values,
+        context, gel_values_mod, gel_numbers_mod, __FUNCTION__);
+}
+
+
+static
+void reduction(GClosure *self, GValue *return_value,
+               guint n_values, const GValue *values,
+               GelContext *context,
+               gboolean (*reduce)(const GelTypedArray *, GValue *),
+               const gchar *f)
+{
+    guint n_args = 1;
+    if(n_values != n_args)
+    {
+        gel_error_needs_n_arguments(context, f, n_args);
+        return;
+    }
+
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
+    GValue *value = NULL;
+
+    if(gel_context_eval_params_tmp(context, f,
+            &n_values, &values, &tmp_params, "V", &value))
+    {
+        if(!G_VALUE_HOLDS(value, GEL_TYPE_TYPED_ARRAY))
+            gel_error_expected(context, f, "typed array");
+        else
+        if(!reduce(g_value_get_boxed(value), return_value))
+            gel_error_expected(context, f, "non empty typed array");
     }
 
-    if(running)
-        gel_value_copy(v2, return_value);
-    if(G_IS_VALUE(v2))
-        g_value_unset(v2);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
 static
-void add_(GClosure *self, GValue *return_value,
+void sum_(GClosure *self, GValue *return_value,
           guint n_values, const GValue *values, GelContext *context)
 {
-    arithmetic(self, return_value, n_values, values,
-        context, gel_values_add, __FUNCTION__);
+    reduction(self, return_value, n_values, values,
+        context, gel_typed_array_sum, __FUNCTION__);
 }
 
 
 static
-void sub_(GClosure *self, GValue *return_value,
+void min_(GClosure *self, GValue *return_value,
           guint n_values, const GValue *values, GelContext *context)
 {
-    arithmetic(self, return_value, n_values, values,
-        context, gel_values_sub, __FUNCTION__);
+    reduction(self, return_value, n_values, values,
+        context, gel_typed_array_min, __FUNCTION__);
 }
 
 
 static
-void mul_(GClosure *self, GValue *return_value,
+void max_(GClosure *self, GValue *return_value,
           guint n_values, const GValue *values, GelContext *context)
 {
-    arithmetic(self, return_value, n_values, values,
-        context, gel_values_mul, __FUNCTION__);
+    reduction(self, return_value, n_values, values,
+        context, gel_typed_array_max, __FUNCTION__);
 }
 
 
 static
-void div_(GClosure *self, GValue *return_value,
-          guint n_values, const GValue *values, GelContext *context)
+void dot_product_(GClosure *self, GValue *return_value,
+                  guint n_values, const GValue *values, GelContext *context)
 {
-    arithmetic(self, return_value, n_values, values,
-        context, gel_values_div, __FUNCTION__);
-}
+    guint n_args = 2;
+    if(n_values != n_args)
+    {
+        gel_error_needs_n_arguments(context, __FUNCTION__, n_args);
+        return;
+    }
 
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
+    GValue *v1 = NULL;
+    GValue *v2 = NULL;
 
-static
-void mod_(GClosure *self, GValue *return_value,
-          guint n_values, const GValue *values, GelContext *context)
-{
-    arithmetic(self, return_value, n_values, values,
-        context, gel_values_mod, __FUNCTION__);
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "VV", &v1, &v2))
+    {
+        if(!G_VALUE_HOLDS(v1, GEL_TYPE_TYPED_ARRAY)
+           || !G_VALUE_HOLDS(v2, GEL_TYPE_TYPED_ARRAY))
+            gel_error_expected(context, __FUNCTION__, "typed arrays");
+        else
+        if(!gel_typed_arrays_dot(g_value_get_boxed(v1),
+                g_value_get_boxed(v2), return_value))
+            gel_error_incompatible(context, __FUNCTION__, v1, v2);
+    }
+
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -1074,7 +2130,9 @@ static
 void logic(GClosure *self, GValue *return_value,
            guint n_values, const GValue *values,
            GelContext *context,
-           GelValuesLogic values_function, const gchar *f)
+           GelValuesLogic values_function,
+           GelNumbersLogic numbers_function,
+           GelValuesArithmetic mask_function, const gchar *f)
 {
     guint n_args = 2;
     if(n_values < n_args)
@@ -1086,6 +2144,7 @@ void logic(GClosure *self, GValue *return_value,
     gint result = -1;
     guint last = n_values - 1;
     gboolean failed = FALSE;
+    gboolean masked = FALSE;
 
     for(guint i = 0; i < last && result != 1 && !failed; i++)
     {
@@ -1100,7 +2159,30 @@ void logic(GClosure *self, GValue *return_value,
             const GValue *v2 =
                 gel_context_eval_into_value(context, j+1, &tmp2);
 
-            if(!gel_context_error(context))
+            GelNumber n1;
+            GelNumber n2;
+
+            if(gel_context_error(context))
+                failed = TRUE;
+            else
+            if(gel_value_get_number(v1, &n1) && gel_value_get_number(v2, &n2))
+                result = numbers_function(&n1, &n2) ? 1 : 0;
+            else
+            if(G_VALUE_HOLDS(v1, GEL_TYPE_TYPED_ARRAY)
+               || G_VALUE_HOLDS(v2, GEL_TYPE_TYPED_ARRAY))
+            {
+                /* typed arrays are compared element-wise into a mask */
+                if(n_values == 2 && mask_function(v1, v2, return_value))
+                    masked = TRUE;
+                else
+                {
+                    if(G_IS_VALUE(return_value))
+                        g_value_unset(return_value);
+                    gel_error_incompatible(context, f, v1, v2);
+                    failed = TRUE;
+                }
+            }
+            else
             {
                 result = values_function(v1, v2);
                 if(result == -1)
@@ -1109,8 +2191,6 @@ void logic(GClosure *self, GValue *return_value,
                     failed = TRUE;
                 }
             }
-            else
-                failed = TRUE;
         }
         else
             failed = TRUE;
@@ -1121,7 +2201,7 @@ void logic(GClosure *self, GValue *return_value,
             g_value_unset(&tmp2);
     }
 
-    if(!failed)
+    if(!failed && !masked)
     {
         g_value_init(return_value, G_TYPE_BOOLEAN);
         g_value_set_boolean(return_value, result == 1 ? TRUE : FALSE);
@@ -1208,7 +2288,8 @@ void gt_(GClosure *self, GValue *return_value,
          guint n_values, const GValue *values, GelContext *context)
 {
     logic(self, return_value, n_values, values,
-        context, gel_values_gt, __FUNCTION__);
+        context, gel_values_gt, gel_numbers_gt,
+        gel_typed_arrays_gt, __FUNCTION__);
 }
 
 
@@ -1217,7 +2298,8 @@ void ge_(GClosure *self, GValue *return_value,
          guint n_values, const GValue *values, GelContext *context)
 {
     logic(self, return_value, n_values, values,
-        context, gel_values_ge, __FUNCTION__);
+        context, gel_values_ge, gel_numbers_ge,
+        gel_typed_arrays_ge, __FUNCTION__);
 }
 
 
@@ -1226,7 +2308,8 @@ void eq_(GClosure *self, GValue *return_value,
          guint n_values, const GValue *values, GelContext *context)
 {
     logic(self, return_value, n_values, values,
-        context, gel_values_eq, __FUNCTION__);
+        context, gel_values_eq, gel_numbers_eq,
+        gel_typed_arrays_eq, __FUNCTION__);
 }
 
 
@@ -1234,8 +2317,9 @@ static
 void le_(GClosure *self, GValue *return_value,
          guint n_values, const GValue *values, GelContext *context)
 {
-    logic(self, return_value, n_values, values, context,
-        gel_values_le, __FUNCTION__);
+    logic(self, return_value, n_values, values,
+        context, gel_values_le, gel_numbers_le,
+        gel_typed_arrays_le, __FUNCTION__);
 }
 
 
@@ -1244,7 +2328,8 @@ void lt_(GClosure *self, GValue *return_value,
          guint n_values, const GValue *values, GelContext *context)
 {
     logic(self, return_value, n_values, values,
-        context, gel_values_lt, __FUNCTION__);
+        context, gel_values_lt, gel_numbers_lt,
+        gel_typed_arrays_lt, __FUNCTION__);
 }
 
 
@@ -1253,7 +2338,8 @@ void ne_(GClosure *self, GValue *return_value,
          guint n_values, const GValue *values, GelContext *context)
 {
     logic(self, return_value, n_values, values,
-        context, gel_values_ne, __FUNCTION__);
+        context, gel_values_ne, gel_numbers_ne,
+        gel_typed_arrays_ne, __FUNCTION__);
 }
 
 
@@ -1268,11 +2354,11 @@ void append_(GClosure *self, GValue *return_value,
         return;
     }
 
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     GValue *value = NULL;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "V*", &value))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "V*", &value))
     {
         GType type = G_VALUE_TYPE(value);
         if(type == GEL_TYPE_ARRAY)
@@ -1281,16 +2367,35 @@ void append_(GClosure *self, GValue *return_value,
             array_append(array, return_value, n_values, values, context);
         }
         else
-        if(type == G_TYPE_HASH_TABLE)
+        if(type == GEL_TYPE_HASH)
         {
-            GHashTable *hash = g_value_get_boxed(value);
+            GelHash *hash = g_value_get_boxed(value);
             hash_append(hash, return_value, n_values, values, context);
         }
         else
-            gel_error_expected(context, __FUNCTION__, "array or hash");
+        if(type == GEL_TYPE_VECTOR)
+        {
+            GelVector *vector = g_value_get_boxed(value);
+            vector_append(vector, return_value, n_values, values, context);
+        }
+        else
+        if(type == GEL_TYPE_DICT)
+        {
+            GelDict *dict = g_value_get_boxed(value);
+            dict_append(dict, return_value, n_values, values, context);
+        }
+        else
+        if(type == GEL_TYPE_STRING_BUILDER)
+        {
+            GelStringBuilder *builder = g_value_get_boxed(value);
+            string_builder_append(builder,
+                return_value, n_values, values, context);
+        }
+        else
+            gel_error_expected(context, __FUNCTION__, "array, hash, vector, dict or string-builder");
     }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -1305,11 +2410,11 @@ void get_(GClosure *self, GValue *return_value,
         return;
     }
 
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     GValue *value = NULL;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "V*", &value))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "V*", &value))
     {
         GType type = G_VALUE_TYPE(value);
         if(type == GEL_TYPE_ARRAY)
@@ -1318,12 +2423,30 @@ void get_(GClosure *self, GValue *return_value,
             array_get(array, return_value, n_values, values, context);
         }
         else
-        if(type == G_TYPE_HASH_TABLE)
+        if(type == GEL_TYPE_TYPED_ARRAY)
         {
-            GHashTable *hash = g_value_get_boxed(value);
+            GelTypedArray *array = g_value_get_boxed(value);
+            typed_array_get(array, return_value, n_values, values, context);
+        }
+        else
+        if(type == GEL_TYPE_HASH)
+        {
+            GelHash *hash = g_value_get_boxed(value);
             hash_get(hash, return_value, n_values, values, context);
         }
         else
+        if(type == GEL_TYPE_VECTOR)
+        {
+            GelVector *vector = g_value_get_boxed(value);
+            vector_get(vector, return_value, n_values, values, context);
+        }
+        else
+        if(type == GEL_TYPE_DICT)
+        {
+            GelDict *dict = g_value_get_boxed(value);
+            dict_get(dict, return_value, n_values, values, context);
+        }
+        else
         if(G_TYPE_IS_OBJECT(type))
         {
             GObject *object = g_value_get_object(value);
@@ -1331,10 +2454,10 @@ void get_(GClosure *self, GValue *return_value,
         }
         else
             gel_error_expected(context,
-                __FUNCTION__, "array, hash or object");
+                __FUNCTION__, "array, hash, vector, dict or object");
     }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -1349,11 +2472,11 @@ void remove_(GClosure *self, GValue *return_value,
         return;
     }
 
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     GValue *value = NULL;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "V*", &value))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "V*", &value))
     {
         GType type = G_VALUE_TYPE(value);
         if(type == GEL_TYPE_ARRAY)
@@ -1362,16 +2485,22 @@ void remove_(GClosure *self, GValue *return_value,
             array_remove(array, return_value, n_values, values, context);
         }
         else
-        if(type == G_TYPE_HASH_TABLE)
+        if(type == GEL_TYPE_HASH)
         {
-            GHashTable *hash = g_value_get_boxed(value);
+            GelHash *hash = g_value_get_boxed(value);
             hash_remove(hash, return_value, n_values, values, context);
         }
         else
-            gel_error_expected(context, __FUNCTION__, "array or hash");
+        if(type == GEL_TYPE_DICT)
+        {
+            GelDict *dict = g_value_get_boxed(value);
+            dict_remove(dict, return_value, n_values, values, context);
+        }
+        else
+            gel_error_expected(context, __FUNCTION__, "array, hash or dict");
     }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -1386,11 +2515,11 @@ void size_(GClosure *self, GValue *return_value,
         return;
     }
 
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     GValue *value = NULL;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "V*", &value))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "V*", &value))
     {
         GType type = G_VALUE_TYPE(value);
         if(type == GEL_TYPE_ARRAY)
@@ -1399,16 +2528,63 @@ void size_(GClosure *self, GValue *return_value,
             array_size(array, return_value, n_values, values, context);
         }
         else
-        if(type == G_TYPE_HASH_TABLE)
+        if(type == GEL_TYPE_TYPED_ARRAY)
+        {
+            GelTypedArray *array = g_value_get_boxed(value);
+            g_value_init(return_value, G_TYPE_INT64);
+            g_value_set_int64(return_value,
+                gel_typed_array_get_n_elements(array));
+        }
+        else
+        if(type == GEL_TYPE_HASH)
         {
-            GHashTable *hash = g_value_get_boxed(value);
+            GelHash *hash = g_value_get_boxed(value);
             hash_size(hash, return_value, n_values, values, context);
         }
+        else
+        if(type == GEL_TYPE_VECTOR)
+        {
+            GelVector *vector = g_value_get_boxed(value);
+            g_value_init(return_value, G_TYPE_INT64);
+            g_value_set_int64(return_value, gel_vector_get_size(vector));
+        }
+        else
+        if(type == GEL_TYPE_DICT)
+        {
+            GelDict *dict = g_value_get_boxed(value);
+            g_value_init(return_value, G_TYPE_INT64);
+            g_value_set_int64(return_value, gel_dict_get_size(dict));
+        }
+        else
+        if(type == GEL_TYPE_STRING_BUILDER)
+        {
+            GelStringBuilder *builder = g_value_get_boxed(value);
+            g_value_init(return_value, G_TYPE_INT64);
+            g_value_set_int64(return_value,
+                gel_string_builder_get_length(builder));
+        }
+        else
+        if(type == GEL_TYPE_ITERATOR)
+        {
+            GelIteratorCursor *cursor = gel_iterator_cursor_new(value);
+            GValue element = {0};
+            gint64 size = 0;
+
+            for(; gel_iterator_cursor_next(cursor, &element, context); size++)
+                g_value_unset(&element);
+            gel_iterator_cursor_free(cursor);
+
+            if(!gel_context_error(context))
+            {
+                g_value_init(return_value, G_TYPE_INT64);
+                g_value_set_int64(return_value, size);
+            }
+        }
         else
             gel_error_expected(context, __FUNCTION__, "array or hash");
     }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -1424,30 +2600,41 @@ void find_(GClosure *self, GValue *return_value,
         return;
     }
 
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     GClosure *closure = NULL;
-    GValue *value = NULL;
+    const GValue *form = NULL;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "CV", &closure, &value))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "Cv", &closure, &form))
     {
-        GType type = G_VALUE_TYPE(value);
+        GValue tmp_value = {0};
+        const GValue *value = eval_iterable(context, form, &tmp_value);
+        GType type = gel_context_error(context) ?
+            G_TYPE_INVALID : G_VALUE_TYPE(value);
+
         if(type == GEL_TYPE_ARRAY)
         {
             GelArray *array = g_value_get_boxed(value);
             array_find(closure, array, return_value, n_values, values, context);
         }
         else
-        if(type == G_TYPE_HASH_TABLE)
+        if(type == GEL_TYPE_HASH)
         {
-            GHashTable *hash = g_value_get_boxed(value);
+            GelHash *hash = g_value_get_boxed(value);
             hash_find(closure, hash, return_value, n_values, values, context);
         }
         else
+        if(type == GEL_TYPE_ITERATOR)
+            iterator_find(closure, value, return_value, context);
+        else
+        if(type != G_TYPE_INVALID)
             gel_error_expected(context, __FUNCTION__, "array or hash");
+
+        if(G_IS_VALUE(&tmp_value))
+            g_value_unset(&tmp_value);
     }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -1462,12 +2649,12 @@ void filter_(GClosure *self, GValue *return_value,
         return;
     }
 
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     GClosure *closure = NULL;
     GValue *value = NULL;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "CV", &closure, &value))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "CV", &closure, &value))
     {
         GType type = G_VALUE_TYPE(value);
         if(type == GEL_TYPE_ARRAY)
@@ -1477,16 +2664,32 @@ void filter_(GClosure *self, GValue *return_value,
                 array, return_value, n_values, values, context);
         }
         else
-        if(type == G_TYPE_HASH_TABLE)
+        if(type == GEL_TYPE_HASH)
         {
-            GHashTable *hash = g_value_get_boxed(value);
+            GelHash *hash = g_value_get_boxed(value);
             hash_filter(closure, hash, return_value, n_values, values, context);
         }
+        else
+        if(type == GEL_TYPE_VECTOR)
+        {
+            GelArray *array = gel_iterator_collect(value, context);
+            array_filter(closure,
+                array, return_value, n_values, values, context);
+            gel_array_free(array);
+        }
+        else
+        if(type == GEL_TYPE_ITERATOR)
+        {
+            /* like map, filtering an iterator is lazy */
+            g_value_init(return_value, GEL_TYPE_ITERATOR);
+            g_value_take_boxed(return_value,
+                gel_iterator_new_filter(closure, value));
+        }
         else
             gel_error_expected(context, __FUNCTION__, "array or hash");
     }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -1495,18 +2698,48 @@ static
 void compare_(GClosure *self, GValue *return_value,
               guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     GValue *v1 = NULL;
     GValue *v2 = NULL;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "VV", &v1, &v2))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "VV", &v1, &v2))
     {
         g_value_init(return_value, G_TYPE_INT64);
         g_value_set_int64(return_value, gel_values_cmp(v1, v2));
     }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
+}
+
+
+/*
+ * Without a closure the values are sorted with gel_values_cmp. A closure
+ * receives two values and returns TRUE if the first one goes before the
+ * second one; it is called once per step with the values of the array, and
+ * like the closures of pmap it must not change the variables it shares.
+ */
+static
+gint sort_compare(const GValue *v1, const GValue *v2,
+                  GelContext *context, GClosure *closure)
+{
+    if(closure == NULL)
+        return gel_values_cmp(v1, v2);
+
+    if(gel_context_error(context))
+        return 0;
+
+    /* the closure copies its arguments, so they can share their data */
+    GValue args[2] = {*v2, *v1};
+    GValue tmp_value = {0};
+    g_closure_invoke(closure, &tmp_value, 2, args, context);
+
+    gint result = gel_value_to_boolean(&tmp_value) ? 1 : 0;
+
+    if(G_IS_VALUE(&tmp_value))
+        g_value_unset(&tmp_value);
+
+    return result;
 }
 
 
@@ -1514,41 +2747,122 @@ static
 void sort_(GClosure *self, GValue *return_value,
            guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     GClosure *closure = NULL;
     GelArray *array = NULL;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "CA", &closure, &array))
+    if(n_values == 1
+        ? gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "A", &array)
+        : gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "CA", &closure, &array))
     {
-        gint compare(GValue *v1, GValue *v2)
+        GelArray *result_array = gel_array_copy(array);
+
+        if(gel_parallel_sort(context,
+                gel_array_get_values(result_array),
+                gel_array_get_n_values(result_array), sizeof(GValue),
+                (GelParallelCompareFunc)sort_compare, closure))
         {
-            GelArray *pair = gel_array_new(2);
-            gel_array_append(pair, v1);
-            gel_array_append(pair, v2);
+            g_value_init(return_value, GEL_TYPE_ARRAY);
+            g_value_take_boxed(return_value, result_array);
+        }
+        else
+            gel_array_free(result_array);
+    }
 
-            GValue tmp_value = {0};
-            g_closure_invoke(closure, &tmp_value, 2,
-                gel_array_get_values(pair),
-                context);
+    gel_params_tmp_clear(&tmp_params);
+}
 
-            gboolean result = gel_value_to_boolean(&tmp_value) ? -1 : 1;
 
-            if(G_IS_VALUE(&tmp_value))
-                g_value_unset(&tmp_value);
-            gel_array_free(pair);
+typedef struct _GelSortKey GelSortKey;
 
-            return result;
-        }
+struct _GelSortKey
+{
+    GValue key;
+    guint index;
+};
 
-        GelArray *result_array = gel_array_copy(array);
-        gel_array_sort(result_array, (GCompareFunc)compare);
+typedef struct _GelSortBy GelSortBy;
 
-        g_value_init(return_value, GEL_TYPE_ARRAY);
-        g_value_take_boxed(return_value, result_array);
+struct _GelSortBy
+{
+    GClosure *closure;
+    GelArray *array;
+    GelSortKey *keys;
+};
+
+
+static
+void sort_by_keys(GelContext *context, guint start, guint end,
+                  GelSortBy *sort_by)
+{
+    const GValue *array_values = gel_array_get_values(sort_by->array);
+    GelSortKey *keys = sort_by->keys;
+
+    for(guint i = start; i < end && !gel_context_error(context); i++)
+    {
+        keys[i].index = i;
+        g_closure_invoke(sort_by->closure, &keys[i].key,
+            1, array_values + i, context);
+
+        if(!G_IS_VALUE(&keys[i].key) && !gel_context_error(context))
+            gel_error_expected(context, "sort_by_", "a key");
+    }
+}
+
+
+static
+gint sort_by_compare(const GelSortKey *k1, const GelSortKey *k2,
+                     GelContext *context, gpointer user_data)
+{
+    return gel_values_cmp(&k1->key, &k2->key);
+}
+
+
+/*
+ * The key of each value is computed once, in parallel like pmap,
+ * and then the values are sorted by their keys.
+ */
+static
+void sort_by_(GClosure *self, GValue *return_value,
+              guint n_values, const GValue *values, GelContext *context)
+{
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
+    GClosure *closure = NULL;
+    GelArray *array = NULL;
+
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "CA", &closure, &array))
+    {
+        guint array_n_values = gel_array_get_n_values(array);
+        GelSortKey *keys = g_new0(GelSortKey, array_n_values);
+        GelSortBy sort_by = {closure, array, keys};
+
+        if(gel_parallel_run(context, array_n_values,
+                (GelParallelFunc)sort_by_keys, &sort_by)
+           && gel_parallel_sort(context, keys, array_n_values,
+                sizeof(GelSortKey),
+                (GelParallelCompareFunc)sort_by_compare, NULL))
+        {
+            const GValue *array_values = gel_array_get_values(array);
+            GelArray *result_array = gel_array_new(array_n_values);
+
+            for(guint i = 0; i < array_n_values; i++)
+                gel_array_append(result_array,
+                    array_values + keys[i].index);
+
+            g_value_init(return_value, GEL_TYPE_ARRAY);
+            g_value_take_boxed(return_value, result_array);
+        }
+
+        for(guint i = 0; i < array_n_values; i++)
+            if(G_IS_VALUE(&keys[i].key))
+                g_value_unset(&keys[i].key);
+        g_free(keys);
     }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -1556,11 +2870,11 @@ static
 void reverse_(GClosure *self, GValue *return_value,
               guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     GelArray *array = NULL;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "A", &array))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "A", &array))
     {
         guint array_n_values = gel_array_get_n_values(array);
         const GValue *array_values = gel_array_get_values(array);
@@ -1580,25 +2894,26 @@ static
 void keys_(GClosure *self, GValue *return_value,
            guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
-    GHashTable *hash = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
+    GelHash *hash = NULL;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "H", &hash))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "H", &hash))
     {
-        guint size = g_hash_table_size(hash);
+        guint size = gel_hash_get_size(hash);
         GelArray *array = gel_array_new(size);
-        GList *keys = g_hash_table_get_keys(hash);
+        GelHashIter iter;
+        const GValue *key = NULL;
 
-        for(GList *iter = keys; iter != NULL; iter = g_list_next(iter))
-            gel_array_append(array, iter->data);
+        gel_hash_iter_init(&iter, hash);
+        while(gel_hash_iter_next(&iter, &key, NULL))
+            gel_array_append(array, key);
 
         g_value_init(return_value, GEL_TYPE_ARRAY);
         g_value_take_boxed(return_value, array);
-        g_list_free(keys);
     }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -1677,10 +2992,11 @@ void connect_(GClosure *self, GValue *return_value,
     GObject *object = NULL;
     gchar *signal = NULL;
     GClosure *callback = NULL;
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "OSC", &object, &signal, &callback))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "OSC",
+            &object, &signal, &callback))
     {
         if(G_IS_OBJECT(object))
         {
@@ -1695,7 +3011,7 @@ void connect_(GClosure *self, GValue *return_value,
                 __FUNCTION__, values + 0, G_TYPE_OBJECT);
     }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -1737,7 +3053,7 @@ void cond_(GClosure *self, GValue *return_value,
         return;
     }
 
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
 
     while(n_values > 0 && !gel_context_error(context))
         if(n_values == 1)
@@ -1746,8 +3062,9 @@ void cond_(GClosure *self, GValue *return_value,
         {
             GValue *test_value = NULL;
             GValue *value = NULL;
-            if(gel_context_eval_params(context, __FUNCTION__,
-                    &n_values, &values, &tmp_list, "Vv*", &test_value, &value))
+            if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                    &n_values, &values, &tmp_params, "Vv*",
+                    &test_value, &value))
                 if(gel_value_to_boolean(test_value))
                 {
                     do_(self, return_value, 1, value, context);
@@ -1755,7 +3072,7 @@ void cond_(GClosure *self, GValue *return_value,
                 }
         }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -1770,11 +3087,11 @@ void case_(GClosure *self, GValue *return_value,
         return;
     }
 
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     GValue *probe_value = NULL;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "V*", &probe_value))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "V*", &probe_value))
         while(n_values > 0 && !gel_context_error(context))
             if(n_values == 1)
                 do_(self, return_value, n_values--, values++, context);
@@ -1782,8 +3099,8 @@ void case_(GClosure *self, GValue *return_value,
             {
                 GelArray *tests = NULL;
                 GValue *value = NULL;
-                if(gel_context_eval_params(context, __FUNCTION__,
-                    &n_values, &values, &tmp_list, "av*", &tests, &value))
+                if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                    &n_values, &values, &tmp_params, "av*", &tests, &value))
                 {
                     const GValue *test_values =
                         gel_array_get_values(tests);
@@ -1804,7 +3121,7 @@ void case_(GClosure *self, GValue *return_value,
                 }
             }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -1856,14 +3173,26 @@ void for_(GClosure *self, GValue *return_value,
           guint n_values, const GValue *values, GelContext *context)
 {
     const gchar *iter_name;
-    GelArray *array;
-    GList *tmp_list = NULL;
+    const GValue *form;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values,&tmp_list, "sA*", &iter_name, &array))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values,&tmp_params, "sv*", &iter_name, &form))
     {
-        guint last = gel_array_get_n_values(array);
-        const GValue *array_values = gel_array_get_values(array);
+        GValue tmp_value = {0};
+        const GValue *iterable = eval_iterable(context, form, &tmp_value);
+        GelIteratorCursor *cursor = gel_context_error(context) ?
+            NULL : gel_iterator_cursor_new(iterable);
+        if(cursor == NULL)
+        {
+            if(!gel_context_error(context))
+                gel_error_value_not_of_type(context,
+                    __FUNCTION__, iterable, GEL_TYPE_ARRAY);
+            if(G_IS_VALUE(&tmp_value))
+                g_value_unset(&tmp_value);
+            gel_params_tmp_clear(&tmp_params);
+            return;
+        }
 
         GelContext *loop_context = gel_context_new_with_outer(context);
         GValue *iter_value = gel_value_new();
@@ -1871,9 +3200,9 @@ void for_(GClosure *self, GValue *return_value,
 
         gboolean running = TRUE;
 
-        for(guint i = 0; i < last && running; i++)
+        while(running
+              && gel_iterator_cursor_next(cursor, iter_value, loop_context))
         {
-            gel_value_copy(array_values + i, iter_value);
             GValue tmp_value = {0};
             do_(self, &tmp_value, n_values, values, loop_context);
 
@@ -1886,9 +3215,12 @@ void for_(GClosure *self, GValue *return_value,
         }
 
         gel_context_free(loop_context);
+        gel_iterator_cursor_free(cursor);
+        if(G_IS_VALUE(&tmp_value))
+            g_value_unset(&tmp_value);
     }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -1896,12 +3228,12 @@ static
 void range_(GClosure *self, GValue *return_value,
             guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     gint64 first = 0;
     gint64 last = 0;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "II", &first, &last))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "II", &first, &last))
     {
         GelArray *array = gel_array_new(ABS(last-first) + 1);
         GValue value = {0};
@@ -1925,7 +3257,83 @@ void range_(GClosure *self, GValue *return_value,
         g_value_take_boxed(return_value, array);
     }
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
+}
+
+
+/*
+ * (iter first last) is a lazy range, whose values are made while iterating
+ * it, so unlike range it does not build an array. (iter x) is a lazy view
+ * of an iterable, or a generator if x is a closure.
+ */
+static
+void iter_(GClosure *self, GValue *return_value,
+           guint n_values, const GValue *values, GelContext *context)
+{
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
+    GValue *value = NULL;
+    gint64 first = 0;
+    gint64 last = 0;
+
+    if(n_values == 2)
+    {
+        if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                &n_values, &values, &tmp_params, "II", &first, &last))
+        {
+            g_value_init(return_value, GEL_TYPE_ITERATOR);
+            g_value_take_boxed(return_value,
+                gel_iterator_new_range(first, last));
+        }
+    }
+    else
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "V", &value))
+    {
+        GelIterator *iterator = NULL;
+
+        if(G_VALUE_HOLDS(value, G_TYPE_CLOSURE))
+            iterator = gel_iterator_new_generator(g_value_get_boxed(value));
+        else
+        if(gel_value_is_iterable(value))
+            iterator = gel_iterator_new_view(value);
+        else
+            gel_error_expected(context,
+                __FUNCTION__, "array, hash, iterator or closure");
+
+        if(iterator != NULL)
+        {
+            g_value_init(return_value, GEL_TYPE_ITERATOR);
+            g_value_take_boxed(return_value, iterator);
+        }
+    }
+
+    gel_params_tmp_clear(&tmp_params);
+}
+
+
+static
+void collect_(GClosure *self, GValue *return_value,
+              guint n_values, const GValue *values, GelContext *context)
+{
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
+    GValue *value = NULL;
+
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "V", &value))
+    {
+        GelArray *array = gel_iterator_collect(value, context);
+        if(array != NULL)
+        {
+            g_value_init(return_value, GEL_TYPE_ARRAY);
+            g_value_take_boxed(return_value, array);
+        }
+        else
+        if(!gel_context_error(context))
+            gel_error_expected(context,
+                __FUNCTION__, "array, hash or iterator");
+    }
+
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -1933,32 +3341,33 @@ static
 void print_(GClosure *self, GValue *return_value,
             guint n_values, const GValue *values, GelContext *context)
 {
-    if(n_values > 0)
+    GelWriter writer;
+    gel_writer_init_print(&writer);
+
+    for(guint i = 0; i < n_values; i++)
     {
-        guint last = n_values - 1;
-        for(guint i = 0; i <= last; i++)
-        {
-            GValue tmp_value = {0};
-            const GValue *value =
-                gel_context_eval_into_value(context, values + i, &tmp_value);
+        GValue tmp_value = {0};
+        const GValue *value =
+            gel_context_eval_into_value(context, values + i, &tmp_value);
 
-            if(!gel_context_error(context))
+        if(!gel_context_error(context))
+        {
+            if(G_IS_VALUE(value))
             {
-                if(G_IS_VALUE(value))
-                {
-                    gchar *value_string = gel_value_to_string(value);
-                    g_print("%s%s", value_string, i == last ? "" : " ");
-                    g_free(value_string);
-                }
-
-                if(G_IS_VALUE(&tmp_value))
-                    g_value_unset(&tmp_value);
+                gel_writer_write_value(&writer, value, FALSE);
+                if(i < n_values - 1)
+                    gel_writer_write(&writer, " ", 1);
             }
-            else
-                break;
+
+            if(G_IS_VALUE(&tmp_value))
+                g_value_unset(&tmp_value);
         }
+        else
+            break;
     }
-    g_print("\n");
+
+    gel_writer_write(&writer, "\n", 1);
+    gel_writer_clear(&writer);
 }
 
 
@@ -1967,6 +3376,8 @@ void str_(GClosure *self, GValue *return_value,
           guint n_values, const GValue *values, GelContext *context)
 {
     GString *buffer = g_string_new("");
+    GelWriter writer;
+    gel_writer_init_buffer(&writer, buffer);
 
     for(guint i = 0; i < n_values; i++)
     {
@@ -1977,11 +3388,7 @@ void str_(GClosure *self, GValue *return_value,
         if(!gel_context_error(context))
         {
             if(G_IS_VALUE(value))
-            {
-                gchar *value_string = gel_value_to_string(value);
-                g_string_append_printf(buffer, "%s", value_string);
-                g_free(value_string);
-            }
+                gel_writer_write_value(&writer, value, FALSE);
 
             if(G_IS_VALUE(&tmp_value))
                 g_value_unset(&tmp_value);
@@ -1989,7 +3396,8 @@ void str_(GClosure *self, GValue *return_value,
         else
             break;
     }
- 
+
+    gel_writer_clear(&writer);
     g_value_init(return_value, G_TYPE_STRING);
     g_value_take_string(return_value, g_string_free(buffer, FALSE));
 }
@@ -1999,17 +3407,22 @@ static
 void type_(GClosure *self, GValue *return_value,
            guint n_values, const GValue *values, GelContext *context)
 {
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     GValue *value;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "V", &value))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "V", &value))
     {
+        /* ropes are strings to scripts, whatever their length */
+        GType type = G_VALUE_TYPE(value);
+        if(type == GEL_TYPE_ROPE)
+            type = G_TYPE_STRING;
+
         g_value_init(return_value, G_TYPE_GTYPE);
-        g_value_set_gtype(return_value, G_VALUE_TYPE(value));
+        g_value_set_gtype(return_value, type);
     }
 
-    g_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -2019,11 +3432,11 @@ void require_(GClosure *self, GValue *return_value,
               guint n_values, const GValue *values, GelContext *context)
 {
     const gchar *namespace_ = NULL;
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     GelTypelib *ns = NULL;
 
-    if(gel_context_eval_params(context, __FUNCTION__,
-            &n_values, &values, &tmp_list, "s", &namespace_))
+    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+            &n_values, &values, &tmp_params, "s", &namespace_))
     {
         if(gel_context_get_variable(context, namespace_) == NULL)
         {
@@ -2041,7 +3454,7 @@ void require_(GClosure *self, GValue *return_value,
     g_value_init(return_value, G_TYPE_BOOLEAN);
     g_value_set_boolean(return_value, ns != NULL);
 
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
 }
 
 
@@ -2182,26 +3595,38 @@ GHashTable* gel_make_default_symbols(void)
 
         /* closures */
         CLOSURE(apply),  /* array */
-        CLOSURE(map),  /* array */
+        CLOSURE(map),  /* array vector iterator */
+        CLOSURE(iter),  /* iterator */
+        CLOSURE(collect),  /* array */
+        CLOSURE(pmap),  /* array */
+        CLOSURE(pfilter),  /* array */
+        CLOSURE(preduce),  /* array */
 
         /* structures */
         CLOSURE(array),
         CLOSURE(hash),
+        CLOSURE(vector),
+        CLOSURE(dict),
+        CLOSURE_NAME("string-builder", string_builder),
+        CLOSURE_NAME("byte-array", byte_array),
+        CLOSURE_NAME("int64-array", int64_array),
+        CLOSURE_NAME("double-array", double_array),
 
         /* symbols */
         CLOSURE(var),
         CLOSURE(name),
 
         /* accesors */
-        CLOSURE(set), /* symbol variable array hash object */
-        CLOSURE(get), /* array hash object */
-        CLOSURE(append), /* array hash */
-        CLOSURE(remove), /* array hash */
-        CLOSURE(size), /* array hash */
-        CLOSURE(find), /* array hash */
-        CLOSURE(filter), /* array hash */
+        CLOSURE(set), /* symbol variable array hash object typed-array vector dict */
+        CLOSURE(get), /* array hash object typed-array vector dict */
+        CLOSURE(append), /* array hash vector dict string-builder */
+        CLOSURE(remove), /* array hash dict */
+        CLOSURE(size), /* array hash typed-array vector dict string-builder */
+        CLOSURE(find), /* array hash iterator */
+        CLOSURE(filter), /* array hash vector iterator */
         CLOSURE(compare),
         CLOSURE(sort), /* array */
+        CLOSURE_NAME("sort-by", sort_by), /* array */
         CLOSURE(reverse), /* array */
         CLOSURE(keys), /* hash */
 
@@ -2225,21 +3650,27 @@ GHashTable* gel_make_default_symbols(void)
         CLOSURE(type),
 
         /* arithmetic */
-        CLOSURE_NAME("+", add), /* number string array hash */
-        CLOSURE_NAME("-", sub), /* number */
-        CLOSURE_NAME("*", mul), /* number */
-        CLOSURE_NAME("/", div), /* number */
-        CLOSURE_NAME("%", mod), /* number */
+        CLOSURE_NAME("+", add), /* number string array hash typed-array */
+        CLOSURE_NAME("-", sub), /* number typed-array */
+        CLOSURE_NAME("*", mul), /* number typed-array */
+        CLOSURE_NAME("/", div), /* number typed-array */
+        CLOSURE_NAME("%", mod), /* number typed-array */
+
+        /* reductions */
+        CLOSURE(sum), /* typed array */
+        CLOSURE(min), /* typed array */
+        CLOSURE(max), /* typed array */
+        CLOSURE_NAME("dot", dot_product), /* typed array */
 
         /* logic */
         CLOSURE(and),
         CLOSURE(or),
-        CLOSURE_NAME(">", gt), /* number string */
-        CLOSURE_NAME(">=", ge), /* number string */
-        CLOSURE_NAME("=", eq), /* number string array */
-        CLOSURE_NAME("<", lt), /* number string */
-        CLOSURE_NAME("<=", le), /* number string */
-        CLOSURE_NAME("!=", ne), /* number string */
+        CLOSURE_NAME(">", gt), /* number string typed-array */
+        CLOSURE_NAME(">=", ge), /* number string typed-array */
+        CLOSURE_NAME("=", eq), /* number string array typed-array */
+        CLOSURE_NAME("<", lt), /* number string typed-array */
+        CLOSURE_NAME("<=", le), /* number string typed-array */
+        CLOSURE_NAME("!=", ne), /* number string typed-array */
 
 #ifdef HAVE_GOBJECT_INTROSPECTION
         /* introspection */
@@ -0,0 +1,299 @@
+#include <string.h>
+
+#include <gelrope.h>
+
+
+/*
+ * A rope is an immutable string made of the concatenation of other ropes,
+ * so joining two of them takes O(log n) time and copies no text. The
+ * leaves hold the text, and nodes are kept balanced like an AVL tree by
+ * their heights. Short leaves are merged as they are joined, so a rope
+ * grown by appending small strings keeps leaves of a useful size.
+ *
+ * The text of a rope as a plain string is only made when it is needed
+ * and is then kept in the rope, so a rope used as a string many times is
+ * only flattened once. Ropes are shared by reference, like the text of
+ * a leaf, and only the flattened text is ever written after creation.
+ */
+#define GEL_ROPE_LEAF_MAX 256
+
+struct _GelRope
+{
+    GelRope *left;
+    GelRope *right;
+    gchar *string;
+    gsize length;
+    guint height;
+    volatile gint ref_count;
+};
+
+
+static
+void gel_rope_to_string_transform(const GValue *src_value, GValue *dest_value)
+{
+    GelRope *self = g_value_get_boxed(src_value);
+    g_value_set_string(dest_value, gel_rope_get_string(self));
+}
+
+
+GType gel_rope_get_type(void)
+{
+    static volatile gsize once = 0;
+    static GType type = G_TYPE_INVALID;
+
+    if(g_once_init_enter(&once))
+    {
+        type = g_boxed_type_register_static("GelRope",
+            (GBoxedCopyFunc)gel_rope_ref,
+            (GBoxedFreeFunc)gel_rope_unref);
+
+        g_value_register_transform_func(type, G_TYPE_STRING,
+            gel_rope_to_string_transform);
+
+        g_once_init_leave(&once, 1);
+    }
+
+    return type;
+}
+
+
+static
+GelRope* gel_rope_leaf_new(const gchar *s1, gsize n1,
+                           const gchar *s2, gsize n2)
+{
+    GelRope *self = g_slice_new0(GelRope);
+    self->string = g_malloc(n1 + n2 + 1);
+    /* an empty part may have no string at all */
+    if(n1 > 0)
+        memcpy(self->string, s1, n1);
+    if(n2 > 0)
+        memcpy(self->string + n1, s2, n2);
+    self->string[n1 + n2] = 0;
+    self->length = n1 + n2;
+    self->ref_count = 1;
+
+    return self;
+}
+
+
+/* Makes a node of left and right, taking their references */
+static
+GelRope* gel_rope_node_new(GelRope *left, GelRope *right)
+{
+    GelRope *self = g_slice_new0(GelRope);
+    self->left = left;
+    self->right = right;
+    self->length = left->length + right->length;
+    self->height = MAX(left->height, right->height) + 1;
+    self->ref_count = 1;
+
+    return self;
+}
+
+
+GelRope* gel_rope_new(const gchar *string, gsize length)
+{
+    g_return_val_if_fail(string != NULL || length == 0, NULL);
+
+    return gel_rope_leaf_new(string, length, NULL, 0);
+}
+
+
+GelRope* gel_rope_ref(GelRope *self)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+
+    g_atomic_int_inc(&self->ref_count);
+    return self;
+}
+
+
+void gel_rope_unref(GelRope *self)
+{
+    g_return_if_fail(self != NULL);
+
+    if(g_atomic_int_dec_and_test(&self->ref_count))
+    {
+        if(self->left != NULL)
+        {
+            gel_rope_unref(self->left);
+            gel_rope_unref(self->right);
+        }
+        g_free(self->string);
+        g_slice_free(GelRope, self);
+    }
+}
+
+
+gsize gel_rope_get_length(const GelRope *self)
+{
+    return self->length;
+}
+
+
+/* The rotations take the reference of self */
+static
+GelRope* gel_rope_rotate_left(GelRope *self)
+{
+    GelRope *right = self->right;
+    GelRope *result = gel_rope_node_new(
+        gel_rope_node_new(gel_rope_ref(self->left), gel_rope_ref(right->left)),
+        gel_rope_ref(right->right));
+
+    gel_rope_unref(self);
+    return result;
+}
+
+
+static
+GelRope* gel_rope_rotate_right(GelRope *self)
+{
+    GelRope *left = self->left;
+    GelRope *result = gel_rope_node_new(
+        gel_rope_ref(left->left),
+        gel_rope_node_new(gel_rope_ref(left->right), gel_rope_ref(self->right)));
+
+    gel_rope_unref(self);
+    return result;
+}
+
+
+/* Makes a node of left and right, whose heights differ by two at most */
+static
+GelRope* gel_rope_balance(GelRope *left, GelRope *right)
+{
+    if(right->height > left->height + 1)
+    {
+        if(right->left->height > right->right->height)
+            right = gel_rope_rotate_right(right);
+        return gel_rope_rotate_left(gel_rope_node_new(left, right));
+    }
+
+    if(left->height > right->height + 1)
+    {
+        if(left->right->height > left->left->height)
+            left = gel_rope_rotate_left(left);
+        return gel_rope_rotate_right(gel_rope_node_new(left, right));
+    }
+
+    return gel_rope_node_new(left, right);
+}
+
+
+/*
+ * Joins left and right, taking their references. The taller one is
+ * descended until the other fits beside one of its subtrees, and the
+ * nodes on the way are rebalanced like in the join of AVL trees.
+ */
+static
+GelRope* gel_rope_join(GelRope *left, GelRope *right)
+{
+    if(left->length == 0 || right->length == 0)
+    {
+        GelRope *result = left->length == 0 ? right : left;
+        gel_rope_unref(result == left ? right : left);
+        return result;
+    }
+
+    if(left->height == 0 && right->height == 0
+       && left->length + right->length <= GEL_ROPE_LEAF_MAX)
+    {
+        GelRope *result = gel_rope_leaf_new(left->string, left->length,
+            right->string, right->length);
+        gel_rope_unref(left);
+        gel_rope_unref(right);
+        return result;
+    }
+
+    /* a short string appended goes into the last leaf */
+    if(right->height == 0 && left->height > 0 && left->right->height == 0
+       && left->right->length + right->length <= GEL_ROPE_LEAF_MAX)
+    {
+        GelRope *l = gel_rope_ref(left->left);
+        GelRope *leaf = gel_rope_join(gel_rope_ref(left->right), right);
+        gel_rope_unref(left);
+        return gel_rope_balance(l, leaf);
+    }
+
+    if(left->height > right->height + 1)
+    {
+        GelRope *l = gel_rope_ref(left->left);
+        GelRope *r = gel_rope_join(gel_rope_ref(left->right), right);
+        gel_rope_unref(left);
+        return gel_rope_balance(l, r);
+    }
+
+    if(right->height > left->height + 1)
+    {
+        GelRope *l = gel_rope_join(left, gel_rope_ref(right->left));
+        GelRope *r = gel_rope_ref(right->right);
+        gel_rope_unref(right);
+        return gel_rope_balance(l, r);
+    }
+
+    return gel_rope_node_new(left, right);
+}
+
+
+GelRope* gel_rope_concat(GelRope *left, GelRope *right)
+{
+    g_return_val_if_fail(left != NULL, NULL);
+    g_return_val_if_fail(right != NULL, NULL);
+
+    return gel_rope_join(gel_rope_ref(left), gel_rope_ref(right));
+}
+
+
+static
+gchar* gel_rope_flatten(const GelRope *self, gchar *dest)
+{
+    if(self->string != NULL)
+    {
+        memcpy(dest, self->string, self->length);
+        return dest + self->length;
+    }
+
+    dest = gel_rope_flatten(self->left, dest);
+    return gel_rope_flatten(self->right, dest);
+}
+
+
+/* The string is made once and is valid while self is */
+const gchar* gel_rope_get_string(GelRope *self)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+
+    gchar *string = g_atomic_pointer_get(&self->string);
+    if(string != NULL)
+        return string;
+
+    string = g_malloc(self->length + 1);
+    *gel_rope_flatten(self, string) = 0;
+
+    /* another thread may have flattened self meanwhile */
+    if(!g_atomic_pointer_compare_and_exchange(&self->string, NULL, string))
+    {
+        g_free(string);
+        string = g_atomic_pointer_get(&self->string);
+    }
+
+    return string;
+}
+
+
+/* Appends the text of self to buffer, without flattening it */
+void gel_rope_append_to(const GelRope *self, GString *buffer)
+{
+    g_return_if_fail(self != NULL);
+    g_return_if_fail(buffer != NULL);
+
+    const gchar *string = g_atomic_pointer_get(&self->string);
+    if(string != NULL)
+        g_string_append_len(buffer, string, self->length);
+    else
+    {
+        gel_rope_append_to(self->left, buffer);
+        gel_rope_append_to(self->right, buffer);
+    }
+}
+
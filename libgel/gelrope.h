@@ -0,0 +1,24 @@
+#ifndef __GEL_ROPE_H__
+#define __GEL_ROPE_H__
+
+#include <glib-object.h>
+
+#define GEL_TYPE_ROPE (gel_rope_get_type())
+
+typedef struct _GelRope GelRope;
+GType gel_rope_get_type(void) G_GNUC_CONST;
+
+/* strings made by + from this length on are ropes */
+#define GEL_ROPE_MIN_LENGTH 1024
+
+GelRope* gel_rope_new(const gchar *string, gsize length);
+GelRope* gel_rope_ref(GelRope *self);
+void gel_rope_unref(GelRope *self);
+
+gsize gel_rope_get_length(const GelRope *self);
+GelRope* gel_rope_concat(GelRope *left, GelRope *right);
+const gchar* gel_rope_get_string(GelRope *self);
+void gel_rope_append_to(const GelRope *self, GString *buffer);
+
+#endif
+
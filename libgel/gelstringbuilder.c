@@ -0,0 +1,105 @@
+#include <gelstringbuilder.h>
+#include <gelvalue.h>
+#include <gelwriter.h>
+
+
+/*
+ * A string builder is a mutable string, shared by reference like a hash,
+ * that values are appended to in place. Appending to it only copies the
+ * text appended, so it is the way to assemble a long string piece by
+ * piece when the intermediate strings are not needed.
+ */
+struct _GelStringBuilder
+{
+    GString *buffer;
+    volatile gint ref_count;
+};
+
+
+static
+void gel_string_builder_to_string_transform(const GValue *src_value,
+                                            GValue *dest_value)
+{
+    GelStringBuilder *self = g_value_get_boxed(src_value);
+    g_value_set_string(dest_value, self->buffer->str);
+}
+
+
+GType gel_string_builder_get_type(void)
+{
+    static volatile gsize once = 0;
+    static GType type = G_TYPE_INVALID;
+
+    if(g_once_init_enter(&once))
+    {
+        type = g_boxed_type_register_static("GelStringBuilder",
+            (GBoxedCopyFunc)gel_string_builder_ref,
+            (GBoxedFreeFunc)gel_string_builder_unref);
+
+        g_value_register_transform_func(type, G_TYPE_STRING,
+            gel_string_builder_to_string_transform);
+
+        g_once_init_leave(&once, 1);
+    }
+
+    return type;
+}
+
+
+GelStringBuilder* gel_string_builder_new(void)
+{
+    GelStringBuilder *self = g_slice_new0(GelStringBuilder);
+    self->buffer = g_string_new(NULL);
+    self->ref_count = 1;
+
+    return self;
+}
+
+
+GelStringBuilder* gel_string_builder_ref(GelStringBuilder *self)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+
+    g_atomic_int_inc(&self->ref_count);
+    return self;
+}
+
+
+void gel_string_builder_unref(GelStringBuilder *self)
+{
+    g_return_if_fail(self != NULL);
+
+    if(g_atomic_int_dec_and_test(&self->ref_count))
+    {
+        g_string_free(self->buffer, TRUE);
+        g_slice_free(GelStringBuilder, self);
+    }
+}
+
+
+gsize gel_string_builder_get_length(const GelStringBuilder *self)
+{
+    return self->buffer->len;
+}
+
+
+/* The string is valid until self is changed */
+const gchar* gel_string_builder_get_string(const GelStringBuilder *self)
+{
+    return self->buffer->str;
+}
+
+
+/* Appends strings and ropes as they are, and other values like str does */
+void gel_string_builder_append(GelStringBuilder *self, const GValue *value)
+{
+    g_return_if_fail(self != NULL);
+    g_return_if_fail(G_IS_VALUE(value));
+
+    GelWriter writer;
+
+    gel_writer_init_buffer(&writer, self->buffer);
+    gel_writer_write_value(&writer, value, FALSE);
+    gel_writer_clear(&writer);
+}
+
@@ -0,0 +1,20 @@
+#ifndef __GEL_STRING_BUILDER_H__
+#define __GEL_STRING_BUILDER_H__
+
+#include <glib-object.h>
+
+#define GEL_TYPE_STRING_BUILDER (gel_string_builder_get_type())
+
+typedef struct _GelStringBuilder GelStringBuilder;
+GType gel_string_builder_get_type(void) G_GNUC_CONST;
+
+GelStringBuilder* gel_string_builder_new(void);
+GelStringBuilder* gel_string_builder_ref(GelStringBuilder *self);
+void gel_string_builder_unref(GelStringBuilder *self);
+
+gsize gel_string_builder_get_length(const GelStringBuilder *self);
+const gchar* gel_string_builder_get_string(const GelStringBuilder *self);
+void gel_string_builder_append(GelStringBuilder *self, const GValue *value);
+
+#endif
+
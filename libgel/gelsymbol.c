@@ -1,10 +1,19 @@
 #include <gelsymbol.h>
 
 
+/*
+ * Symbol names are interned, so symbols with the same name share the same
+ * string and can be compared by pointer. Symbols are reference counted and
+ * copying a symbol (as done when code is copied) only takes a reference.
+ * So the code of closures and interpreters in several threads may share a
+ * symbol, and the variable of a symbol, a predefined one bound by the
+ * parser, never changes after the symbol is created.
+ */
 struct _GelSymbol
 {
-    gchar *name;
+    const gchar *name;
     GelVariable *variable;
+    volatile gint ref_count;
 };
 
 
@@ -29,7 +38,8 @@ GelSymbol* gel_symbol_new(const gchar *name, GelVariable *variable)
     g_return_val_if_fail(name != NULL, NULL);
 
     GelSymbol *self = g_slice_new0(GelSymbol);
-    self->name = g_strdup(name);
+    self->name = g_intern_string(name);
+    self->ref_count = 1;
 
     if(variable != NULL)
         self->variable = gel_variable_ref(variable);
@@ -44,7 +54,10 @@ GelSymbol* gel_symbol_dup(const GelSymbol *self)
 {
     g_return_val_if_fail(self != NULL, NULL);
 
-    return gel_symbol_new(self->name, self->variable);
+    GelSymbol *symbol = (GelSymbol *)self;
+    g_atomic_int_inc(&symbol->ref_count);
+
+    return symbol;
 }
 
 
@@ -52,10 +65,12 @@ void gel_symbol_free(GelSymbol *self)
 {
     g_return_if_fail(self != NULL);
 
-    g_free(self->name);
-    if(self->variable != NULL)
-        gel_variable_unref(self->variable);
-    g_slice_free(GelSymbol, self);
+    if(g_atomic_int_dec_and_test(&self->ref_count))
+    {
+        if(self->variable != NULL)
+            gel_variable_unref(self->variable);
+        g_slice_free(GelSymbol, self);
+    }
 }
 
 
@@ -75,16 +90,6 @@ GelVariable* gel_symbol_get_variable(const GelSymbol *self)
 }
 
 
-void gel_symbol_set_variable(GelSymbol *self, GelVariable *variable)
-{
-    g_return_if_fail(self != NULL);
-
-    if(self->variable != NULL)
-        gel_variable_unref(self->variable);
-    self->variable = variable != NULL ? gel_variable_ref(variable) : NULL;
-}
-
-
 GValue* gel_symbol_get_value(const GelSymbol *self)
 {
     g_return_val_if_fail(self != NULL, NULL);
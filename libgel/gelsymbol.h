@@ -13,7 +13,6 @@ void gel_symbol_free(GelSymbol *self);
 
 const gchar* gel_symbol_get_name(const GelSymbol *self);
 GelVariable* gel_symbol_get_variable(const GelSymbol *self);
-void gel_symbol_set_variable(GelSymbol *self, GelVariable *variable);
 GValue* gel_symbol_get_value(const GelSymbol *self);
 
 #endif
@@ -0,0 +1,903 @@
+#include <string.h>
+
+#include <geltypedarray.h>
+#include <gelvalueprivate.h>
+
+
+/*
+ * A typed array keeps numbers of a single kind in a contiguous native
+ * buffer, instead of a #GelArray of #GValue. Like with #GelArray, copying a
+ * typed array value only takes a reference.
+ *
+ * Kinds are ordered by promotion: an operation between different kinds
+ * converts its operands to the widest of them, and numbers count as
+ * int64 or double. Arithmetic on byte arrays is done in int64, so
+ * (+ (byte-array 250) (byte-array 250)) gives 500 instead of wrapping.
+ * Division and modulo by zero fail, and like with numbers, the modulo
+ * of doubles is taken on their truncated values.
+ *
+ * The element-wise kernels are written with the vector extensions of GCC
+ * and clang, so each step handles GEL_TYPED_ARRAY_VECTOR_SIZE bytes with
+ * whatever SIMD instructions the target has. On other compilers a vector
+ * is a single element and the same loops run scalar.
+ */
+struct _GelTypedArray
+{
+    GelTypedArrayKind kind;
+    guint n_elements;
+    gpointer data;
+    volatile gint ref_count;
+};
+
+
+#if defined(__GNUC__)
+#define GEL_TYPED_ARRAY_VECTOR_SIZE 32
+typedef gint64 GelInt64Vector
+    __attribute__((vector_size(GEL_TYPED_ARRAY_VECTOR_SIZE)));
+typedef gdouble GelDoubleVector
+    __attribute__((vector_size(GEL_TYPED_ARRAY_VECTOR_SIZE)));
+#else
+typedef gint64 GelInt64Vector;
+typedef gdouble GelDoubleVector;
+#endif
+
+
+static const gsize gel_typed_array_element_sizes[] =
+{
+    sizeof(guint8),
+    sizeof(gint64),
+    sizeof(gdouble)
+};
+
+
+static const gchar *const gel_typed_array_kind_names[] =
+{
+    "byte-array",
+    "int64-array",
+    "double-array"
+};
+
+
+GType gel_typed_array_get_type(void)
+{
+    static volatile gsize once = 0;
+    static GType type = G_TYPE_INVALID;
+
+    if(g_once_init_enter(&once))
+    {
+        type = g_boxed_type_register_static("GelTypedArray",
+            (GBoxedCopyFunc)gel_typed_array_ref,
+            (GBoxedFreeFunc)gel_typed_array_unref);
+        g_once_init_leave(&once, 1);
+    }
+
+    return type;
+}
+
+
+GelTypedArray* gel_typed_array_new(GelTypedArrayKind kind, guint n_elements)
+{
+    GelTypedArray *self = g_slice_new0(GelTypedArray);
+    self->kind = kind;
+    self->n_elements = n_elements;
+    self->data = g_malloc(n_elements * gel_typed_array_element_sizes[kind]);
+    self->ref_count = 1;
+
+    return self;
+}
+
+
+GelTypedArray* gel_typed_array_ref(GelTypedArray *self)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+
+    g_atomic_int_inc(&self->ref_count);
+    return self;
+}
+
+
+void gel_typed_array_unref(GelTypedArray *self)
+{
+    g_return_if_fail(self != NULL);
+
+    if(g_atomic_int_dec_and_test(&self->ref_count))
+    {
+        g_free(self->data);
+        g_slice_free(GelTypedArray, self);
+    }
+}
+
+
+GelTypedArrayKind gel_typed_array_get_kind(const GelTypedArray *self)
+{
+    return self->kind;
+}
+
+
+const gchar* gel_typed_array_get_kind_name(const GelTypedArray *self)
+{
+    return gel_typed_array_kind_names[self->kind];
+}
+
+
+guint gel_typed_array_get_n_elements(const GelTypedArray *self)
+{
+    return self->n_elements;
+}
+
+
+gboolean gel_typed_array_get(const GelTypedArray *self, guint index,
+                             GValue *value)
+{
+    g_return_val_if_fail(self != NULL, FALSE);
+    g_return_val_if_fail(value != NULL, FALSE);
+
+    if(index >= self->n_elements)
+        return FALSE;
+
+    switch(self->kind)
+    {
+        case GEL_TYPED_ARRAY_BYTE:
+            g_value_init(value, G_TYPE_INT64);
+            g_value_set_int64(value, ((const guint8 *)self->data)[index]);
+            break;
+        case GEL_TYPED_ARRAY_INT64:
+            g_value_init(value, G_TYPE_INT64);
+            g_value_set_int64(value, ((const gint64 *)self->data)[index]);
+            break;
+        case GEL_TYPED_ARRAY_DOUBLE:
+            g_value_init(value, G_TYPE_DOUBLE);
+            g_value_set_double(value, ((const gdouble *)self->data)[index]);
+            break;
+    }
+
+    return TRUE;
+}
+
+
+#define GEL_NUMBER_AS(number, ctype) \
+    ((number).is_double ? (ctype)(number).v.d : (ctype)(number).v.i)
+
+
+/* Truncates doubles, failing for those out of the range of gint64 */
+static
+gboolean gel_number_to_int64(const GelNumber *number, gint64 *result)
+{
+    if(number->is_double)
+        return gel_double_to_int64(number->v.d, result);
+
+    *result = number->v.i;
+    return TRUE;
+}
+
+
+gboolean gel_typed_array_set(GelTypedArray *self, guint index,
+                             const GValue *value)
+{
+    g_return_val_if_fail(self != NULL, FALSE);
+    g_return_val_if_fail(value != NULL, FALSE);
+
+    GelNumber number;
+    if(index >= self->n_elements || !gel_value_get_number(value, &number))
+        return FALSE;
+
+    switch(self->kind)
+    {
+        case GEL_TYPED_ARRAY_BYTE:
+        {
+            gint64 byte;
+            if(!gel_number_to_int64(&number, &byte)
+               || byte < 0 || byte > G_MAXUINT8)
+                return FALSE;
+            ((guint8 *)self->data)[index] = byte;
+            break;
+        }
+        case GEL_TYPED_ARRAY_INT64:
+        {
+            gint64 i;
+            if(!gel_number_to_int64(&number, &i))
+                return FALSE;
+            ((gint64 *)self->data)[index] = i;
+            break;
+        }
+        case GEL_TYPED_ARRAY_DOUBLE:
+            ((gdouble *)self->data)[index] = GEL_NUMBER_AS(number, gdouble);
+            break;
+    }
+
+    return TRUE;
+}
+
+
+/* Compares without casting, as doubles out of the range of gint64 can not be */
+#define GEL_TRUNCATES_TO_ZERO(x) ((x) > -1 && (x) < 1)
+
+
+/* Tells if an element truncates to zero, so it can not divide */
+gboolean gel_typed_array_has_zero(const GelTypedArray *self)
+{
+    g_return_val_if_fail(self != NULL, FALSE);
+
+    for(guint i = 0; i < self->n_elements; i++)
+    {
+        gboolean is_zero = FALSE;
+        switch(self->kind)
+        {
+            case GEL_TYPED_ARRAY_BYTE:
+                is_zero = (((const guint8 *)self->data)[i] == 0);
+                break;
+            case GEL_TYPED_ARRAY_INT64:
+                is_zero = (((const gint64 *)self->data)[i] == 0);
+                break;
+            case GEL_TYPED_ARRAY_DOUBLE:
+                is_zero = GEL_TRUNCATES_TO_ZERO(
+                    ((const gdouble *)self->data)[i]);
+                break;
+        }
+        if(is_zero)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+
+#define GEL_TYPED_ARRAY_CONVERT(stype, dtype) \
+    G_STMT_START \
+    { \
+        const stype *s = self->data; \
+        dtype *d = result->data; \
+        for(guint i = 0; i < self->n_elements; i++) \
+            d[i] = s[i]; \
+    } \
+    G_STMT_END
+
+
+/* Returns a reference to @self converted to the wider @kind */
+static
+GelTypedArray* gel_typed_array_promote(GelTypedArray *self,
+                                       GelTypedArrayKind kind)
+{
+    if(self->kind == kind)
+        return gel_typed_array_ref(self);
+
+    GelTypedArray *result = gel_typed_array_new(kind, self->n_elements);
+
+    if(self->kind == GEL_TYPED_ARRAY_BYTE && kind == GEL_TYPED_ARRAY_INT64)
+        GEL_TYPED_ARRAY_CONVERT(guint8, gint64);
+    else
+    if(self->kind == GEL_TYPED_ARRAY_BYTE)
+        GEL_TYPED_ARRAY_CONVERT(guint8, gdouble);
+    else
+        GEL_TYPED_ARRAY_CONVERT(gint64, gdouble);
+
+    return result;
+}
+
+
+/*
+ * Element-wise kernels. Either @a or @b may be NULL,
+ * in which case the scalar @sa or @sb is used for every element.
+ */
+#define DEFINE_KERNEL(kind, ctype, vtype, name, op) \
+static \
+void gel_typed_array_##kind##_##name(ctype *d, const ctype *a, const ctype *b, \
+                                     ctype sa, ctype sb, guint n) \
+{ \
+    const guint lanes = sizeof(vtype) / sizeof(ctype); \
+    guint i = 0; \
+    \
+    if(a != NULL && b != NULL) \
+        for(; i + lanes <= n; i += lanes) \
+        { \
+            vtype va; \
+            vtype vb; \
+            memcpy(&va, a + i, sizeof(vtype)); \
+            memcpy(&vb, b + i, sizeof(vtype)); \
+            va = va op vb; \
+            memcpy(d + i, &va, sizeof(vtype)); \
+        } \
+    else \
+    if(a != NULL) \
+        for(; i + lanes <= n; i += lanes) \
+        { \
+            vtype va; \
+            memcpy(&va, a + i, sizeof(vtype)); \
+            va = va op sb; \
+            memcpy(d + i, &va, sizeof(vtype)); \
+        } \
+    else \
+        for(; i + lanes <= n; i += lanes) \
+        { \
+            vtype vb; \
+            memcpy(&vb, b + i, sizeof(vtype)); \
+            vb = sa op vb; \
+            memcpy(d + i, &vb, sizeof(vtype)); \
+        } \
+    \
+    for(; i < n; i++) \
+        d[i] = (a != NULL ? a[i] : sa) op (b != NULL ? b[i] : sb); \
+}
+
+DEFINE_KERNEL(int64, gint64, GelInt64Vector, add, +)
+DEFINE_KERNEL(int64, gint64, GelInt64Vector, sub, -)
+DEFINE_KERNEL(int64, gint64, GelInt64Vector, mul, *)
+
+DEFINE_KERNEL(double, gdouble, GelDoubleVector, add, +)
+DEFINE_KERNEL(double, gdouble, GelDoubleVector, sub, -)
+DEFINE_KERNEL(double, gdouble, GelDoubleVector, mul, *)
+DEFINE_KERNEL(double, gdouble, GelDoubleVector, div, /)
+
+
+/*
+ * Kernels that operate one element at a time with the functions
+ * used for numbers, since the vector / and % do not handle G_MININT64 / -1
+ * and the modulo of doubles truncates them first.
+ */
+#define DEFINE_SCALAR_KERNEL(kind, ctype, name, function) \
+static \
+void gel_typed_array_##kind##_##name(ctype *d, const ctype *a, const ctype *b, \
+                                     ctype sa, ctype sb, guint n) \
+{ \
+    for(guint i = 0; i < n; i++) \
+        d[i] = function(a != NULL ? a[i] : sa, b != NULL ? b[i] : sb); \
+}
+
+DEFINE_SCALAR_KERNEL(int64, gint64, div, gel_int64_div)
+DEFINE_SCALAR_KERNEL(int64, gint64, mod, gel_int64_mod)
+DEFINE_SCALAR_KERNEL(double, gdouble, mod, gel_double_mod)
+
+
+/*
+ * Comparison kernels, storing 1 or 0 for each element of the mask @d.
+ * They are plain loops, left for the compiler to vectorize, as the vector
+ * comparisons give masks of the width of the operands instead of bytes.
+ */
+#define DEFINE_MASK_KERNEL(kind, ctype, name, op) \
+static \
+void gel_typed_array_##kind##_##name(guint8 *d, const ctype *a, const ctype *b, \
+                                     ctype sa, ctype sb, guint n) \
+{ \
+    if(a != NULL && b != NULL) \
+        for(guint i = 0; i < n; i++) \
+            d[i] = a[i] op b[i]; \
+    else \
+    if(a != NULL) \
+        for(guint i = 0; i < n; i++) \
+            d[i] = a[i] op sb; \
+    else \
+        for(guint i = 0; i < n; i++) \
+            d[i] = sa op b[i]; \
+}
+
+#define DEFINE_MASK_KERNELS(kind, ctype) \
+    DEFINE_MASK_KERNEL(kind, ctype, gt, >) \
+    DEFINE_MASK_KERNEL(kind, ctype, ge, >=) \
+    DEFINE_MASK_KERNEL(kind, ctype, eq, ==) \
+    DEFINE_MASK_KERNEL(kind, ctype, le, <=) \
+    DEFINE_MASK_KERNEL(kind, ctype, lt, <) \
+    DEFINE_MASK_KERNEL(kind, ctype, ne, !=)
+
+DEFINE_MASK_KERNELS(byte, guint8)
+DEFINE_MASK_KERNELS(int64, gint64)
+DEFINE_MASK_KERNELS(double, gdouble)
+
+
+typedef enum
+{
+    GEL_TYPED_ARRAY_ADD,
+    GEL_TYPED_ARRAY_SUB,
+    GEL_TYPED_ARRAY_MUL,
+    GEL_TYPED_ARRAY_DIV,
+    GEL_TYPED_ARRAY_MOD
+} GelTypedArrayOp;
+
+typedef enum
+{
+    GEL_TYPED_ARRAY_GT,
+    GEL_TYPED_ARRAY_GE,
+    GEL_TYPED_ARRAY_EQ,
+    GEL_TYPED_ARRAY_LE,
+    GEL_TYPED_ARRAY_LT,
+    GEL_TYPED_ARRAY_NE
+} GelTypedArrayCmp;
+
+
+typedef void (*GelInt64Kernel)(gint64 *d, const gint64 *a, const gint64 *b,
+                               gint64 sa, gint64 sb, guint n);
+typedef void (*GelDoubleKernel)(gdouble *d, const gdouble *a,
+                                const gdouble *b,
+                                gdouble sa, gdouble sb, guint n);
+
+static const GelInt64Kernel gel_typed_array_int64_kernels[] =
+{
+    gel_typed_array_int64_add,
+    gel_typed_array_int64_sub,
+    gel_typed_array_int64_mul,
+    gel_typed_array_int64_div,
+    gel_typed_array_int64_mod
+};
+
+static const GelDoubleKernel gel_typed_array_double_kernels[] =
+{
+    gel_typed_array_double_add,
+    gel_typed_array_double_sub,
+    gel_typed_array_double_mul,
+    gel_typed_array_double_div,
+    gel_typed_array_double_mod
+};
+
+
+typedef void (*GelByteMaskKernel)(guint8 *d, const guint8 *a,
+                                  const guint8 *b,
+                                  guint8 sa, guint8 sb, guint n);
+typedef void (*GelInt64MaskKernel)(guint8 *d, const gint64 *a,
+                                   const gint64 *b,
+                                   gint64 sa, gint64 sb, guint n);
+typedef void (*GelDoubleMaskKernel)(guint8 *d, const gdouble *a,
+                                    const gdouble *b,
+                                    gdouble sa, gdouble sb, guint n);
+
+static const GelByteMaskKernel gel_typed_array_byte_mask_kernels[] =
+{
+    gel_typed_array_byte_gt,
+    gel_typed_array_byte_ge,
+    gel_typed_array_byte_eq,
+    gel_typed_array_byte_le,
+    gel_typed_array_byte_lt,
+    gel_typed_array_byte_ne
+};
+
+static const GelInt64MaskKernel gel_typed_array_int64_mask_kernels[] =
+{
+    gel_typed_array_int64_gt,
+    gel_typed_array_int64_ge,
+    gel_typed_array_int64_eq,
+    gel_typed_array_int64_le,
+    gel_typed_array_int64_lt,
+    gel_typed_array_int64_ne
+};
+
+static const GelDoubleMaskKernel gel_typed_array_double_mask_kernels[] =
+{
+    gel_typed_array_double_gt,
+    gel_typed_array_double_ge,
+    gel_typed_array_double_eq,
+    gel_typed_array_double_le,
+    gel_typed_array_double_lt,
+    gel_typed_array_double_ne
+};
+
+
+/* A typed array or a number taking part in an element-wise operation */
+typedef struct _GelTypedArrayOperand GelTypedArrayOperand;
+
+struct _GelTypedArrayOperand
+{
+    GelTypedArray *array;
+    GelNumber number;
+    GelTypedArrayKind kind;
+    gboolean is_scalar;
+};
+
+/* The data of an empty array may be NULL, and is never read then */
+#define GEL_OPERAND_DATA(operand) \
+    ((operand).is_scalar ? NULL : (operand).array->data)
+
+
+static
+gboolean gel_typed_array_operand(const GValue *value,
+                                 GelTypedArrayOperand *operand)
+{
+    memset(operand, 0, sizeof(GelTypedArrayOperand));
+
+    if(G_VALUE_HOLDS(value, GEL_TYPE_TYPED_ARRAY))
+    {
+        operand->array = g_value_get_boxed(value);
+        if(operand->array == NULL)
+            return FALSE;
+        operand->kind = operand->array->kind;
+    }
+    else
+    if(gel_value_get_number(value, &operand->number))
+    {
+        operand->kind = operand->number.is_double
+            ? GEL_TYPED_ARRAY_DOUBLE : GEL_TYPED_ARRAY_INT64;
+        operand->is_scalar = TRUE;
+    }
+    else
+        return FALSE;
+
+    return TRUE;
+}
+
+
+/*
+ * Checks that @v1 and @v2 can be operated element-wise, and promotes
+ * their arrays to the widest kind, and at least to @min_kind. On success
+ * the operands hold references that have to be released.
+ */
+static
+gboolean gel_typed_arrays_prepare(const GValue *v1, const GValue *v2,
+                                  GelTypedArrayOperand *o1,
+                                  GelTypedArrayOperand *o2,
+                                  GelTypedArrayKind min_kind,
+                                  GelTypedArrayKind *kind, guint *n_elements)
+{
+    if(!gel_typed_array_operand(v1, o1) || !gel_typed_array_operand(v2, o2))
+        return FALSE;
+
+    if(o1->array == NULL && o2->array == NULL)
+        return FALSE;
+
+    if(o1->array != NULL && o2->array != NULL
+       && o1->array->n_elements != o2->array->n_elements)
+        return FALSE;
+
+    *n_elements = (o1->array != NULL ? o1->array : o2->array)->n_elements;
+    *kind = MAX(MAX(o1->kind, o2->kind), min_kind);
+
+    if(o1->array != NULL)
+        o1->array = gel_typed_array_promote(o1->array, *kind);
+    if(o2->array != NULL)
+        o2->array = gel_typed_array_promote(o2->array, *kind);
+
+    return TRUE;
+}
+
+
+static
+void gel_typed_arrays_release(GelTypedArrayOperand *o1,
+                              GelTypedArrayOperand *o2)
+{
+    if(o1->array != NULL)
+        gel_typed_array_unref(o1->array);
+    if(o2->array != NULL)
+        gel_typed_array_unref(o2->array);
+}
+
+
+/* Divisors are compared once truncated, as the modulo of doubles does */
+#define GEL_TYPED_ARRAY_HAS_ZERO(ctype, operand, n) \
+    G_STMT_START \
+    { \
+        const ctype *a = GEL_OPERAND_DATA(operand); \
+        if((operand).is_scalar) \
+            has_zero = GEL_TRUNCATES_TO_ZERO( \
+                GEL_NUMBER_AS((operand).number, ctype)); \
+        else \
+            for(guint i = 0; i < (n) && !has_zero; i++) \
+                has_zero = GEL_TRUNCATES_TO_ZERO(a[i]); \
+    } \
+    G_STMT_END
+
+
+static
+gboolean gel_typed_arrays_arithmetic(const GValue *v1, const GValue *v2,
+                                     GValue *dest_value, GelTypedArrayOp op)
+{
+    g_return_val_if_fail(v1 != NULL, FALSE);
+    g_return_val_if_fail(v2 != NULL, FALSE);
+    g_return_val_if_fail(dest_value != NULL, FALSE);
+
+    GelTypedArrayOperand o1;
+    GelTypedArrayOperand o2;
+    GelTypedArrayKind kind;
+    guint n = 0;
+
+    /* bytes are operated as int64, so that results do not wrap */
+    if(!gel_typed_arrays_prepare(v1, v2, &o1, &o2,
+                                 GEL_TYPED_ARRAY_INT64, &kind, &n))
+        return FALSE;
+
+    gboolean has_zero = FALSE;
+    if(kind == GEL_TYPED_ARRAY_INT64
+       && (op == GEL_TYPED_ARRAY_DIV || op == GEL_TYPED_ARRAY_MOD))
+        GEL_TYPED_ARRAY_HAS_ZERO(gint64, o2, n);
+    else
+    if(kind == GEL_TYPED_ARRAY_DOUBLE && op == GEL_TYPED_ARRAY_MOD)
+        GEL_TYPED_ARRAY_HAS_ZERO(gdouble, o2, n);
+
+    gboolean result = !has_zero;
+    if(result)
+    {
+        GelTypedArray *array = gel_typed_array_new(kind, n);
+        switch(kind)
+        {
+            case GEL_TYPED_ARRAY_BYTE:
+                g_assert_not_reached();
+                break;
+            case GEL_TYPED_ARRAY_INT64:
+                gel_typed_array_int64_kernels[op](array->data,
+                    GEL_OPERAND_DATA(o1), GEL_OPERAND_DATA(o2),
+                    GEL_NUMBER_AS(o1.number, gint64),
+                    GEL_NUMBER_AS(o2.number, gint64), n);
+                break;
+            case GEL_TYPED_ARRAY_DOUBLE:
+                gel_typed_array_double_kernels[op](array->data,
+                    GEL_OPERAND_DATA(o1), GEL_OPERAND_DATA(o2),
+                    GEL_NUMBER_AS(o1.number, gdouble),
+                    GEL_NUMBER_AS(o2.number, gdouble), n);
+                break;
+        }
+
+        g_value_init(dest_value, GEL_TYPE_TYPED_ARRAY);
+        g_value_take_boxed(dest_value, array);
+    }
+
+    gel_typed_arrays_release(&o1, &o2);
+    return result;
+}
+
+
+static
+gboolean gel_typed_arrays_mask(const GValue *v1, const GValue *v2,
+                               GValue *dest_value, GelTypedArrayCmp cmp)
+{
+    g_return_val_if_fail(v1 != NULL, FALSE);
+    g_return_val_if_fail(v2 != NULL, FALSE);
+    g_return_val_if_fail(dest_value != NULL, FALSE);
+
+    GelTypedArrayOperand o1;
+    GelTypedArrayOperand o2;
+    GelTypedArrayKind kind;
+    guint n = 0;
+
+    if(!gel_typed_arrays_prepare(v1, v2, &o1, &o2,
+                                 GEL_TYPED_ARRAY_BYTE, &kind, &n))
+        return FALSE;
+
+    GelTypedArray *mask = gel_typed_array_new(GEL_TYPED_ARRAY_BYTE, n);
+    switch(kind)
+    {
+        case GEL_TYPED_ARRAY_BYTE:
+            gel_typed_array_byte_mask_kernels[cmp](mask->data,
+                GEL_OPERAND_DATA(o1), GEL_OPERAND_DATA(o2),
+                GEL_NUMBER_AS(o1.number, guint8),
+                GEL_NUMBER_AS(o2.number, guint8), n);
+            break;
+        case GEL_TYPED_ARRAY_INT64:
+            gel_typed_array_int64_mask_kernels[cmp](mask->data,
+                GEL_OPERAND_DATA(o1), GEL_OPERAND_DATA(o2),
+                GEL_NUMBER_AS(o1.number, gint64),
+                GEL_NUMBER_AS(o2.number, gint64), n);
+            break;
+        case GEL_TYPED_ARRAY_DOUBLE:
+            gel_typed_array_double_mask_kernels[cmp](mask->data,
+                GEL_OPERAND_DATA(o1), GEL_OPERAND_DATA(o2),
+                GEL_NUMBER_AS(o1.number, gdouble),
+                GEL_NUMBER_AS(o2.number, gdouble), n);
+            break;
+    }
+
+    g_value_init(dest_value, GEL_TYPE_TYPED_ARRAY);
+    g_value_take_boxed(dest_value, mask);
+
+    gel_typed_arrays_release(&o1, &o2);
+    return TRUE;
+}
+
+
+#define DEFINE_ARITHMETIC(op, OP) \
+gboolean gel_typed_arrays_##op(const GValue *v1, const GValue *v2, \
+                               GValue *dest_value) \
+{ \
+    return gel_typed_arrays_arithmetic(v1, v2, dest_value, \
+        GEL_TYPED_ARRAY_##OP); \
+}
+
+DEFINE_ARITHMETIC(add, ADD)
+DEFINE_ARITHMETIC(sub, SUB)
+DEFINE_ARITHMETIC(mul, MUL)
+DEFINE_ARITHMETIC(div, DIV)
+DEFINE_ARITHMETIC(mod, MOD)
+
+
+#define DEFINE_MASK(op, OP) \
+gboolean gel_typed_arrays_##op(const GValue *v1, const GValue *v2, \
+                               GValue *dest_value) \
+{ \
+    return gel_typed_arrays_mask(v1, v2, dest_value, GEL_TYPED_ARRAY_##OP); \
+}
+
+DEFINE_MASK(gt, GT)
+DEFINE_MASK(ge, GE)
+DEFINE_MASK(eq, EQ)
+DEFINE_MASK(le, LE)
+DEFINE_MASK(lt, LT)
+DEFINE_MASK(ne, NE)
+
+
+/*
+ * Reductions keep one accumulator per vector lane,
+ * so the lanes are only added together at the end.
+ */
+#define DEFINE_SUM(kind, ctype, vtype) \
+static \
+ctype gel_typed_array_##kind##_sum(const ctype *a, guint n) \
+{ \
+    const guint lanes = sizeof(vtype) / sizeof(ctype); \
+    ctype parts[sizeof(vtype) / sizeof(ctype)]; \
+    vtype acc = {0}; \
+    ctype result = 0; \
+    guint i = 0; \
+    \
+    for(; i + lanes <= n; i += lanes) \
+    { \
+        vtype va; \
+        memcpy(&va, a + i, sizeof(vtype)); \
+        acc += va; \
+    } \
+    \
+    memcpy(parts, &acc, sizeof(vtype)); \
+    for(guint j = 0; j < lanes; j++) \
+        result += parts[j]; \
+    for(; i < n; i++) \
+        result += a[i]; \
+    \
+    return result; \
+}
+
+DEFINE_SUM(int64, gint64, GelInt64Vector)
+DEFINE_SUM(double, gdouble, GelDoubleVector)
+
+
+#define DEFINE_DOT(kind, ctype, vtype) \
+static \
+ctype gel_typed_array_##kind##_dot(const ctype *a, const ctype *b, guint n) \
+{ \
+    const guint lanes = sizeof(vtype) / sizeof(ctype); \
+    ctype parts[sizeof(vtype) / sizeof(ctype)]; \
+    vtype acc = {0}; \
+    ctype result = 0; \
+    guint i = 0; \
+    \
+    for(; i + lanes <= n; i += lanes) \
+    { \
+        vtype va; \
+        vtype vb; \
+        memcpy(&va, a + i, sizeof(vtype)); \
+        memcpy(&vb, b + i, sizeof(vtype)); \
+        acc += va * vb; \
+    } \
+    \
+    memcpy(parts, &acc, sizeof(vtype)); \
+    for(guint j = 0; j < lanes; j++) \
+        result += parts[j]; \
+    for(; i < n; i++) \
+        result += a[i] * b[i]; \
+    \
+    return result; \
+}
+
+DEFINE_DOT(int64, gint64, GelInt64Vector)
+DEFINE_DOT(double, gdouble, GelDoubleVector)
+
+
+/*
+ * The extremes are a plain loop that is not vectorized: the order of the
+ * comparisons decides which NaN or which of equal doubles is kept.
+ */
+#define DEFINE_EXTREMUM(kind, ctype, name, op) \
+static \
+ctype gel_typed_array_##kind##_##name(const ctype *a, guint n) \
+{ \
+    ctype result = a[0]; \
+    for(guint i = 1; i < n; i++) \
+        if(a[i] op result) \
+            result = a[i]; \
+    return result; \
+}
+
+DEFINE_EXTREMUM(byte, guint8, min, <)
+DEFINE_EXTREMUM(byte, guint8, max, >)
+DEFINE_EXTREMUM(int64, gint64, min, <)
+DEFINE_EXTREMUM(int64, gint64, max, >)
+DEFINE_EXTREMUM(double, gdouble, min, <)
+DEFINE_EXTREMUM(double, gdouble, max, >)
+
+
+gboolean gel_typed_array_sum(const GelTypedArray *self, GValue *dest_value)
+{
+    g_return_val_if_fail(self != NULL, FALSE);
+    g_return_val_if_fail(dest_value != NULL, FALSE);
+
+    switch(self->kind)
+    {
+        case GEL_TYPED_ARRAY_BYTE:
+        {
+            /* bytes would overflow a byte vector, widen them one by one */
+            const guint8 *a = self->data;
+            gint64 result = 0;
+            for(guint i = 0; i < self->n_elements; i++)
+                result += a[i];
+            g_value_init(dest_value, G_TYPE_INT64);
+            g_value_set_int64(dest_value, result);
+            break;
+        }
+        case GEL_TYPED_ARRAY_INT64:
+            g_value_init(dest_value, G_TYPE_INT64);
+            g_value_set_int64(dest_value,
+                gel_typed_array_int64_sum(self->data, self->n_elements));
+            break;
+        case GEL_TYPED_ARRAY_DOUBLE:
+            g_value_init(dest_value, G_TYPE_DOUBLE);
+            g_value_set_double(dest_value,
+                gel_typed_array_double_sum(self->data, self->n_elements));
+            break;
+    }
+
+    return TRUE;
+}
+
+
+#define DEFINE_REDUCTION(name) \
+gboolean gel_typed_array_##name(const GelTypedArray *self, \
+                                GValue *dest_value) \
+{ \
+    g_return_val_if_fail(self != NULL, FALSE); \
+    g_return_val_if_fail(dest_value != NULL, FALSE); \
+    \
+    if(self->n_elements == 0) \
+        return FALSE; \
+    \
+    switch(self->kind) \
+    { \
+        case GEL_TYPED_ARRAY_BYTE: \
+            g_value_init(dest_value, G_TYPE_INT64); \
+            g_value_set_int64(dest_value, \
+                gel_typed_array_byte_##name(self->data, self->n_elements)); \
+            break; \
+        case GEL_TYPED_ARRAY_INT64: \
+            g_value_init(dest_value, G_TYPE_INT64); \
+            g_value_set_int64(dest_value, \
+                gel_typed_array_int64_##name(self->data, self->n_elements)); \
+            break; \
+        case GEL_TYPED_ARRAY_DOUBLE: \
+            g_value_init(dest_value, G_TYPE_DOUBLE); \
+            g_value_set_double(dest_value, \
+                gel_typed_array_double_##name(self->data, self->n_elements)); \
+            break; \
+    } \
+    \
+    return TRUE; \
+}
+
+DEFINE_REDUCTION(min)
+DEFINE_REDUCTION(max)
+
+
+gboolean gel_typed_arrays_dot(const GelTypedArray *a1,
+                              const GelTypedArray *a2, GValue *dest_value)
+{
+    g_return_val_if_fail(a1 != NULL, FALSE);
+    g_return_val_if_fail(a2 != NULL, FALSE);
+    g_return_val_if_fail(dest_value != NULL, FALSE);
+
+    if(a1->n_elements != a2->n_elements)
+        return FALSE;
+
+    /* bytes are widened, their products would not fit in a byte */
+    GelTypedArrayKind kind =
+        MAX(MAX(a1->kind, a2->kind), GEL_TYPED_ARRAY_INT64);
+    GelTypedArray *p1 = gel_typed_array_promote((GelTypedArray *)a1, kind);
+    GelTypedArray *p2 = gel_typed_array_promote((GelTypedArray *)a2, kind);
+
+    if(kind == GEL_TYPED_ARRAY_INT64)
+    {
+        g_value_init(dest_value, G_TYPE_INT64);
+        g_value_set_int64(dest_value,
+            gel_typed_array_int64_dot(p1->data, p2->data, p1->n_elements));
+    }
+    else
+    {
+        g_value_init(dest_value, G_TYPE_DOUBLE);
+        g_value_set_double(dest_value,
+            gel_typed_array_double_dot(p1->data, p2->data, p1->n_elements));
+    }
+
+    gel_typed_array_unref(p1);
+    gel_typed_array_unref(p2);
+    return TRUE;
+}
+
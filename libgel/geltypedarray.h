@@ -0,0 +1,63 @@
+#ifndef __GEL_TYPED_ARRAY_H__
+#define __GEL_TYPED_ARRAY_H__
+
+#include <glib-object.h>
+
+#define GEL_TYPE_TYPED_ARRAY (gel_typed_array_get_type())
+
+typedef enum
+{
+    GEL_TYPED_ARRAY_BYTE,
+    GEL_TYPED_ARRAY_INT64,
+    GEL_TYPED_ARRAY_DOUBLE
+} GelTypedArrayKind;
+
+typedef struct _GelTypedArray GelTypedArray;
+GType gel_typed_array_get_type(void) G_GNUC_CONST;
+
+GelTypedArray* gel_typed_array_new(GelTypedArrayKind kind, guint n_elements);
+GelTypedArray* gel_typed_array_ref(GelTypedArray *self);
+void gel_typed_array_unref(GelTypedArray *self);
+
+GelTypedArrayKind gel_typed_array_get_kind(const GelTypedArray *self);
+const gchar* gel_typed_array_get_kind_name(const GelTypedArray *self);
+guint gel_typed_array_get_n_elements(const GelTypedArray *self);
+
+gboolean gel_typed_array_get(const GelTypedArray *self, guint index,
+                             GValue *value);
+gboolean gel_typed_array_set(GelTypedArray *self, guint index,
+                             const GValue *value);
+gboolean gel_typed_array_has_zero(const GelTypedArray *self);
+
+gboolean gel_typed_array_sum(const GelTypedArray *self, GValue *dest_value);
+gboolean gel_typed_array_min(const GelTypedArray *self, GValue *dest_value);
+gboolean gel_typed_array_max(const GelTypedArray *self, GValue *dest_value);
+gboolean gel_typed_arrays_dot(const GelTypedArray *a1,
+                              const GelTypedArray *a2, GValue *dest_value);
+
+gboolean gel_typed_arrays_add(const GValue *v1, const GValue *v2,
+                              GValue *dest_value);
+gboolean gel_typed_arrays_sub(const GValue *v1, const GValue *v2,
+                              GValue *dest_value);
+gboolean gel_typed_arrays_mul(const GValue *v1, const GValue *v2,
+                              GValue *dest_value);
+gboolean gel_typed_arrays_div(const GValue *v1, const GValue *v2,
+                              GValue *dest_value);
+gboolean gel_typed_arrays_mod(const GValue *v1, const GValue *v2,
+                              GValue *dest_value);
+
+gboolean gel_typed_arrays_gt(const GValue *v1, const GValue *v2,
+                             GValue *dest_value);
+gboolean gel_typed_arrays_ge(const GValue *v1, const GValue *v2,
+                             GValue *dest_value);
+gboolean gel_typed_arrays_eq(const GValue *v1, const GValue *v2,
+                             GValue *dest_value);
+gboolean gel_typed_arrays_le(const GValue *v1, const GValue *v2,
+                             GValue *dest_value);
+gboolean gel_typed_arrays_lt(const GValue *v1, const GValue *v2,
+                             GValue *dest_value);
+gboolean gel_typed_arrays_ne(const GValue *v1, const GValue *v2,
+                             GValue *dest_value);
+
+#endif
+
@@ -522,12 +522,12 @@ gboolean gel_type_info_property_to_value(const GelTypeInfo *self,
 }
 
 
-void gel_type_info_closure_marshal(GClosure *gclosure,
-                                   GValue *return_value,
-                                   guint n_values, const GValue *values,
-                                   GelContext *context)
+static
+void gel_type_info_closure_invoke(GClosure *gclosure,
+                                  GValue *return_value,
+                                  guint n_values, const GValue *values,
+                                  GelContext *context)
 {
-    context = gel_context_validate(context);
     GelIntrospectionClosure *closure = (GelIntrospectionClosure *)gclosure;
     const GelTypeInfo *info = gel_introspection_closure_get_info(closure);
     GIBaseInfo *function_info = info->info;
@@ -538,7 +538,7 @@ void gel_type_info_closure_marshal(GClosure *gclosure,
     guint n_args = g_callable_info_get_n_args(function_info);
     GArgument *inputs = g_new0(GArgument, n_args + 1);
     GArgument *outputs = g_new0(GArgument, n_args);
-    GList *tmp_list = NULL;
+    GelParamsTmp tmp_params = GEL_PARAMS_TMP_INIT;
     guint n_expected_args = gel_introspection_closure_get_n_args(closure);
 
     if(n_values < n_expected_args)
@@ -590,8 +590,8 @@ void gel_type_info_closure_marshal(GClosure *gclosure,
                 case GI_TYPE_TAG_BOOLEAN:
                 {
                     gboolean number = FALSE;
-                    if(gel_context_eval_params(context, __FUNCTION__,
-                        &n_values, &values, &tmp_list, "B*", &number))
+                    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                        &n_values, &values, &tmp_params, "B*", &number))
                     {
                         if(is_input)
                         {
@@ -611,8 +611,8 @@ void gel_type_info_closure_marshal(GClosure *gclosure,
                 case GI_TYPE_TAG_INT8:
                 {
                     gint64 number = 0;
-                    if(gel_context_eval_params(context, __FUNCTION__,
-                        &n_values, &values, &tmp_list, "I*", &number))
+                    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                        &n_values, &values, &tmp_params, "I*", &number))
                     {
                         if(is_input)
                         {
@@ -632,8 +632,8 @@ void gel_type_info_closure_marshal(GClosure *gclosure,
                 case GI_TYPE_TAG_UINT8:
                 {
                     gint64 number = 0;
-                    if(gel_context_eval_params(context, __FUNCTION__,
-                        &n_values, &values, &tmp_list, "I*", &number))
+                    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                        &n_values, &values, &tmp_params, "I*", &number))
                     {
                         if(is_input)
                         {
@@ -653,8 +653,8 @@ void gel_type_info_closure_marshal(GClosure *gclosure,
                 case GI_TYPE_TAG_INT16:
                 {
                     gint64 number = 0;
-                    if(gel_context_eval_params(context, __FUNCTION__,
-                        &n_values, &values, &tmp_list, "I*", &number))
+                    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                        &n_values, &values, &tmp_params, "I*", &number))
                     {
                         if(is_input)
                         {
@@ -674,8 +674,8 @@ void gel_type_info_closure_marshal(GClosure *gclosure,
                 case GI_TYPE_TAG_UINT16:
                 {
                     gint64 number = 0;
-                    if(gel_context_eval_params(context, __FUNCTION__,
-                        &n_values, &values, &tmp_list, "I*", &number))
+                    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                        &n_values, &values, &tmp_params, "I*", &number))
                     {
                         if(is_input)
                         {
@@ -695,8 +695,8 @@ void gel_type_info_closure_marshal(GClosure *gclosure,
                 case GI_TYPE_TAG_INT32:
                 {
                     gint64 number = 0;
-                    if(gel_context_eval_params(context, __FUNCTION__,
-                        &n_values, &values, &tmp_list, "I*", &number))
+                    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                        &n_values, &values, &tmp_params, "I*", &number))
                     {
                         if(is_input)
                         {
@@ -716,8 +716,8 @@ void gel_type_info_closure_marshal(GClosure *gclosure,
                 case GI_TYPE_TAG_UINT32:
                 {
                     gint64 number = 0;
-                    if(gel_context_eval_params(context, __FUNCTION__,
-                        &n_values, &values, &tmp_list, "I*", &number))
+                    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                        &n_values, &values, &tmp_params, "I*", &number))
                     {
                         
                         if(is_input)
@@ -738,8 +738,8 @@ void gel_type_info_closure_marshal(GClosure *gclosure,
                 case GI_TYPE_TAG_INT64:
                 {
                     gint64 number = 0;
-                    if(gel_context_eval_params(context, __FUNCTION__,
-                        &n_values, &values, &tmp_list, "I*", &number))
+                    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                        &n_values, &values, &tmp_params, "I*", &number))
                     {
                         if(is_input)
                         {
@@ -759,8 +759,8 @@ void gel_type_info_closure_marshal(GClosure *gclosure,
                 case GI_TYPE_TAG_UINT64:
                 {
                     gint64 number = 0;
-                    if(gel_context_eval_params(context, __FUNCTION__,
-                        &n_values, &values, &tmp_list, "I*", &number))
+                    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                        &n_values, &values, &tmp_params, "I*", &number))
                     {
                         if(is_input)
                         {
@@ -780,8 +780,8 @@ void gel_type_info_closure_marshal(GClosure *gclosure,
                 case GI_TYPE_TAG_FLOAT:
                 {
                     gdouble number = 0;
-                    if(gel_context_eval_params(context, __FUNCTION__,
-                        &n_values, &values, &tmp_list, "F*", &number))
+                    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                        &n_values, &values, &tmp_params, "F*", &number))
                     {
                         if(is_input)
                         {
@@ -801,8 +801,8 @@ void gel_type_info_closure_marshal(GClosure *gclosure,
                 case GI_TYPE_TAG_DOUBLE:
                 {
                     gdouble number = 0;
-                    if(gel_context_eval_params(context, __FUNCTION__,
-                        &n_values, &values, &tmp_list, "F*", &number))
+                    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                        &n_values, &values, &tmp_params, "F*", &number))
                     {
                         if(is_input)
                         {
@@ -822,8 +822,8 @@ void gel_type_info_closure_marshal(GClosure *gclosure,
                 case GI_TYPE_TAG_GTYPE:
                 {
                     GType type = G_TYPE_INVALID;
-                    if(gel_context_eval_params(context, __FUNCTION__,
-                        &n_values, &values, &tmp_list, "G*", &type))
+                    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                        &n_values, &values, &tmp_params, "G*", &type))
                     {
                         if(is_input)
                         {
@@ -843,8 +843,8 @@ void gel_type_info_closure_marshal(GClosure *gclosure,
                 case GI_TYPE_TAG_UTF8:
                 {
                     gchar *string = 0;
-                    if(gel_context_eval_params(context, __FUNCTION__,
-                        &n_values, &values, &tmp_list, "S*", &string))
+                    if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                        &n_values, &values, &tmp_params, "S*", &string))
                     {
                         if(is_input)
                         {
@@ -872,8 +872,8 @@ void gel_type_info_closure_marshal(GClosure *gclosure,
                         case GI_INFO_TYPE_OBJECT:
                         {
                             GObject *object;
-                            if(gel_context_eval_params(context, __FUNCTION__,
-                                &n_values, &values, &tmp_list, "O*", &object))
+                            if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                                &n_values, &values, &tmp_params, "O*", &object))
                             {
                                 if(is_input)
                                 {
@@ -893,8 +893,8 @@ void gel_type_info_closure_marshal(GClosure *gclosure,
                         case GI_INFO_TYPE_BOXED:
                         {
                             void *boxed;
-                            if(gel_context_eval_params(context, __FUNCTION__,
-                                &n_values, &values, &tmp_list, "X*", &boxed))
+                            if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                                &n_values, &values, &tmp_params, "X*", &boxed))
                             {
                                 if(is_input)
                                 {
@@ -914,8 +914,8 @@ void gel_type_info_closure_marshal(GClosure *gclosure,
                         case GI_INFO_TYPE_ENUM:
                         {
                             gint64 number;
-                            if(gel_context_eval_params(context, __FUNCTION__,
-                                &n_values, &values, &tmp_list, "I*", &number))
+                            if(gel_context_eval_params_tmp(context, __FUNCTION__,
+                                &n_values, &values, &tmp_params, "I*", &number))
                             {
                                 if(is_input)
                                 {
@@ -970,12 +970,32 @@ void gel_type_info_closure_marshal(GClosure *gclosure,
         g_base_info_unref(arg_info);
     if(arg_type != NULL)
         g_base_info_unref(arg_type);
-    gel_list_free(tmp_list);
+    gel_params_tmp_clear(&tmp_params);
     g_free(outputs);
     g_free(inputs);
 }
 
 
+void gel_type_info_closure_marshal(GClosure *gclosure,
+                                   GValue *return_value,
+                                   guint n_values, const GValue *values,
+                                   GelContext *context)
+{
+    if(gel_context_is_valid(context))
+        gel_type_info_closure_invoke(gclosure,
+            return_value, n_values, values, context);
+    else
+    {
+        /* invoked as a signal handler */
+        GelContext *signal_context = gel_context_new();
+        gel_type_info_closure_invoke(gclosure,
+            return_value, n_values, values, signal_context);
+        gel_context_warn_error(signal_context);
+        gel_context_free(signal_context);
+    }
+}
+
+
 static
 gboolean gel_type_info_function_to_value(const GelTypeInfo *self,
                                          void *instance, GValue *return_value)
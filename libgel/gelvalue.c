@@ -1,9 +1,19 @@
+#include <string.h>
+#include <math.h>
 #include <glib-object.h>
 
 #include <gelvalue.h>
 #include <gelvalueprivate.h>
 #include <gelsymbol.h>
 #include <gelclosure.h>
+#include <geltypedarray.h>
+#include <geliterator.h>
+#include <gelhash.h>
+#include <gelvector.h>
+#include <geldict.h>
+#include <gelrope.h>
+#include <gelstringbuilder.h>
+#include <gelwriter.h>
 
 
 /**
@@ -101,125 +111,6 @@ void gel_list_free(GList *list)
 }
 
 
-static
-gchar* gel_value_stringify(const GValue *value, gchar* (*str)(const GValue *))
-{
-    gchar *result = NULL;
-    GValue string_value = {0};
-
-    g_value_init(&string_value, G_TYPE_STRING);
-    if(g_value_transform(value, &string_value))
-    {
-        result = g_value_dup_string(&string_value);
-        g_value_unset(&string_value);
-    }
-    else
-    if(G_VALUE_HOLDS(value, GEL_TYPE_ARRAY))
-    {
-        const GelArray *array = g_value_get_boxed(value);
-        GString *buffer = g_string_new("(");
-        const guint n_values = gel_array_get_n_values(array);
-
-        if(n_values > 0)
-        {
-            guint last = n_values - 1;
-            const GValue *array_values = gel_array_get_values(array);
-
-            for(guint i = 0; i <= last; i++)
-            {
-                gchar *s = str(array_values + i);
-                g_string_append_printf(buffer,
-                    "%s%s", s, i != last ? " " : ")");
-                g_free(s);
-            }
-        }
-        else
-            g_string_append_c(buffer, ')');
-
-        result =  g_string_free(buffer, FALSE);
-    }
-    else
-    if(G_VALUE_HOLDS(value, G_TYPE_HASH_TABLE))
-    {
-        GHashTable *hash = g_value_get_boxed(value);
-        GString *buffer = g_string_new("{");
-        guint n_values = g_hash_table_size(hash);
-
-        if(n_values > 0)
-        {
-            GHashTableIter iter;
-            GValue *key;
-            GValue *value;
-            guint last = n_values - 1;
-            guint i = 0;
-
-            g_hash_table_iter_init(&iter, hash);
-            while(g_hash_table_iter_next(&iter,
-                    (void *)&key, (void *)&value))
-            {
-                gchar *ks = str(key);
-                gchar *vs = str(value);
-                g_string_append_printf(buffer,
-                    "%s %s%s", ks, vs, i!=last ? " " : "}");
-                g_free(ks);
-                g_free(vs);
-                i++;
-            }
-        }
-        else
-            g_string_append_c(buffer, '}');
-
-        result =  g_string_free(buffer, FALSE);
-    }
-    else
-    if(G_VALUE_HOLDS(value, GEL_TYPE_SYMBOL))
-    {
-        const GelSymbol *symbol = g_value_get_boxed(value);
-        const GValue *symbol_value = gel_symbol_get_value(symbol);
-
-        if(symbol_value != NULL)
-            result = str(symbol_value);
-        else
-            result = g_strdup(gel_symbol_get_name(symbol));
-    }
-    else
-    if(G_VALUE_HOLDS(value, G_TYPE_CLOSURE))
-    {
-        const GClosure *closure = g_value_get_boxed(value);
-        const gchar *name = gel_closure_get_name(closure);
-
-        if(name != NULL)
-            result = g_strdup(name);
-    }
-    else
-    if(G_VALUE_HOLDS(value, G_TYPE_GTYPE))
-        result = g_strdup(g_type_name(g_value_get_gtype(value)));
-    else
-    if(G_VALUE_HOLDS(value, G_TYPE_POINTER))
-        if(g_value_peek_pointer(value) == NULL)
-            result = g_strdup("NULL");
-
-    if(result == NULL)
-    {
-        GString *repr_string = g_string_new("<");
-        g_string_append_printf(repr_string, "%s", G_VALUE_TYPE_NAME(value));
-
-        if(G_VALUE_HOLDS(value, G_TYPE_GTYPE))
-            g_string_append_printf(
-                repr_string, " %s", g_type_name(g_value_get_gtype(value)));
-        else
-        if(g_value_fits_pointer(value))
-            g_string_append_printf(
-                repr_string, " %p", g_value_peek_pointer(value));
-
-        g_string_append_c(repr_string, '>');
-        result = g_string_free(repr_string, FALSE);
-    }
-
-    return result;
-}
-
-
 /**
  * gel_value_repr:
  * @value: #GValue to make a string from
@@ -230,17 +121,17 @@ gchar* gel_value_stringify(const GValue *value, gchar* (*str)(const GValue *))
  */
 gchar* gel_value_repr(const GValue *value)
 {
-    gchar *result = NULL;
-
     g_return_val_if_fail(value != NULL, NULL);
     g_return_val_if_fail(G_IS_VALUE(value), NULL);
 
-    if(G_VALUE_HOLDS(value, G_TYPE_STRING))
-        result = g_strdup_printf("\"%s\"", g_value_get_string(value));
-    else
-        result = gel_value_stringify(value, gel_value_repr);
+    GString *buffer = g_string_new(NULL);
+    GelWriter writer;
 
-    return result;
+    gel_writer_init_buffer(&writer, buffer);
+    gel_writer_write_value(&writer, value, TRUE);
+    gel_writer_clear(&writer);
+
+    return g_string_free(buffer, FALSE);
 }
 
 
@@ -254,20 +145,14 @@ gchar* gel_value_repr(const GValue *value)
  */
 gchar* gel_value_to_string(const GValue *value)
 {
-    gchar *result = NULL;
+    GString *buffer = g_string_new(NULL);
+    GelWriter writer;
 
-    if(value == NULL)
-        result = g_strdup("NULL");
-    else
-    if(!G_IS_VALUE(value))
-        result = g_strdup("VOID");
-    else
-    if(G_VALUE_HOLDS(value, G_TYPE_STRING))
-        result = g_strdup(g_value_get_string(value));
-    else
-        result = gel_value_stringify(value, gel_value_to_string);
+    gel_writer_init_buffer(&writer, buffer);
+    gel_writer_write_value(&writer, value, FALSE);
+    gel_writer_clear(&writer);
 
-    return result;
+    return g_string_free(buffer, FALSE);
 }
 
 
@@ -280,7 +165,7 @@ gchar* gel_value_to_string(const GValue *value)
  * An invalid value is #FALSE
  * A string is #FALSE if it is empty.
  * A number is #FALSE if it is zero.
- * An array is #FALSE if it does not have elements.
+ * An array or a typed array is #FALSE if it does not have elements.
  * A pointer, object or boxed is #FALSE if it is #NULL.
  *
  * Returns: #FALSE if @value is empty or zero, #TRUE otherwise
@@ -320,10 +205,47 @@ gboolean gel_value_to_boolean(const GValue *value)
                 break;
             }
             else
-            if(type == G_TYPE_HASH_TABLE)
+            if(type == GEL_TYPE_HASH)
             {
-                GHashTable *hash = g_value_get_boxed(value);
-                result = (hash != NULL && g_hash_table_size(hash) != 0);
+                GelHash *hash = g_value_get_boxed(value);
+                result = (hash != NULL && gel_hash_get_size(hash) != 0);
+                break;
+            }
+            else
+            if(type == GEL_TYPE_TYPED_ARRAY)
+            {
+                GelTypedArray *array = g_value_get_boxed(value);
+                result = (array != NULL
+                    && gel_typed_array_get_n_elements(array) != 0);
+                break;
+            }
+            else
+            if(type == GEL_TYPE_ROPE)
+            {
+                GelRope *rope = g_value_get_boxed(value);
+                result = (rope != NULL && gel_rope_get_length(rope) != 0);
+                break;
+            }
+            else
+            if(type == GEL_TYPE_STRING_BUILDER)
+            {
+                GelStringBuilder *builder = g_value_get_boxed(value);
+                result = (builder != NULL
+                    && gel_string_builder_get_length(builder) != 0);
+                break;
+            }
+            else
+            if(type == GEL_TYPE_VECTOR)
+            {
+                GelVector *vector = g_value_get_boxed(value);
+                result = (vector != NULL && gel_vector_get_size(vector) != 0);
+                break;
+            }
+            else
+            if(type == GEL_TYPE_DICT)
+            {
+                GelDict *dict = g_value_get_boxed(value);
+                result = (dict != NULL && gel_dict_get_size(dict) != 0);
                 break;
             }
             else
@@ -364,10 +286,16 @@ GType gel_value_simple_type(const GValue *value)
             if(G_VALUE_HOLDS(value, G_TYPE_ENUM)
                || G_VALUE_HOLDS(value, G_TYPE_FLAGS))
                 return G_TYPE_INT64;
+            if(G_VALUE_HOLDS(value, GEL_TYPE_ROPE))
+                return G_TYPE_STRING;
             if(G_VALUE_HOLDS(value, GEL_TYPE_ARRAY))
                 return GEL_TYPE_ARRAY;
-            if(G_VALUE_HOLDS(value, G_TYPE_HASH_TABLE))
-                return G_TYPE_HASH_TABLE;
+            if(G_VALUE_HOLDS(value, GEL_TYPE_HASH))
+                return GEL_TYPE_HASH;
+            if(G_VALUE_HOLDS(value, GEL_TYPE_VECTOR))
+                return GEL_TYPE_VECTOR;
+            if(G_VALUE_HOLDS(value, GEL_TYPE_DICT))
+                return GEL_TYPE_DICT;
             if(g_value_fits_pointer(value))
                 return G_TYPE_POINTER;
 
@@ -398,27 +326,124 @@ GType gel_values_simple_type(const GValue *v1, const GValue *v2)
 }
 
 
-static
+/* Mixes every bit of x into the result, like the finalizer of splitmix64 */
+static inline
+guint gel_hash_mix(guint64 x)
+{
+    x ^= x >> 30;
+    x *= G_GUINT64_CONSTANT(0xbf58476d1ce4e5b9);
+    x ^= x >> 27;
+    x *= G_GUINT64_CONSTANT(0x94d049bb133111eb);
+    x ^= x >> 31;
+
+    return (guint)x;
+}
+
+
+/*
+ * Hashes value consistently with gel_values_eq: numbers that are equal,
+ * like 1 and 1.0, have the same hash, strings are hashed by their
+ * contents, arrays and vectors by their values and dicts by their entries.
+ */
 guint gel_value_hash(const GValue *value)
 {
-    GType type = G_VALUE_TYPE(value);
-    switch(type)
+    g_return_val_if_fail(G_IS_VALUE(value), 0);
+
+    GType simple_type = gel_value_simple_type(value);
+    GValue tmp_value = {0};
+    guint result = 0;
+
+    if(simple_type == G_TYPE_INT64 || simple_type == G_TYPE_DOUBLE
+       || simple_type == G_TYPE_STRING)
     {
+        if(G_VALUE_TYPE(value) != simple_type)
+        {
+            g_value_init(&tmp_value, simple_type);
+            g_value_transform(value, &tmp_value);
+            value = &tmp_value;
+        }
+    }
+
+    switch(simple_type)
+    {
+        case G_TYPE_INT64:
+            result = gel_hash_mix(g_value_get_int64(value));
+            break;
+        case G_TYPE_DOUBLE:
+        {
+            gdouble d = g_value_get_double(value);
+            union { gdouble d; guint64 bits; } number = {d};
+
+            /* integral doubles hash like the integer they are equal to */
+            if(d >= -9.2e18 && d <= 9.2e18 && d == (gdouble)(gint64)d)
+                result = gel_hash_mix((gint64)d);
+            else
+                result = gel_hash_mix(number.bits);
+            break;
+        }
+        case G_TYPE_BOOLEAN:
+            result = gel_hash_mix(g_value_get_boolean(value) ? 1 : 0);
+            break;
         case G_TYPE_STRING:
-            return g_str_hash(g_value_get_string(value));
+        {
+            /* 64 bits FNV-1a */
+            const gchar *s = g_value_get_string(value);
+            guint64 h = G_GUINT64_CONSTANT(0xcbf29ce484222325);
+            for(; s != NULL && *s != 0; s++)
+                h = (h ^ (guchar)*s) * G_GUINT64_CONSTANT(0x100000001b3);
+            result = gel_hash_mix(h);
+            break;
+        }
         default:
-            return value->data[0].v_uint;
-    }
-}
+            if(simple_type == GEL_TYPE_ARRAY)
+            {
+                const GelArray *array = g_value_get_boxed(value);
+                const GValue *array_values = gel_array_get_values(array);
+                guint n_values = gel_array_get_n_values(array);
+                guint64 h = n_values;
+
+                for(guint i = 0; i < n_values; i++)
+                    h = h * 31 + gel_value_hash(array_values + i);
+                result = gel_hash_mix(h);
+            }
+            else
+            if(simple_type == GEL_TYPE_VECTOR)
+            {
+                const GelVector *vector = g_value_get_boxed(value);
+                guint size = gel_vector_get_size(vector);
+                guint64 h = size;
 
+                for(guint i = 0; i < size; i++)
+                    h = h * 31 + gel_value_hash(gel_vector_get(vector, i));
+                result = gel_hash_mix(h);
+            }
+            else
+            if(simple_type == GEL_TYPE_DICT)
+            {
+                /* entries are added, as equal dicts may hold them in
+                   another order */
+                const GelDict *dict = g_value_get_boxed(value);
+                guint64 h = gel_dict_get_size(dict);
+                GelDictIter iter;
+                const GValue *k;
+                const GValue *v;
+
+                gel_dict_iter_init(&iter, dict);
+                while(gel_dict_iter_next(&iter, &k, &v))
+                    h += gel_hash_mix(
+                        (guint64)gel_value_hash(k) * 31 + gel_value_hash(v));
+                result = gel_hash_mix(h);
+            }
+            else
+            if(g_value_fits_pointer(value))
+                result = gel_hash_mix(
+                    GPOINTER_TO_SIZE(g_value_peek_pointer(value)));
+    }
 
-GHashTable* gel_hash_table_new(void)
-{
-    GHashTable *hash = g_hash_table_new_full(
-            (GHashFunc)gel_value_hash, (GEqualFunc)gel_values_eq,
-            (GDestroyNotify)gel_value_free, (GDestroyNotify)gel_value_free);
+    if(G_IS_VALUE(&tmp_value))
+        g_value_unset(&tmp_value);
 
-    return hash;
+    return result;
 }
 
 
@@ -477,6 +502,53 @@ GList* gel_args_from_array(const GelArray *vars, gchar **variadic,
 }
 
 
+/*
+ * Integers wrap around when a result is out of the range of gint64,
+ * so dividing G_MININT64 by -1 gives G_MININT64, and its remainder is 0,
+ * instead of trapping. The divisor must not be zero.
+ */
+gint64 gel_int64_div(gint64 dividend, gint64 divisor)
+{
+    return divisor == -1 ?
+        (gint64)(0 - (guint64)dividend) : dividend / divisor;
+}
+
+
+gint64 gel_int64_mod(gint64 dividend, gint64 divisor)
+{
+    return divisor == -1 ? 0 : dividend % divisor;
+}
+
+
+/* Truncates value, unless it is NaN or out of the range of gint64 */
+gboolean gel_double_to_int64(gdouble value, gint64 *result)
+{
+    if(!(value >= (gdouble)G_MININT64 && value < -(gdouble)G_MININT64))
+        return FALSE;
+
+    *result = (gint64)value;
+    return TRUE;
+}
+
+
+/*
+ * The modulo of doubles truncates them to integers. It is NaN when they
+ * are NaN or the dividend is out of the range of gint64, and the dividend
+ * when only the divisor is. The divisor must not truncate to zero.
+ */
+gdouble gel_double_mod(gdouble dividend, gdouble divisor)
+{
+    gint64 i1, i2;
+    if(!gel_double_to_int64(dividend, &i1) || isnan(divisor))
+        return NAN;
+
+    if(!gel_double_to_int64(divisor, &i2))
+        return i1;
+
+    return gel_int64_mod(i1, i2);
+}
+
+
 static
 gboolean gel_values_simple_add(const GValue *v1, const GValue *v2, 
                                GValue *dest_value)
@@ -489,9 +561,9 @@ gboolean gel_values_simple_add(const GValue *v1, const GValue *v2,
     switch(type)
     {
         case G_TYPE_INT64:
-            g_value_set_int64(dest_value,
-                g_value_get_int64(v1)
-                + g_value_get_int64(v2));
+            g_value_set_int64(dest_value, (gint64)(
+                (guint64)g_value_get_int64(v1)
+                + (guint64)g_value_get_int64(v2)));
             return TRUE;
         case G_TYPE_DOUBLE:
             g_value_set_double(dest_value,
@@ -528,29 +600,43 @@ gboolean gel_values_simple_add(const GValue *v1, const GValue *v2,
                 return TRUE;
             }
             else
-            if(type == G_TYPE_HASH_TABLE)
+            if(type == GEL_TYPE_HASH)
             {
-                GHashTable *h1 = g_value_get_boxed(v1);
-                GHashTable *h2 = g_value_get_boxed(v2);
-                GHashTable *hash = gel_hash_table_new();
+                GelHash *h1 = g_value_get_boxed(v1);
+                GelHash *h2 = g_value_get_boxed(v2);
+                GelHash *hash = gel_hash_new(
+                    gel_hash_get_size(h1) + gel_hash_get_size(h2));
 
-                GHashTableIter iter;
-                GValue *k = NULL;
-                GValue *v = NULL;
+                GelHashIter iter;
+                const GValue *k = NULL;
+                const GValue *v = NULL;
 
-                g_hash_table_iter_init(&iter, h1);
-                while(g_hash_table_iter_next(&iter, (void**)&k, (void**)&v))
-                    g_hash_table_insert(hash,
-                        gel_value_dup(k), gel_value_dup(v));
+                gel_hash_iter_init(&iter, h1);
+                while(gel_hash_iter_next(&iter, &k, &v))
+                    gel_hash_insert(hash, k, v);
 
-                g_hash_table_iter_init(&iter, h2);
-                while(g_hash_table_iter_next(&iter, (void**)&k, (void**)&v))
-                    g_hash_table_insert(hash,
-                        gel_value_dup(k), gel_value_dup(v));
+                gel_hash_iter_init(&iter, h2);
+                while(gel_hash_iter_next(&iter, &k, &v))
+                    gel_hash_insert(hash, k, v);
 
                 g_value_take_boxed(dest_value, hash);
                 return TRUE;
             }
+            else
+            if(type == GEL_TYPE_VECTOR)
+            {
+                /* only the values of v2 are copied, the ones of v1 are shared */
+                g_value_take_boxed(dest_value, gel_vector_concat(
+                    g_value_get_boxed(v1), g_value_get_boxed(v2)));
+                return TRUE;
+            }
+            else
+            if(type == GEL_TYPE_DICT)
+            {
+                g_value_take_boxed(dest_value, gel_dict_merge(
+                    g_value_get_boxed(v1), g_value_get_boxed(v2)));
+                return TRUE;
+            }
             return FALSE;
     }
 }
@@ -567,9 +653,9 @@ gboolean gel_values_simple_sub(const GValue *v1, const GValue *v2,
     switch(G_VALUE_TYPE(dest_value))
     {
         case G_TYPE_INT64:
-            g_value_set_int64(dest_value,
-                g_value_get_int64(v1)
-                - g_value_get_int64(v2));
+            g_value_set_int64(dest_value, (gint64)(
+                (guint64)g_value_get_int64(v1)
+                - (guint64)g_value_get_int64(v2)));
             return TRUE;
         case G_TYPE_DOUBLE:
             g_value_set_double(dest_value,
@@ -593,9 +679,9 @@ gboolean gel_values_simple_mul(const GValue *v1, const GValue *v2,
     switch(G_VALUE_TYPE(dest_value))
     {
         case G_TYPE_INT64:
-            g_value_set_int64(dest_value,
-                g_value_get_int64(v1)
-                * g_value_get_int64(v2));
+            g_value_set_int64(dest_value, (gint64)(
+                (guint64)g_value_get_int64(v1)
+                * (guint64)g_value_get_int64(v2)));
             return TRUE;
         case G_TYPE_DOUBLE:
             g_value_set_double(dest_value,
@@ -623,7 +709,8 @@ gboolean gel_values_simple_div(const GValue *v1, const GValue *v2,
             gint64 divisor = g_value_get_int64(v2);
             if(divisor == 0)
                 return FALSE;
-            g_value_set_int64(dest_value, g_value_get_int64(v1) / divisor);
+            g_value_set_int64(dest_value,
+                gel_int64_div(g_value_get_int64(v1), divisor));
             return TRUE;
         }
         case G_TYPE_DOUBLE:
@@ -647,15 +734,23 @@ gboolean gel_values_simple_mod(const GValue *v1, const GValue *v2,
     switch(G_VALUE_TYPE(dest_value))
     {
         case G_TYPE_INT64:
+        {
+            gint64 divisor = g_value_get_int64(v2);
+            if(divisor == 0)
+                return FALSE;
             g_value_set_int64(dest_value,
-                g_value_get_int64(v1)
-                % g_value_get_int64(v2));
+                gel_int64_mod(g_value_get_int64(v1), divisor));
             return TRUE;
+        }
         case G_TYPE_DOUBLE:
+        {
+            gdouble divisor = g_value_get_double(v2);
+            if(divisor > -1 && divisor < 1)
+                return FALSE;
             g_value_set_double(dest_value,
-                (gint64)g_value_get_double(v1)
-                % (gint64)g_value_get_double(v2));
+                gel_double_mod(g_value_get_double(v1), divisor));
             return TRUE;
+        }
         default:
             return FALSE;
     }
@@ -722,7 +817,8 @@ gboolean gel_values_can_cmp(const GValue *v1, const GValue *v2)
         case G_TYPE_BOOLEAN:
             return TRUE;
         default:
-            if(type == GEL_TYPE_ARRAY)
+            if(type == GEL_TYPE_ARRAY || type == GEL_TYPE_VECTOR
+               || type == GEL_TYPE_DICT)
                 return TRUE;
             return FALSE;
     }
@@ -801,12 +897,17 @@ gboolean gel_values_simple_ne(const GValue *v1, const GValue *v2)
 static
 gboolean gel_values_arithmetic(const GValue *v1, const GValue *v2,
                                GValue *dest_value,
-                               GelValuesArithmetic values_function)
+                               GelValuesArithmetic values_function,
+                               GelValuesArithmetic typed_arrays_function)
 {
     g_return_val_if_fail(v1 != NULL, FALSE);
     g_return_val_if_fail(v2 != NULL, FALSE);
     g_return_val_if_fail(dest_value != NULL, FALSE);
 
+    if(G_VALUE_HOLDS(v1, GEL_TYPE_TYPED_ARRAY)
+       || G_VALUE_HOLDS(v2, GEL_TYPE_TYPED_ARRAY))
+        return typed_arrays_function(v1, v2, dest_value);
+
     GValue tmp1 = {0};
     GValue tmp2 = {0};
     const GValue *vv1 = NULL;
@@ -831,6 +932,47 @@ gboolean gel_values_arithmetic(const GValue *v1, const GValue *v2,
 }
 
 
+/*
+ * Dicts are equal when they hold equal values for the same keys. Other
+ * dicts have no natural order, so they are ordered by their size,
+ * then by their hash and only then by their address.
+ */
+static
+gint gel_dicts_cmp(const GValue *v1, const GValue *v2)
+{
+    const GelDict *d1 = g_value_get_boxed(v1);
+    const GelDict *d2 = g_value_get_boxed(v2);
+    if(d1 == d2)
+        return 0;
+
+    guint d1_n = gel_dict_get_size(d1);
+    guint d2_n = gel_dict_get_size(d2);
+    if(d1_n != d2_n)
+        return d1_n > d2_n ? 1 : -1;
+
+    GelDictIter iter;
+    const GValue *k;
+    const GValue *v;
+    gboolean equal = TRUE;
+
+    gel_dict_iter_init(&iter, d1);
+    while(equal && gel_dict_iter_next(&iter, &k, &v))
+    {
+        const GValue *other = gel_dict_lookup(d2, k);
+        equal = (other != NULL && gel_values_eq(v, other) == 1);
+    }
+    if(equal)
+        return 0;
+
+    guint h1 = gel_value_hash(v1);
+    guint h2 = gel_value_hash(v2);
+    if(h1 != h2)
+        return h1 > h2 ? 1 : -1;
+
+    return d1 > d2 ? 1 : -1;
+}
+
+
 /**
  * gel_values_cmp:
  * @v1: A valid #GValue
@@ -918,6 +1060,30 @@ gint gel_values_cmp(const GValue *v1, const GValue *v2)
                 if(i == n_values)
                     result = a1_n > a2_n ? 1 : a1_n < a2_n ? -1 : 0;
             }
+            else
+            if(simple_type == GEL_TYPE_VECTOR)
+            {
+                GelVector *vec1 = g_value_get_boxed(vv1);
+                GelVector *vec2 = g_value_get_boxed(vv2);
+
+                guint v1_n = gel_vector_get_size(vec1);
+                guint v2_n = gel_vector_get_size(vec2);
+                guint n_values = MIN(v1_n, v2_n);
+
+                guint i;
+                for(i = 0; i < n_values; i++)
+                {
+                    result = gel_values_cmp(
+                        gel_vector_get(vec1, i), gel_vector_get(vec2, i));
+                    if(result != 0)
+                        break;
+                }
+                if(i == n_values)
+                    result = v1_n > v2_n ? 1 : v1_n < v2_n ? -1 : 0;
+            }
+            else
+            if(simple_type == GEL_TYPE_DICT)
+                result = gel_dicts_cmp(vv1, vv2);
     }
 
     if(G_IS_VALUE(&tmp1))
@@ -1034,7 +1200,47 @@ DEFINE_LOGIC(ne)
 #define DEFINE_ARITHMETIC(op) \
 gboolean gel_values_##op(const GValue *v1, const GValue *v2, GValue *dest_value) \
 { \
-    return gel_values_arithmetic(v1, v2, dest_value, gel_values_simple_##op); \
+    return gel_values_arithmetic(v1, v2, dest_value, \
+        gel_values_simple_##op, gel_typed_arrays_##op); \
+}
+
+
+/*
+ * Joins strings into a rope when one of them is a rope already or the
+ * result is long, so a string grown by + is not copied over and over.
+ * Returns FALSE, leaving dest_value alone, for anything else.
+ */
+static
+gboolean gel_values_rope_add(const GValue *v1, const GValue *v2,
+                             GValue *dest_value)
+{
+    gboolean is_rope1 = G_VALUE_HOLDS(v1, GEL_TYPE_ROPE);
+    gboolean is_rope2 = G_VALUE_HOLDS(v2, GEL_TYPE_ROPE);
+
+    if(!(is_rope1 || G_VALUE_HOLDS(v1, G_TYPE_STRING))
+       || !(is_rope2 || G_VALUE_HOLDS(v2, G_TYPE_STRING)))
+        return FALSE;
+
+    const gchar *s1 = is_rope1 ? NULL : g_value_get_string(v1);
+    const gchar *s2 = is_rope2 ? NULL : g_value_get_string(v2);
+    gsize length1 = s1 != NULL ? strlen(s1) : 0;
+    gsize length2 = s2 != NULL ? strlen(s2) : 0;
+
+    if(!is_rope1 && !is_rope2 && length1 + length2 < GEL_ROPE_MIN_LENGTH)
+        return FALSE;
+
+    GelRope *rope1 = is_rope1 ?
+        gel_rope_ref(g_value_get_boxed(v1)) : gel_rope_new(s1, length1);
+    GelRope *rope2 = is_rope2 ?
+        gel_rope_ref(g_value_get_boxed(v2)) : gel_rope_new(s2, length2);
+
+    g_value_init(dest_value, GEL_TYPE_ROPE);
+    g_value_take_boxed(dest_value, gel_rope_concat(rope1, rope2));
+
+    gel_rope_unref(rope1);
+    gel_rope_unref(rope2);
+
+    return TRUE;
 }
 
 
@@ -1046,9 +1252,22 @@ gboolean gel_values_##op(const GValue *v1, const GValue *v2, GValue *dest_value)
  *
  * Performs @dest_value = @v1 + @v2
  *
+ * Long strings are joined into a #GelRope, that can be used as a string.
+ *
  * Returns: #TRUE if the operation was possible, #FALSE otherwise
  */
-DEFINE_ARITHMETIC(add)
+gboolean gel_values_add(const GValue *v1, const GValue *v2, GValue *dest_value)
+{
+    g_return_val_if_fail(v1 != NULL, FALSE);
+    g_return_val_if_fail(v2 != NULL, FALSE);
+    g_return_val_if_fail(dest_value != NULL, FALSE);
+
+    if(gel_values_rope_add(v1, v2, dest_value))
+        return TRUE;
+
+    return gel_values_arithmetic(v1, v2, dest_value,
+        gel_values_simple_add, gel_typed_arrays_add);
+}
 
 /**
  * gel_values_sub:
@@ -1098,3 +1317,141 @@ DEFINE_ARITHMETIC(div)
  */
 DEFINE_ARITHMETIC(mod)
 
+
+
+/*
+ * Integers and doubles are the only values most arithmetic deals with,
+ * so they have their own paths that keep them out of GValue structures
+ * and skip gel_values_simple_transform.
+ * They follow the rules of the operations on GValue structures:
+ * an operation between an integer and a double gives a double.
+ */
+gboolean gel_value_get_number(const GValue *value, GelNumber *number)
+{
+    switch(G_VALUE_TYPE(value))
+    {
+        case G_TYPE_INT64:
+            number->is_double = FALSE;
+            number->v.i = value->data[0].v_int64;
+            return TRUE;
+        case G_TYPE_DOUBLE:
+            number->is_double = TRUE;
+            number->v.d = value->data[0].v_double;
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+
+void gel_value_set_number(GValue *value, const GelNumber *number)
+{
+    if(number->is_double)
+    {
+        g_value_init(value, G_TYPE_DOUBLE);
+        g_value_set_double(value, number->v.d);
+    }
+    else
+    {
+        g_value_init(value, G_TYPE_INT64);
+        g_value_set_int64(value, number->v.i);
+    }
+}
+
+
+static
+gdouble gel_number_get_double(const GelNumber *number)
+{
+    return number->is_double ? number->v.d : (gdouble)number->v.i;
+}
+
+
+#define DEFINE_NUMBERS_ARITHMETIC(op, expr) \
+gboolean gel_numbers_##op(GelNumber *l_number, const GelNumber *r_number) \
+{ \
+    if(l_number->is_double || r_number->is_double) \
+    { \
+        l_number->v.d = gel_number_get_double(l_number) expr \
+            gel_number_get_double(r_number); \
+        l_number->is_double = TRUE; \
+    } \
+    else \
+        l_number->v.i = (gint64)( \
+            (guint64)l_number->v.i expr (guint64)r_number->v.i); \
+    return TRUE; \
+}
+
+DEFINE_NUMBERS_ARITHMETIC(add, +)
+DEFINE_NUMBERS_ARITHMETIC(sub, -)
+DEFINE_NUMBERS_ARITHMETIC(mul, *)
+
+
+gboolean gel_numbers_div(GelNumber *l_number, const GelNumber *r_number)
+{
+    if(l_number->is_double || r_number->is_double)
+    {
+        l_number->v.d =
+            gel_number_get_double(l_number) / gel_number_get_double(r_number);
+        l_number->is_double = TRUE;
+        return TRUE;
+    }
+
+    if(r_number->v.i == 0)
+        return FALSE;
+
+    l_number->v.i = gel_int64_div(l_number->v.i, r_number->v.i);
+    return TRUE;
+}
+
+
+gboolean gel_numbers_mod(GelNumber *l_number, const GelNumber *r_number)
+{
+    if(l_number->is_double || r_number->is_double)
+    {
+        gdouble divisor = gel_number_get_double(r_number);
+        if(divisor > -1 && divisor < 1)
+            return FALSE;
+
+        l_number->v.d =
+            gel_double_mod(gel_number_get_double(l_number), divisor);
+        l_number->is_double = TRUE;
+        return TRUE;
+    }
+
+    if(r_number->v.i == 0)
+        return FALSE;
+
+    l_number->v.i = gel_int64_mod(l_number->v.i, r_number->v.i);
+    return TRUE;
+}
+
+
+static
+gint gel_numbers_cmp(const GelNumber *l_number, const GelNumber *r_number)
+{
+    if(l_number->is_double || r_number->is_double)
+    {
+        gdouble d1 = gel_number_get_double(l_number);
+        gdouble d2 = gel_number_get_double(r_number);
+        return d1 > d2 ? 1 : d1 < d2 ? -1 : 0;
+    }
+
+    gint64 i1 = l_number->v.i;
+    gint64 i2 = r_number->v.i;
+    return i1 > i2 ? 1 : i1 < i2 ? -1 : 0;
+}
+
+
+#define DEFINE_NUMBERS_LOGIC(op, expr) \
+gboolean gel_numbers_##op(const GelNumber *l_number, \
+                          const GelNumber *r_number) \
+{ \
+    return gel_numbers_cmp(l_number, r_number) expr 0; \
+}
+
+DEFINE_NUMBERS_LOGIC(gt, >)
+DEFINE_NUMBERS_LOGIC(ge, >=)
+DEFINE_NUMBERS_LOGIC(eq, ==)
+DEFINE_NUMBERS_LOGIC(le, <=)
+DEFINE_NUMBERS_LOGIC(lt, <)
+DEFINE_NUMBERS_LOGIC(ne, !=)
@@ -16,6 +16,30 @@ gboolean (*GelValuesArithmetic)(const GValue *l_value, const GValue *r_value,
 typedef
 gboolean (*GelValuesLogic)(const GValue *l_value, const GValue *r_value);
 
+/*
+ * An integer or a floating point number, kept out of a #GValue
+ * while a sequence of arithmetic operations is evaluated.
+ */
+typedef struct _GelNumber GelNumber;
+
+struct _GelNumber
+{
+    gboolean is_double;
+    union
+    {
+        gint64 i;
+        gdouble d;
+    } v;
+};
+
+typedef
+gboolean (*GelNumbersArithmetic)(GelNumber *l_number,
+                                 const GelNumber *r_number);
+
+typedef
+gboolean (*GelNumbersLogic)(const GelNumber *l_number,
+                            const GelNumber *r_number);
+
 GValue* gel_value_new_from_boxed(GType type, gpointer boxed);
 GValue* gel_value_dup(const GValue *value);
 void gel_value_free(GValue *value);
@@ -23,7 +47,28 @@ void gel_value_free(GValue *value);
 GList* gel_args_from_array(const GelArray *vars, gchar **variadic,
                            gchar **invalid);
 
-GHashTable* gel_hash_table_new(void);
+guint gel_value_hash(const GValue *value);
+
+gint64 gel_int64_div(gint64 dividend, gint64 divisor);
+gint64 gel_int64_mod(gint64 dividend, gint64 divisor);
+gboolean gel_double_to_int64(gdouble value, gint64 *result);
+gdouble gel_double_mod(gdouble dividend, gdouble divisor);
+
+gboolean gel_value_get_number(const GValue *value, GelNumber *number);
+void gel_value_set_number(GValue *value, const GelNumber *number);
+
+gboolean gel_numbers_add(GelNumber *l_number, const GelNumber *r_number);
+gboolean gel_numbers_sub(GelNumber *l_number, const GelNumber *r_number);
+gboolean gel_numbers_mul(GelNumber *l_number, const GelNumber *r_number);
+gboolean gel_numbers_div(GelNumber *l_number, const GelNumber *r_number);
+gboolean gel_numbers_mod(GelNumber *l_number, const GelNumber *r_number);
+
+gboolean gel_numbers_gt(const GelNumber *l_number, const GelNumber *r_number);
+gboolean gel_numbers_ge(const GelNumber *l_number, const GelNumber *r_number);
+gboolean gel_numbers_eq(const GelNumber *l_number, const GelNumber *r_number);
+gboolean gel_numbers_le(const GelNumber *l_number, const GelNumber *r_number);
+gboolean gel_numbers_lt(const GelNumber *l_number, const GelNumber *r_number);
+gboolean gel_numbers_ne(const GelNumber *l_number, const GelNumber *r_number);
 
 GelVariable* gel_variable_lookup_predefined(const gchar *name);
 
@@ -67,3 +67,11 @@ GValue* gel_variable_get_value(const GelVariable *self)
     return self->value;
 }
 
+
+/* Whether something else than the one that created self references it */
+gboolean gel_variable_is_shared(const GelVariable *self)
+{
+    g_return_val_if_fail(self != NULL, FALSE);
+
+    return g_atomic_int_get(&self->ref_count) > 1;
+}
@@ -11,5 +11,6 @@ GelVariable* gel_variable_ref(GelVariable *self);
 void gel_variable_unref(GelVariable *self);
 
 GValue* gel_variable_get_value(const GelVariable *self);
+gboolean gel_variable_is_shared(const GelVariable *self);
 
 #endif
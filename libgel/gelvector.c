@@ -0,0 +1,410 @@
+#include <gelvector.h>
+#include <gelvalue.h>
+#include <gelvalueprivate.h>
+
+
+/*
+ * A vector is a persistent array: it is never changed, and appending to it
+ * or setting one of its values makes a new vector that shares all but
+ * a few nodes with the old one, so both take O(log n) time and memory.
+ *
+ * The values are kept in leaves of 32 values, under a trie of nodes with
+ * 32 children each, indexed by 5 bits of the index per level. The last
+ * leaf, the tail, is kept out of the trie so appending only copies it
+ * until it is full and moves into the trie.
+ *
+ * Leaves and nodes are reference counted and shared between vectors.
+ * A vector being built by this module changes in place the ones only it
+ * refers to, so appending many values at once copies each of them once.
+ */
+#define GEL_VECTOR_BITS 5
+#define GEL_VECTOR_WIDTH (1 << GEL_VECTOR_BITS)
+#define GEL_VECTOR_MASK (GEL_VECTOR_WIDTH - 1)
+
+typedef struct _GelVectorLeaf GelVectorLeaf;
+typedef struct _GelVectorNode GelVectorNode;
+
+struct _GelVectorLeaf
+{
+    volatile gint ref_count;
+    GValue values[GEL_VECTOR_WIDTH];
+};
+
+/* the children are nodes, or leaves on the last level */
+struct _GelVectorNode
+{
+    volatile gint ref_count;
+    gpointer children[GEL_VECTOR_WIDTH];
+};
+
+struct _GelVector
+{
+    guint size;
+    guint shift;
+    GelVectorNode *root;
+    GelVectorLeaf *tail;
+    volatile gint ref_count;
+};
+
+
+GType gel_vector_get_type(void)
+{
+    static volatile gsize once = 0;
+    static GType type = G_TYPE_INVALID;
+
+    if(g_once_init_enter(&once))
+    {
+        type = g_boxed_type_register_static("GelVector",
+            (GBoxedCopyFunc)gel_vector_ref,
+            (GBoxedFreeFunc)gel_vector_unref);
+        g_once_init_leave(&once, 1);
+    }
+
+    return type;
+}
+
+
+static
+void gel_vector_leaf_unref(GelVectorLeaf *leaf)
+{
+    if(g_atomic_int_dec_and_test(&leaf->ref_count))
+    {
+        for(guint i = 0; i < GEL_VECTOR_WIDTH; i++)
+            if(G_IS_VALUE(leaf->values + i))
+                g_value_unset(leaf->values + i);
+        g_slice_free(GelVectorLeaf, leaf);
+    }
+}
+
+
+/* level is the shift of the node, its children are leaves at the lowest one */
+static
+void gel_vector_node_unref(GelVectorNode *node, guint level)
+{
+    if(g_atomic_int_dec_and_test(&node->ref_count))
+    {
+        for(guint i = 0; i < GEL_VECTOR_WIDTH; i++)
+            if(node->children[i] != NULL)
+            {
+                if(level == GEL_VECTOR_BITS)
+                    gel_vector_leaf_unref(node->children[i]);
+                else
+                    gel_vector_node_unref(node->children[i],
+                        level - GEL_VECTOR_BITS);
+            }
+        g_slice_free(GelVectorNode, node);
+    }
+}
+
+
+/* Returns leaf, or a copy of it if it is shared, taking its reference */
+static
+GelVectorLeaf* gel_vector_leaf_own(GelVectorLeaf *leaf)
+{
+    if(g_atomic_int_get(&leaf->ref_count) == 1)
+        return leaf;
+
+    GelVectorLeaf *copy = g_slice_new0(GelVectorLeaf);
+    copy->ref_count = 1;
+    for(guint i = 0; i < GEL_VECTOR_WIDTH; i++)
+        if(G_IS_VALUE(leaf->values + i))
+            gel_value_copy(leaf->values + i, copy->values + i);
+
+    gel_vector_leaf_unref(leaf);
+    return copy;
+}
+
+
+/* Returns node, or a copy of it if it is shared, taking its reference */
+static
+GelVectorNode* gel_vector_node_own(GelVectorNode *node, guint level)
+{
+    if(g_atomic_int_get(&node->ref_count) == 1)
+        return node;
+
+    GelVectorNode *copy = g_slice_new0(GelVectorNode);
+    copy->ref_count = 1;
+    for(guint i = 0; i < GEL_VECTOR_WIDTH; i++)
+        if(node->children[i] != NULL)
+        {
+            /* leaves and nodes both start with their reference count */
+            g_atomic_int_inc((volatile gint *)node->children[i]);
+            copy->children[i] = node->children[i];
+        }
+
+    gel_vector_node_unref(node, level);
+    return copy;
+}
+
+
+static
+void gel_vector_value_replace(GValue *dest, const GValue *value)
+{
+    GValue tmp_value = {0};
+
+    /* value may be the one being replaced */
+    gel_value_copy(value, &tmp_value);
+    if(G_IS_VALUE(dest))
+        g_value_unset(dest);
+    *dest = tmp_value;
+}
+
+
+static
+GelVector* gel_vector_dup(const GelVector *self)
+{
+    GelVector *copy = g_slice_new0(GelVector);
+    copy->ref_count = 1;
+
+    if(self != NULL)
+    {
+        copy->size = self->size;
+        copy->shift = self->shift;
+        if(self->root != NULL)
+        {
+            copy->root = self->root;
+            g_atomic_int_inc(&copy->root->ref_count);
+        }
+        if(self->tail != NULL)
+        {
+            copy->tail = self->tail;
+            g_atomic_int_inc(&copy->tail->ref_count);
+        }
+    }
+
+    return copy;
+}
+
+
+GelVector* gel_vector_ref(GelVector *self)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+
+    g_atomic_int_inc(&self->ref_count);
+    return self;
+}
+
+
+void gel_vector_unref(GelVector *self)
+{
+    g_return_if_fail(self != NULL);
+
+    if(g_atomic_int_dec_and_test(&self->ref_count))
+    {
+        if(self->root != NULL)
+            gel_vector_node_unref(self->root, self->shift);
+        if(self->tail != NULL)
+            gel_vector_leaf_unref(self->tail);
+        g_slice_free(GelVector, self);
+    }
+}
+
+
+guint gel_vector_get_size(const GelVector *self)
+{
+    return self->size;
+}
+
+
+/* the index of the first value in the tail */
+static
+guint gel_vector_tail_offset(const GelVector *self)
+{
+    return self->size == 0 ? 0 : (self->size - 1) & ~GEL_VECTOR_MASK;
+}
+
+
+const GValue* gel_vector_get(const GelVector *self, guint index)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+    g_return_val_if_fail(index < self->size, NULL);
+
+    if(index >= gel_vector_tail_offset(self))
+        return self->tail->values + (index & GEL_VECTOR_MASK);
+
+    gpointer node = self->root;
+    for(guint level = self->shift; level > 0; level -= GEL_VECTOR_BITS)
+    {
+        GelVectorNode *parent = node;
+        node = parent->children[(index >> level) & GEL_VECTOR_MASK];
+    }
+
+    GelVectorLeaf *leaf = node;
+    return leaf->values + (index & GEL_VECTOR_MASK);
+}
+
+
+/* Builds the nodes from level down to leaf */
+static
+gpointer gel_vector_new_path(guint level, GelVectorLeaf *leaf)
+{
+    if(level == 0)
+        return leaf;
+
+    GelVectorNode *node = g_slice_new0(GelVectorNode);
+    node->ref_count = 1;
+    node->children[0] = gel_vector_new_path(level - GEL_VECTOR_BITS, leaf);
+
+    return node;
+}
+
+
+static
+GelVectorNode* gel_vector_push_path(GelVectorNode *node, guint level,
+                                    guint index, GelVectorLeaf *leaf)
+{
+    node = gel_vector_node_own(node, level);
+    guint slot = (index >> level) & GEL_VECTOR_MASK;
+
+    if(level == GEL_VECTOR_BITS)
+        node->children[slot] = leaf;
+    else
+    if(node->children[slot] == NULL)
+        node->children[slot] =
+            gel_vector_new_path(level - GEL_VECTOR_BITS, leaf);
+    else
+        node->children[slot] = gel_vector_push_path(node->children[slot],
+            level - GEL_VECTOR_BITS, index, leaf);
+
+    return node;
+}
+
+
+/* Moves the full tail of self, that must not be shared, into the trie */
+static
+void gel_vector_push_tail(GelVector *self)
+{
+    guint index = self->size - GEL_VECTOR_WIDTH;
+
+    if(self->root == NULL)
+    {
+        self->root = gel_vector_new_path(GEL_VECTOR_BITS, self->tail);
+        self->shift = GEL_VECTOR_BITS;
+    }
+    else
+    if((index >> self->shift) >= GEL_VECTOR_WIDTH)
+    {
+        GelVectorNode *root = g_slice_new0(GelVectorNode);
+        root->ref_count = 1;
+        root->children[0] = self->root;
+        root->children[1] = gel_vector_new_path(self->shift, self->tail);
+
+        self->root = root;
+        self->shift += GEL_VECTOR_BITS;
+    }
+    else
+        self->root = gel_vector_push_path(self->root,
+            self->shift, index, self->tail);
+
+    self->tail = NULL;
+}
+
+
+/* Appends value to self, that must not be shared */
+static
+void gel_vector_push(GelVector *self, const GValue *value)
+{
+    guint n_tail = self->size - gel_vector_tail_offset(self);
+
+    if(self->tail == NULL || n_tail == GEL_VECTOR_WIDTH)
+    {
+        if(self->tail != NULL)
+            gel_vector_push_tail(self);
+
+        self->tail = g_slice_new0(GelVectorLeaf);
+        self->tail->ref_count = 1;
+        n_tail = 0;
+    }
+    else
+        self->tail = gel_vector_leaf_own(self->tail);
+
+    gel_value_copy(value, self->tail->values + n_tail);
+    self->size++;
+}
+
+
+GelVector* gel_vector_new(guint n_values, const GValue *values)
+{
+    GelVector *self = gel_vector_dup(NULL);
+
+    for(guint i = 0; i < n_values; i++)
+        gel_vector_push(self, values + i);
+
+    return self;
+}
+
+
+GelVector* gel_vector_append(const GelVector *self,
+                             guint n_values, const GValue *values)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+
+    GelVector *result = gel_vector_dup(self);
+
+    for(guint i = 0; i < n_values; i++)
+        gel_vector_push(result, values + i);
+
+    return result;
+}
+
+
+GelVector* gel_vector_concat(const GelVector *self, const GelVector *other)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+    g_return_val_if_fail(other != NULL, NULL);
+
+    if(self->size == 0)
+        return gel_vector_dup(other);
+
+    GelVector *result = gel_vector_dup(self);
+
+    for(guint i = 0; i < other->size; i++)
+        gel_vector_push(result, gel_vector_get(other, i));
+
+    return result;
+}
+
+
+static
+GelVectorNode* gel_vector_set_path(GelVectorNode *node, guint level,
+                                   guint index, const GValue *value)
+{
+    node = gel_vector_node_own(node, level);
+    guint slot = (index >> level) & GEL_VECTOR_MASK;
+
+    if(level == GEL_VECTOR_BITS)
+    {
+        GelVectorLeaf *leaf = gel_vector_leaf_own(node->children[slot]);
+        gel_vector_value_replace(leaf->values + (index & GEL_VECTOR_MASK),
+            value);
+        node->children[slot] = leaf;
+    }
+    else
+        node->children[slot] = gel_vector_set_path(node->children[slot],
+            level - GEL_VECTOR_BITS, index, value);
+
+    return node;
+}
+
+
+GelVector* gel_vector_set(const GelVector *self,
+                          guint index, const GValue *value)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+    g_return_val_if_fail(index < self->size, NULL);
+
+    GelVector *result = gel_vector_dup(self);
+
+    if(index >= gel_vector_tail_offset(result))
+    {
+        result->tail = gel_vector_leaf_own(result->tail);
+        gel_vector_value_replace(
+            result->tail->values + (index & GEL_VECTOR_MASK), value);
+    }
+    else
+        result->root = gel_vector_set_path(result->root,
+            result->shift, index, value);
+
+    return result;
+}
+
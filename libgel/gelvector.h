@@ -0,0 +1,25 @@
+#ifndef __GEL_VECTOR_H__
+#define __GEL_VECTOR_H__
+
+#include <glib-object.h>
+
+#define GEL_TYPE_VECTOR (gel_vector_get_type())
+
+typedef struct _GelVector GelVector;
+GType gel_vector_get_type(void) G_GNUC_CONST;
+
+GelVector* gel_vector_new(guint n_values, const GValue *values);
+GelVector* gel_vector_ref(GelVector *self);
+void gel_vector_unref(GelVector *self);
+
+guint gel_vector_get_size(const GelVector *self);
+const GValue* gel_vector_get(const GelVector *self, guint index);
+
+GelVector* gel_vector_append(const GelVector *self,
+                             guint n_values, const GValue *values);
+GelVector* gel_vector_concat(const GelVector *self, const GelVector *other);
+GelVector* gel_vector_set(const GelVector *self,
+                          guint index, const GValue *value);
+
+#endif
+
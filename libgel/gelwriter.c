@@ -0,0 +1,446 @@
+#include <gelwriter.h>
+#include <gelvalue.h>
+#include <gelsymbol.h>
+#include <gelclosure.h>
+#include <geltypedarray.h>
+#include <geliterator.h>
+#include <gelhash.h>
+#include <gelvector.h>
+#include <geldict.h>
+#include <gelrope.h>
+#include <gelstringbuilder.h>
+
+
+/*
+ * A writer serializes values straight into a buffer, so a nested value is
+ * written without making a string for each of its elements. A writer made
+ * for a buffer leaves everything there, while one with a function owns its
+ * buffer and passes it to the function whenever it grows past
+ * GEL_WRITER_BUFFER_SIZE, and when it is flushed or cleared.
+ */
+#define GEL_WRITER_BUFFER_SIZE 4096
+
+
+/**
+ * SECTION:gelwriter
+ * @short_description: Writes values as text into a buffer or a sink
+ * @title: GelWriter
+ * @include: gel.h
+ *
+ * A #GelWriter serializes #GValue as #gel_value_to_string and
+ * #gel_value_repr do, but into a single buffer. A writer initialized with
+ * a #GelWriterFunc passes the buffer to it every 4 KiB, so long outputs
+ * can be sent to any channel without being kept whole in memory.
+ *
+ * #GelWriter structures are typically allocated on the stack and
+ * released with #gel_writer_clear.
+ */
+
+/**
+ * GelWriterFunc:
+ * @data: the text written, terminated by 0
+ * @length: the length of @data
+ * @user_data: the data given to #gel_writer_init
+ *
+ * Receives the text written to a #GelWriter, in pieces
+ */
+
+/**
+ * gel_writer_init:
+ * @self: a #GelWriter to initialize
+ * @func: the #GelWriterFunc that receives the text
+ * @user_data: data to pass to @func
+ *
+ * Initializes @self to pass what is written to @func
+ * every 4 KiB, and when it is flushed or cleared
+ */
+void gel_writer_init(GelWriter *self, GelWriterFunc func, gpointer user_data)
+{
+    g_return_if_fail(self != NULL);
+    g_return_if_fail(func != NULL);
+
+    self->buffer = g_string_sized_new(GEL_WRITER_BUFFER_SIZE);
+    self->func = func;
+    self->user_data = user_data;
+}
+
+
+/**
+ * gel_writer_init_buffer:
+ * @self: a #GelWriter to initialize
+ * @buffer: the #GString to write into
+ *
+ * Initializes @self to append what is written to @buffer,
+ * that is still owned by the caller
+ */
+void gel_writer_init_buffer(GelWriter *self, GString *buffer)
+{
+    g_return_if_fail(self != NULL);
+    g_return_if_fail(buffer != NULL);
+
+    self->buffer = buffer;
+    self->func = NULL;
+    self->user_data = NULL;
+}
+
+
+static
+void gel_writer_print(const gchar *data, gsize length, gpointer user_data)
+{
+    /* the buffer is always terminated */
+    g_print("%s", data);
+}
+
+
+static
+void gel_writer_free_buffer(GString *buffer)
+{
+    g_string_free(buffer, TRUE);
+}
+
+
+/*
+ * Print writers share one buffer per thread, so printing does not
+ * allocate one each time. A print nested in another one, while its
+ * arguments are evaluated, just writes after what the outer one wrote.
+ */
+static
+GPrivate writer_PRINT_BUFFER =
+    G_PRIVATE_INIT((GDestroyNotify)gel_writer_free_buffer);
+
+
+/**
+ * gel_writer_init_print:
+ * @self: a #GelWriter to initialize
+ *
+ * Initializes @self to pass what is written to #g_print.
+ * The writers for #g_print of a thread share their buffer.
+ */
+void gel_writer_init_print(GelWriter *self)
+{
+    g_return_if_fail(self != NULL);
+
+    GString *buffer = g_private_get(&writer_PRINT_BUFFER);
+    if(buffer == NULL)
+    {
+        buffer = g_string_sized_new(GEL_WRITER_BUFFER_SIZE);
+        g_private_set(&writer_PRINT_BUFFER, buffer);
+    }
+
+    self->buffer = buffer;
+    self->func = gel_writer_print;
+    self->user_data = NULL;
+}
+
+
+/**
+ * gel_writer_clear:
+ * @self: a #GelWriter
+ *
+ * Flushes @self and releases its buffer, unless it was given one
+ */
+void gel_writer_clear(GelWriter *self)
+{
+    g_return_if_fail(self != NULL);
+
+    if(self->func != NULL)
+    {
+        gel_writer_flush(self);
+        if(self->buffer != g_private_get(&writer_PRINT_BUFFER))
+            g_string_free(self->buffer, TRUE);
+    }
+
+    self->buffer = NULL;
+}
+
+
+/**
+ * gel_writer_flush:
+ * @self: a #GelWriter
+ *
+ * Passes what was written to @self and not passed yet to its #GelWriterFunc.
+ * Does nothing for a writer into a buffer.
+ */
+void gel_writer_flush(GelWriter *self)
+{
+    g_return_if_fail(self != NULL);
+
+    if(self->func != NULL && self->buffer->len > 0)
+    {
+        self->func(self->buffer->str, self->buffer->len, self->user_data);
+        g_string_truncate(self->buffer, 0);
+    }
+}
+
+
+static
+void gel_writer_check(GelWriter *self)
+{
+    if(self->func != NULL && self->buffer->len >= GEL_WRITER_BUFFER_SIZE)
+        gel_writer_flush(self);
+}
+
+
+/**
+ * gel_writer_write:
+ * @self: a #GelWriter
+ * @string: the text to write
+ * @length: the length of @string, or -1 if it is terminated by 0
+ *
+ * Writes @string to @self
+ */
+void gel_writer_write(GelWriter *self, const gchar *string, gssize length)
+{
+    g_return_if_fail(self != NULL);
+
+    if(string == NULL)
+        return;
+
+    if(length < 0)
+        g_string_append(self->buffer, string);
+    else
+        g_string_append_len(self->buffer, string, length);
+
+    gel_writer_check(self);
+}
+
+
+static
+void gel_writer_write_array(GelWriter *self, const GValue *value,
+                            gboolean repr)
+{
+    const GelArray *array = g_value_get_boxed(value);
+    const GValue *array_values = gel_array_get_values(array);
+    const guint n_values = gel_array_get_n_values(array);
+
+    g_string_append_c(self->buffer, '(');
+    for(guint i = 0; i < n_values; i++)
+    {
+        if(i > 0)
+            g_string_append_c(self->buffer, ' ');
+        gel_writer_write_value(self, array_values + i, repr);
+    }
+    g_string_append_c(self->buffer, ')');
+}
+
+
+static
+void gel_writer_write_typed_array(GelWriter *self, const GValue *value,
+                                  gboolean repr)
+{
+    const GelTypedArray *array = g_value_get_boxed(value);
+    const guint n_elements = gel_typed_array_get_n_elements(array);
+
+    g_string_append_c(self->buffer, '(');
+    g_string_append(self->buffer, gel_typed_array_get_kind_name(array));
+    for(guint i = 0; i < n_elements; i++)
+    {
+        GValue element = {0};
+        gel_typed_array_get(array, i, &element);
+
+        g_string_append_c(self->buffer, ' ');
+        gel_writer_write_value(self, &element, repr);
+        g_value_unset(&element);
+    }
+    g_string_append_c(self->buffer, ')');
+}
+
+
+static
+void gel_writer_write_vector(GelWriter *self, const GValue *value,
+                             gboolean repr)
+{
+    const GelVector *vector = g_value_get_boxed(value);
+    const guint size = gel_vector_get_size(vector);
+
+    g_string_append(self->buffer, "(vector");
+    for(guint i = 0; i < size; i++)
+    {
+        g_string_append_c(self->buffer, ' ');
+        gel_writer_write_value(self, gel_vector_get(vector, i), repr);
+    }
+    g_string_append_c(self->buffer, ')');
+}
+
+
+static
+void gel_writer_write_dict(GelWriter *self, const GValue *value,
+                           gboolean repr)
+{
+    GelDictIter iter;
+    const GValue *k;
+    const GValue *v;
+
+    g_string_append(self->buffer, "(dict");
+    gel_dict_iter_init(&iter, g_value_get_boxed(value));
+    while(gel_dict_iter_next(&iter, &k, &v))
+    {
+        g_string_append_c(self->buffer, ' ');
+        gel_writer_write_value(self, k, repr);
+        g_string_append_c(self->buffer, ' ');
+        gel_writer_write_value(self, v, repr);
+    }
+    g_string_append_c(self->buffer, ')');
+}
+
+
+static
+void gel_writer_write_hash(GelWriter *self, const GValue *value,
+                           gboolean repr)
+{
+    GelHashIter iter;
+    const GValue *k;
+    const GValue *v;
+    gboolean first = TRUE;
+
+    g_string_append_c(self->buffer, '{');
+    gel_hash_iter_init(&iter, g_value_get_boxed(value));
+    while(gel_hash_iter_next(&iter, &k, &v))
+    {
+        if(!first)
+            g_string_append_c(self->buffer, ' ');
+        gel_writer_write_value(self, k, repr);
+        g_string_append_c(self->buffer, ' ');
+        gel_writer_write_value(self, v, repr);
+        first = FALSE;
+    }
+    g_string_append_c(self->buffer, '}');
+}
+
+
+/* Writes values with no textual form, like <GObject 0x...> */
+static
+void gel_writer_write_opaque(GelWriter *self, const GValue *value)
+{
+    g_string_append_printf(self->buffer, "<%s", G_VALUE_TYPE_NAME(value));
+
+    if(g_value_fits_pointer(value))
+        g_string_append_printf(self->buffer,
+            " %p", g_value_peek_pointer(value));
+
+    g_string_append_c(self->buffer, '>');
+}
+
+
+/**
+ * gel_writer_write_value:
+ * @self: a #GelWriter
+ * @value: the #GValue to write
+ * @repr: whether to write it as #gel_value_repr does
+ *
+ * Writes @value to @self as #gel_value_to_string would make it,
+ * or like #gel_value_repr if @repr is #TRUE, quoting the strings
+ */
+void gel_writer_write_value(GelWriter *self, const GValue *value,
+                            gboolean repr)
+{
+    g_return_if_fail(self != NULL);
+
+    GString *buffer = self->buffer;
+
+    if(value == NULL)
+        g_string_append(buffer, "NULL");
+    else
+    if(!G_IS_VALUE(value))
+        g_string_append(buffer, "VOID");
+    else
+    if(G_VALUE_HOLDS(value, G_TYPE_STRING))
+    {
+        const gchar *string = g_value_get_string(value);
+
+        if(repr)
+            g_string_append_c(buffer, '"');
+        if(string != NULL)
+            g_string_append(buffer, string);
+        if(repr)
+            g_string_append_c(buffer, '"');
+    }
+    else
+    if(G_VALUE_HOLDS(value, GEL_TYPE_ROPE))
+    {
+        if(repr)
+            g_string_append_c(buffer, '"');
+        gel_rope_append_to(g_value_get_boxed(value), buffer);
+        if(repr)
+            g_string_append_c(buffer, '"');
+    }
+    else
+    if(G_VALUE_HOLDS(value, GEL_TYPE_STRING_BUILDER))
+    {
+        /* the builder may be the buffer being written */
+        const GelStringBuilder *builder = g_value_get_boxed(value);
+        g_string_append_len(buffer,
+            gel_string_builder_get_string(builder),
+            gel_string_builder_get_length(builder));
+    }
+    else
+    if(G_VALUE_HOLDS(value, G_TYPE_INT64))
+        g_string_append_printf(buffer,
+            "%" G_GINT64_FORMAT, g_value_get_int64(value));
+    else
+    if(G_VALUE_HOLDS(value, G_TYPE_BOOLEAN))
+        g_string_append(buffer, g_value_get_boolean(value) ? "TRUE" : "FALSE");
+    else
+    if(g_value_type_transformable(G_VALUE_TYPE(value), G_TYPE_STRING))
+    {
+        GValue string_value = {0};
+        g_value_init(&string_value, G_TYPE_STRING);
+        if(g_value_transform(value, &string_value)
+           && g_value_get_string(&string_value) != NULL)
+            g_string_append(buffer, g_value_get_string(&string_value));
+        else
+            gel_writer_write_opaque(self, value);
+        g_value_unset(&string_value);
+    }
+    else
+    if(G_VALUE_HOLDS(value, GEL_TYPE_ARRAY))
+        gel_writer_write_array(self, value, repr);
+    else
+    if(G_VALUE_HOLDS(value, GEL_TYPE_TYPED_ARRAY))
+        gel_writer_write_typed_array(self, value, repr);
+    else
+    if(G_VALUE_HOLDS(value, GEL_TYPE_VECTOR))
+        gel_writer_write_vector(self, value, repr);
+    else
+    if(G_VALUE_HOLDS(value, GEL_TYPE_DICT))
+        gel_writer_write_dict(self, value, repr);
+    else
+    if(G_VALUE_HOLDS(value, GEL_TYPE_HASH))
+        gel_writer_write_hash(self, value, repr);
+    else
+    if(G_VALUE_HOLDS(value, GEL_TYPE_ITERATOR))
+    {
+        gchar *s = gel_iterator_to_string(g_value_get_boxed(value));
+        g_string_append(buffer, s);
+        g_free(s);
+    }
+    else
+    if(G_VALUE_HOLDS(value, GEL_TYPE_SYMBOL))
+    {
+        const GelSymbol *symbol = g_value_get_boxed(value);
+        const GValue *symbol_value = gel_symbol_get_value(symbol);
+
+        if(symbol_value != NULL)
+            gel_writer_write_value(self, symbol_value, repr);
+        else
+            g_string_append(buffer, gel_symbol_get_name(symbol));
+    }
+    else
+    if(G_VALUE_HOLDS(value, G_TYPE_CLOSURE)
+       && gel_closure_get_name(g_value_get_boxed(value)) != NULL)
+        g_string_append(buffer,
+            gel_closure_get_name(g_value_get_boxed(value)));
+    else
+    if(G_VALUE_HOLDS(value, G_TYPE_GTYPE)
+       && g_type_name(g_value_get_gtype(value)) != NULL)
+        g_string_append(buffer, g_type_name(g_value_get_gtype(value)));
+    else
+    if(G_VALUE_HOLDS(value, G_TYPE_POINTER)
+       && g_value_peek_pointer(value) == NULL)
+        g_string_append(buffer, "NULL");
+    else
+        gel_writer_write_opaque(self, value);
+
+    gel_writer_check(self);
+}
+
@@ -0,0 +1,29 @@
+#ifndef __GEL_WRITER_H__
+#define __GEL_WRITER_H__
+
+#include <glib-object.h>
+
+typedef void (*GelWriterFunc)(const gchar *data, gsize length,
+                              gpointer user_data);
+
+typedef struct _GelWriter GelWriter;
+
+struct _GelWriter
+{
+    GString *buffer;
+    GelWriterFunc func;
+    gpointer user_data;
+};
+
+void gel_writer_init(GelWriter *self, GelWriterFunc func, gpointer user_data);
+void gel_writer_init_buffer(GelWriter *self, GString *buffer);
+void gel_writer_init_print(GelWriter *self);
+void gel_writer_clear(GelWriter *self);
+
+void gel_writer_write(GelWriter *self, const gchar *string, gssize length);
+void gel_writer_write_value(GelWriter *self, const GValue *value,
+                            gboolean repr);
+void gel_writer_flush(GelWriter *self);
+
+#endif
+
@@ -0,0 +1,33 @@
+#!/bin/sh
+# Runs the test $1 and compares what it prints with the file next to it
+# named like it, with the extension .expected. Gel scripts are run with
+# $GEL, and .data files are parsed as data with $PARSE_DATA. The test
+# runs in its own directory, so it is named the same way in its messages
+# wherever the tests are built.
+# .cached files are Gel scripts run twice with an empty GEL_CACHE_DIR:
+# once to write their cache and once to read it, both giving the output.
+
+unset GEL_CACHE_DIR
+dir=`dirname "$1"`
+file=`basename "$1"`
+case "$file" in
+    *.data)
+        name=`basename "$file" .data`
+        run="${PARSE_DATA:-parse-data}" ;;
+    *.cached)
+        name=`basename "$file" .cached`
+        run="${GEL:-gel}"
+        GEL_CACHE_DIR=`mktemp -d` || exit 99
+        export GEL_CACHE_DIR
+        trap 'rm -rf "$GEL_CACHE_DIR"' 0 ;;
+    *)
+        name=`basename "$file" .gel`
+        run="${GEL:-gel}" ;;
+esac
+
+cd "$dir" || exit 99
+"$run" "$file" 2>&1 | diff -u "$name.expected" - || exit 1
+if test -n "$GEL_CACHE_DIR"; then
+    ls "$GEL_CACHE_DIR"/*.gelc > /dev/null || exit 1
+    "$run" "$file" 2>&1 | diff -u "$name.expected" -
+fi
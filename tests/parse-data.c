@@ -0,0 +1,104 @@
+/*
+    Parses a file as data and prints what the parser finds in it:
+    first the calls made to the GelParserCallbacks, and then the values
+    given by gel_parser_next_data_value. Used by check-data.sh.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <gel.h>
+
+
+static gboolean print_start_array(GelParser *parser, gchar delim,
+                                  gpointer user_data, GError **error)
+{
+    guint *depth = user_data;
+    g_print("%*s%c\n", *depth * 2, "", delim);
+    (*depth)++;
+    return TRUE;
+}
+
+
+static gboolean print_end_array(GelParser *parser, gchar delim,
+                                gpointer user_data, GError **error)
+{
+    guint *depth = user_data;
+    (*depth)--;
+    g_print("%*s%c end\n", *depth * 2, "", delim);
+    return TRUE;
+}
+
+
+/* the symbol stop makes the callback stop the parsing */
+static gboolean print_atom(GelParser *parser, const GValue *value,
+                           gpointer user_data, GError **error)
+{
+    guint *depth = user_data;
+    gchar *value_repr = gel_value_repr(value);
+    g_print("%*s%s %s\n", *depth * 2, "", value_repr,
+            g_type_name(G_VALUE_TYPE(value)));
+    gboolean go_on = strcmp(value_repr, "stop") != 0;
+    g_free(value_repr);
+    return go_on;
+}
+
+
+static void print_error(const gchar *filename, GError **error)
+{
+    if(*error == NULL)
+        return;
+    g_print("Error parsing '%s'\n", filename);
+    g_print("%s\n", (*error)->message);
+    g_clear_error(error);
+}
+
+
+int main(int argc, char *argv[])
+{
+    g_type_init();
+    if(argc < 2)
+    {
+        gchar *program = argv[0];
+        g_print("%s: requires an argument\n", program);
+        return 1;
+    }
+
+    const gchar *filename = argv[1];
+    GelParser *parser = gel_parser_new();
+    GError *error = NULL;
+    if(!gel_parser_input_mapped_file(parser, filename, &error))
+    {
+        g_print("Error reading '%s'\n", filename);
+        g_print("%s\n", error->message);
+        g_error_free(error);
+        gel_parser_free(parser);
+        return 1;
+    }
+
+    static const GelParserCallbacks callbacks =
+    {
+        print_start_array,
+        print_end_array,
+        print_atom
+    };
+    guint depth = 0;
+    if(!gel_parser_parse_data(parser, &callbacks, &depth, &error))
+    {
+        g_print("stopped\n");
+        print_error(filename, &error);
+    }
+
+    gel_parser_input_mapped_file(parser, filename, NULL);
+    GValue value = {0};
+    while(gel_parser_next_data_value(parser, &value, &error))
+    {
+        gchar *value_repr = gel_value_repr(&value);
+        g_print("= %s\n", value_repr);
+        g_free(value_repr);
+        g_value_unset(&value);
+    }
+    print_error(filename, &error);
+
+    gel_parser_free(parser);
+    return 0;
+}